@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+#if __unix__ || __linux__ || __APPLE__
+#include <sys/mman.h>
+#endif
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+
+// memory for engines that create and drop many equal-sized objects (tiles,
+// nodes): large chunks mapped with huge pages where the system allows it,
+// carved up by a bump pointer and given back all at once
+namespace mem {
+
+constexpr size_t huge_page_size = size_t(2) << 20;
+
+// a mapping of whole huge pages; hugetlb when reserved pages are available,
+// otherwise regular pages with transparent huge pages requested
+struct Chunk {
+  uint8_t *ptr = nullptr;
+  size_t size = 0;
+  bool hugetlb = false;
+
+  static Chunk map(size_t size) {
+    Chunk c;
+    c.size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+#if __unix__ || __linux__ || __APPLE__
+    void *p = MAP_FAILED;
+  #ifdef MAP_HUGETLB
+    p = mmap(nullptr, c.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    c.hugetlb = (p != MAP_FAILED);
+  #endif
+    if(p == MAP_FAILED) {
+      p = mmap(nullptr, c.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(p == MAP_FAILED) {
+        TERMINATE("unable to map %lu bytes\n", c.size);
+      }
+  #ifdef MADV_HUGEPAGE
+      madvise(p, c.size, MADV_HUGEPAGE);
+  #endif
+    }
+    c.ptr = (uint8_t *)p;
+#else
+    c.ptr = (uint8_t *)::operator new(c.size, std::align_val_t(huge_page_size));
+#endif
+    return c;
+  }
+
+  void unmap() {
+    if(ptr == nullptr) {
+      return;
+    }
+#if __unix__ || __linux__ || __APPLE__
+    munmap(ptr, size);
+#else
+    ::operator delete(ptr, std::align_val_t(huge_page_size));
+#endif
+    ptr = nullptr, size = 0;
+  }
+};
+
+// bump allocator over chunks; nothing is freed individually, reset() rewinds
+// everything and keeps the mappings for reuse
+class Arena {
+  std::vector<Chunk> chunks;
+  size_t current = 0, offset = 0;
+public:
+  static constexpr size_t chunk_size = size_t(8) << 20;
+
+  Arena()
+  {}
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  Arena(Arena &&other) noexcept:
+    chunks(std::move(other.chunks)),
+    current(other.current), offset(other.offset)
+  {
+    other.chunks.clear();
+    other.current = other.offset = 0;
+  }
+
+  void *allocate(size_t size, size_t align=64) {
+    ASSERT(size <= chunk_size);
+    while(true) {
+      if(current == chunks.size()) {
+        chunks.push_back(Chunk::map(chunk_size));
+        static std::atomic_flag logged = ATOMIC_FLAG_INIT;
+        if(!logged.test_and_set()) {
+          Logger::Info("[arena] chunks of %lu MiB, %s pages\n", chunk_size >> 20, chunks.back().hugetlb ? "hugetlb" : "transparent huge");
+        }
+      }
+      const size_t start = (offset + align - 1) / align * align;
+      if(start + size <= chunks[current].size) {
+        offset = start + size;
+        return chunks[current].ptr + start;
+      }
+      ++current, offset = 0;
+    }
+  }
+
+  void reset() {
+    current = 0, offset = 0;
+  }
+
+  size_t reserved() const {
+    size_t total = 0;
+    for(const Chunk &c : chunks) {
+      total += c.size;
+    }
+    return total;
+  }
+
+  void release() {
+    for(Chunk &c : chunks) {
+      c.unmap();
+    }
+    chunks.clear();
+    reset();
+  }
+
+  ~Arena() {
+    release();
+  }
+};
+
+// fixed-size slots carved from an arena, recycled through a free stack
+template <typename T>
+class SlabPool {
+  static_assert(std::is_trivially_destructible_v<T>, "slots are dropped without destructors");
+  Arena arena;
+public:
+  std::vector<T *> free;
+
+  SlabPool()
+  {}
+
+  SlabPool(SlabPool &&other) noexcept = default;
+
+  T *allocate() {
+    if(!free.empty()) {
+      T *p = free.back();
+      free.pop_back();
+      return p;
+    }
+    return new (arena.allocate(sizeof(T), std::max<size_t>(alignof(T), 64))) T;
+  }
+
+  void release(T *p) {
+    free.push_back(p);
+  }
+
+  // drops every slot at once
+  void reset() {
+    free.clear();
+    arena.reset();
+  }
+
+  size_t reserved() const {
+    return arena.reserved();
+  }
+};
+
+// one pool per thread, so that allocation in parallel loops takes no lock.
+// slots are interchangeable, so a slot may be released to any thread's pool;
+// rebalance() evens out the free stacks after a serial phase
+template <typename T>
+struct ThreadPools {
+  std::vector<SlabPool<T>> pools;
+
+  explicit ThreadPools(int no_threads=1):
+    pools(std::max(no_threads, 1))
+  {}
+
+  SlabPool<T> &get(int thread) {
+    return pools[thread % pools.size()];
+  }
+
+  void rebalance() {
+    size_t total = 0;
+    for(const auto &pool : pools) {
+      total += pool.free.size();
+    }
+    const size_t share = total / pools.size();
+    std::vector<T *> spare;
+    for(auto &pool : pools) {
+      while(pool.free.size() > share) {
+        spare.push_back(pool.free.back());
+        pool.free.pop_back();
+      }
+    }
+    for(auto &pool : pools) {
+      while(pool.free.size() < share && !spare.empty()) {
+        pool.free.push_back(spare.back());
+        spare.pop_back();
+      }
+    }
+    pools.front().free.insert(pools.front().free.end(), spare.begin(), spare.end());
+  }
+
+  void reset() {
+    for(auto &pool : pools) {
+      pool.reset();
+    }
+  }
+
+  size_t reserved() const {
+    size_t total = 0;
+    for(const auto &pool : pools) {
+      total += pool.reserved();
+    }
+    return total;
+  }
+};
+
+// leaves elements default-initialized on resize, so that a vector of bytes is
+// allocated without being written; pages are then placed by whoever writes first
+template <typename T>
+struct uninitialized_allocator : std::allocator<T> {
+  template <typename U>
+  struct rebind {
+    using other = uninitialized_allocator<U>;
+  };
+
+  uninitialized_allocator() = default;
+
+  template <typename U>
+  uninitialized_allocator(const uninitialized_allocator<U> &) noexcept
+  {}
+
+  template <typename U>
+  void construct(U *p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    ::new ((void *)p) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U *p, Args &&...args) {
+    ::new ((void *)p) U(std::forward<Args>(args)...);
+  }
+};
+
+} // namespace mem
@@ -1,6 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+
+#include <Arena.hpp>
+#include <Threads.hpp>
 
 namespace {
   enum update_mode : int { ALL, CURSOR };
@@ -9,6 +15,10 @@ namespace {
 #include <Linear.hpp>
 #include <Cellular.hpp>
 #include <Probabilistic.hpp>
+#include <Continuous.hpp>
+#include <Volume.hpp>
+#include <Margolus.hpp>
+#include <RuleTable.hpp>
 
 
 // grid: a macro-topology of the automaton.
@@ -57,6 +67,14 @@ enum storage_mode {
   TEXTURES,
   // on the host, as a 1D buffer
   HOSTBUFFER,
+  // on the host, as tiles of an unbounded plane
+  SPARSE,
+  // on the host, as floats
+  CONTINUOUS,
+  // three-dimensional, on the host or in device buffers
+  VOLUME,
+  // 2x2 blocks of a margolus partition, on the host or as a texture
+  BLOCKS,
   NO_STORAGE_MODES
 };
 
@@ -71,16 +89,27 @@ struct Storage<4, storage_mode::HOSTBUFFER, T> {
 
   static constexpr int dim = 4;
   using value_type = T;
-  std::vector<value_type> buffer;
+  std::vector<value_type, mem::uninitialized_allocator<value_type>> buffer;
 
   Storage()
   {}
 
-  // create 1d buffer
+  // create 1d buffer, zeroed by first_touch()
   void init(int ww, int hh) {
     w=ww,h=hh;
-    buffer.resize(w*h);
+    buffer.clear();
     buffer.shrink_to_fit();
+    buffer.resize(w*h);
+    first_touch();
+  }
+
+  // zeroes the rows in the static schedule of the row loops that update them,
+  // so that on numa machines each page lands on the node of its thread
+  void first_touch() {
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < h; ++y) {
+      std::fill_n(&buffer[size_t(y) * w], w, value_type(0));
+    }
   }
 
   value_type *data() {
@@ -104,6 +133,296 @@ struct Storage<4, storage_mode::HOSTBUFFER, T> {
   {}
 };
 
+// a plane of two states, 64 cells to a word along the rows: cell x of a row is
+// bit x % 64 of its word x / 64. the width is rounded up to whole words
+template <>
+struct Storage<4, storage_mode::HOSTBUFFER, bool> {
+  using word_type = uint64_t;
+  static constexpr int word_bits = 64;
+  int w=0, h=0;
+  // words per row
+  int nw=0;
+
+  static constexpr int dim = 4;
+  using value_type = bool;
+  std::vector<word_type, mem::uninitialized_allocator<word_type>> buffer;
+
+  Storage()
+  {}
+
+  void init(int ww, int hh) {
+    nw=(ww + word_bits - 1) / word_bits;
+    w=nw * word_bits,h=hh;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    buffer.resize(size_t(nw) * h);
+    first_touch();
+  }
+
+  void first_touch() {
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < h; ++y) {
+      std::fill_n(&buffer[size_t(y) * nw], nw, word_type(0));
+    }
+  }
+
+  word_type *row(int y) {
+    return &buffer[size_t(y) * nw];
+  }
+
+  const word_type *row(int y) const {
+    return &buffer[size_t(y) * nw];
+  }
+
+  word_type *data() {
+    return buffer.data();
+  }
+
+  void clear() {
+    buffer.clear();
+  }
+
+  bool empty() {
+    return buffer.empty();
+  }
+};
+
+// a volume of w * h * d cells, row by row and plane by plane
+template <typename T>
+struct Storage<3, storage_mode::HOSTBUFFER, T> {
+  int w=0, h=0, d=0;
+
+  static constexpr int dim = 3;
+  using value_type = T;
+  std::vector<value_type, mem::uninitialized_allocator<value_type>> buffer;
+
+  Storage()
+  {}
+
+  void init(int ww, int hh, int dd) {
+    w=ww,h=hh,d=dd;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    buffer.resize(size_t(w) * h * d);
+    first_touch();
+  }
+
+  // as for the plane, in the static schedule of the row loops
+  void first_touch() {
+    #pragma omp parallel for schedule(static)
+    for(int r = 0; r < d * h; ++r) {
+      std::fill_n(&buffer[size_t(r) * w], w, value_type(0));
+    }
+  }
+
+  value_type *row(int z, int y) {
+    return &buffer[(size_t(z) * h + y) * w];
+  }
+
+  const value_type *row(int z, int y) const {
+    return &buffer[(size_t(z) * h + y) * w];
+  }
+
+  value_type *data() {
+    return buffer.data();
+  }
+
+  void clear() {
+    buffer.clear();
+  }
+
+  bool empty() {
+    return buffer.empty();
+  }
+};
+
+// a volume of two states, 64 cells to a word along the rows: cell x of a row is
+// bit x % 64 of its word x / 64. the width is rounded up to whole words
+template <>
+struct Storage<3, storage_mode::HOSTBUFFER, bool> {
+  using word_type = uint64_t;
+  static constexpr int word_bits = 64;
+  int w=0, h=0, d=0;
+  // words per row
+  int nw=0;
+
+  static constexpr int dim = 3;
+  using value_type = bool;
+  std::vector<word_type, mem::uninitialized_allocator<word_type>> buffer;
+
+  Storage()
+  {}
+
+  void init(int ww, int hh, int dd) {
+    nw=(ww + word_bits - 1) / word_bits;
+    w=nw * word_bits,h=hh,d=dd;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    buffer.resize(size_t(nw) * h * d);
+    first_touch();
+  }
+
+  void first_touch() {
+    #pragma omp parallel for schedule(static)
+    for(int r = 0; r < d * h; ++r) {
+      std::fill_n(&buffer[size_t(r) * nw], nw, word_type(0));
+    }
+  }
+
+  word_type *row(int z, int y) {
+    return &buffer[(size_t(z) * h + y) * nw];
+  }
+
+  const word_type *row(int z, int y) const {
+    return &buffer[(size_t(z) * h + y) * nw];
+  }
+
+  bool get(int z, int y, int x) const {
+    return (row(z, y)[x / word_bits] >> (x % word_bits)) & 1;
+  }
+
+  void set(int z, int y, int x, bool v) {
+    word_type &word = row(z, y)[x / word_bits];
+    const word_type bit = word_type(1) << (x % word_bits);
+    word = v ? (word | bit) : (word & ~bit);
+  }
+
+  word_type *data() {
+    return buffer.data();
+  }
+
+  void clear() {
+    buffer.clear();
+  }
+
+  bool empty() {
+    return buffer.empty();
+  }
+};
+
+// unbounded plane as a hash map of square tiles, allocated on demand and
+// dropped once empty, so that memory follows the population rather than
+// the bounding box. tiles come from per-thread slab pools, so that workers
+// can allocate without a lock, and are all given back at once by clear()
+template <typename T>
+struct Storage<4, storage_mode::SPARSE, T> {
+  static constexpr int dim = 4;
+  static constexpr int tile_bits = 6;
+  static constexpr int tile_size = 1 << tile_bits;
+  static constexpr int tile_mask = tile_size - 1;
+  using value_type = T;
+
+  struct Tile {
+    value_type cells[tile_size * tile_size];
+  };
+
+  std::unordered_map<uint64_t, Tile *> tiles;
+  mem::ThreadPools<Tile> pools;
+
+  Storage():
+    pools(sys::get_max_threads())
+  {}
+
+  static uint64_t key(int ty, int tx) {
+    return (uint64_t(uint32_t(ty)) << 32) | uint32_t(tx);
+  }
+
+  static int key_y(uint64_t k) {
+    return int32_t(k >> 32);
+  }
+
+  static int key_x(uint64_t k) {
+    return int32_t(k & 0xffffffffULL);
+  }
+
+  const Tile *find(int ty, int tx) const {
+    const auto found = tiles.find(key(ty, tx));
+    return (found == tiles.end()) ? nullptr : found->second;
+  }
+
+  // zeroed unless the caller overwrites every cell anyway.
+  // each thread of a parallel region passes its own number
+  Tile *allocate(bool zero=true, int thread=0) {
+    Tile *tile = pools.get(thread).allocate();
+    if(zero) {
+      std::fill_n(tile->cells, tile_size * tile_size, value_type(0));
+    }
+    return tile;
+  }
+
+  void release(Tile *tile, int thread=0) {
+    pools.get(thread).release(tile);
+  }
+
+  // coordinates may be negative: the shifts round towards minus infinity
+  value_type get(int y, int x) const {
+    const Tile *tile = find(y >> tile_bits, x >> tile_bits);
+    return (tile == nullptr) ? value_type(0) : tile->cells[(y & tile_mask) * tile_size + (x & tile_mask)];
+  }
+
+  void set(int y, int x, value_type v) {
+    const uint64_t k = key(y >> tile_bits, x >> tile_bits);
+    auto found = tiles.find(k);
+    if(found == tiles.end()) {
+      if(v == 0) {
+        return;
+      }
+      found = tiles.emplace(k, allocate()).first;
+    }
+    found->second->cells[(y & tile_mask) * tile_size + (x & tile_mask)] = v;
+  }
+
+  size_t size() const {
+    return tiles.size();
+  }
+
+  // keeps the arenas mapped for the next pattern
+  void clear() {
+    tiles.clear();
+    pools.reset();
+  }
+};
+
+// automata that can update the interior of a row from raw row pointers
+template <typename AUT>
+concept has_row_kernel = requires(const AUT &aut, const uint8_t *row, uint8_t *dst) {
+  aut.next_row(row, row, row, dst, 0, 0);
+};
+
+// automata counting live cells over a box of any range around a cell
+template <typename AUT>
+concept has_range_kernel = requires(const AUT &aut) {
+  aut.get_range();
+  aut.counts_middle();
+  aut.transition(0, 0);
+};
+
+// automata compiled from a rule table
+template <typename AUT>
+concept has_rule_table = requires(const AUT &aut) {
+  aut.get_table();
+};
+
+// automata of states in [0, 1], stepped from convolutions with their kernels
+template <typename AUT>
+concept continuous_automaton = requires(const AUT &aut, const float *sums) {
+  aut.kernels();
+  aut.next(0.f, sums);
+};
+
+// three-dimensional automata, stepped as volumes
+template <typename AUT>
+concept volume_automaton = AUT::dim == 3 && requires(const AUT &aut) {
+  aut.get_volume();
+};
+
+// block rules of the margolus neighbourhood
+template <typename AUT>
+concept block_automaton = requires(const AUT &aut) {
+  aut.get_block();
+  aut.table(0);
+};
+
 // ways to access the storage (differential topology)
 // sometimes this is cleaner than using macro-topology
 enum access_mode {
@@ -130,6 +449,16 @@ struct Access<AUT, Storage<4, storage_mode::HOSTBUFFER, T>, access_mode::bounded
   }
 };
 
+// the plane has no edges, so both access modes read the same
+template <typename AUT, typename T, access_mode AccessMode>
+struct Access<AUT, Storage<4, storage_mode::SPARSE, T>, AccessMode> {
+  using StorageT = Storage<4, storage_mode::SPARSE, T>;
+
+  static typename StorageT::value_type access(const StorageT &s, int y, int x) {
+    return s.get(y, x);
+  }
+};
+
 template <typename AUT, typename T>
 struct Access<AUT, Storage<4, storage_mode::HOSTBUFFER, T>, access_mode::looped> {
   using StorageT = Storage<4, storage_mode::HOSTBUFFER, T>;
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include <Window.hpp>
 #include <Renderer.hpp>
+#include <FrameExporter.hpp>
+#include <Profiler.hpp>
+#include <ProfilerOverlay.hpp>
+#include <History.hpp>
 
 
 class AutomatonApp;
@@ -15,11 +21,52 @@ template <typename AUT> struct use_storage_mode {
   static constexpr storage_mode smode = storage_mode::HOSTBUFFER;
 };
 
+template <typename N>
+struct use_storage_mode<ca::BSC<N>> {
+  static constexpr storage_mode smode = storage_mode::TEXTURES;
+};
+
+template <uint16_t BMask, uint16_t SMask, int C, typename N>
+struct use_storage_mode<ca::StaticBSC<BMask, SMask, C, N>> {
+  static constexpr storage_mode smode = storage_mode::TEXTURES;
+};
+
 template <>
-struct use_storage_mode<ca::BSC> {
+struct use_storage_mode<ca::LtL> {
   static constexpr storage_mode smode = storage_mode::TEXTURES;
 };
 
+template <>
+struct use_storage_mode<ruletable::Rule> {
+  static constexpr storage_mode smode = storage_mode::TEXTURES;
+};
+
+// continuous states live on the host only, whatever else is asked for
+template <typename AUT> requires continuous_automaton<AUT>
+struct use_storage_mode<AUT> {
+  static constexpr storage_mode smode = storage_mode::CONTINUOUS;
+};
+
+template <typename AUT> requires volume_automaton<AUT>
+struct use_storage_mode<AUT> {
+  static constexpr storage_mode smode = storage_mode::VOLUME;
+};
+
+template <typename AUT> requires block_automaton<AUT>
+struct use_storage_mode<AUT> {
+  static constexpr storage_mode smode = storage_mode::BLOCKS;
+};
+
+// two-dimensional outer-totalistic rules can run on the unbounded sparse plane
+template <typename AUT>
+concept supports_sparse = AUT::update_mode == ::update_mode::ALL && requires(const AUT &aut) {
+  aut.get_rule();
+};
+
+constexpr const char *storage_mode_names[] = {
+  "textures", "host", "sparse", "continuous", "volume", "blocks"
+};
+
 } // namespace
 
 
@@ -40,7 +87,23 @@ public:
     AutomatonApp &app = (*this);
     w.update_size();
     constexpr storage_mode storage_mode_recommended = ::use_storage_mode<AUT>::smode;
-    if constexpr(storage_mode_recommended == storage_mode::HOSTBUFFER) {
+    if constexpr(::supports_sparse<std::decay_t<AUT>>) {
+      if(opts.sparse) {
+        // B0 rules would fill the whole plane in one generation
+        if(!(aut.get_rule().birth & 1)) {
+          run_with_storage_mode<storage_mode::SPARSE>(std::forward<AUT>(aut), opts);
+          return;
+        }
+        Logger::Warning("rules with B0 cannot run on the unbounded plane\n");
+      }
+    }
+    if constexpr(storage_mode_recommended == storage_mode::CONTINUOUS) {
+      run_with_storage_mode<storage_mode::CONTINUOUS>(std::forward<AUT>(aut), opts);
+    } else if constexpr(storage_mode_recommended == storage_mode::VOLUME) {
+      run_with_storage_mode<storage_mode::VOLUME>(std::forward<AUT>(aut), opts);
+    } else if constexpr(storage_mode_recommended == storage_mode::BLOCKS) {
+      run_with_storage_mode<storage_mode::BLOCKS>(std::forward<AUT>(aut), opts);
+    } else if constexpr(storage_mode_recommended == storage_mode::HOSTBUFFER) {
       run_with_storage_mode<storage_mode::HOSTBUFFER>(std::forward<AUT>(aut), opts);
     } else {
       if(app.w.gl_support_compute_shaders && !opts.force_cpu) {
@@ -58,27 +121,251 @@ void AutomatonApp::run_with_storage_mode(AUT &&aut, const AutOptions &opts) {
   app.w.update_size();
   Logger::Info("automaton app\n");
   Renderer<AUT, StorageMode, access_mode::looped> automaton(aut, app.dir);
-  Logger::Info("using storage mode %s\n", (automaton.get_storage_mode() == storage_mode::HOSTBUFFER) ? "host" : "textures");
+  Logger::Info("using storage mode %s\n", ::storage_mode_names[automaton.get_storage_mode()]);
+  if constexpr(StorageMode == storage_mode::VOLUME) {
+    automaton.size = glm::ivec3(opts.volume_w, opts.volume_h, opts.volume_d);
+    automaton.use_gpu = app.w.gl_support_compute_shaders && !opts.force_cpu;
+  } else if constexpr(StorageMode == storage_mode::BLOCKS) {
+    automaton.use_gpu = app.w.gl_support_compute_shaders && !opts.force_cpu;
+  }
+  automaton.detector.reset(opts.max_period);
+  bool periodic = false;
+  automaton.track_histogram = opts.headless || opts.show_stats || !opts.population_path.empty();
+  FILE *population_file = nullptr;
+  if(!opts.population_path.empty()) {
+    population_file = fopen(opts.population_path.c_str(), "w");
+    if(population_file == nullptr) {
+      Logger::Warning("unable to write population '%s'\n", opts.population_path.c_str());
+    }
+  }
+  size_t histogram_generation = SIZE_MAX;
+
+  std::unique_ptr<FrameExporter> exporter;
+  if(!opts.export_path.empty()) {
+    exporter.reset(new FrameExporter(opts.export_path, aut.no_states, opts.export_every, opts.export_queue));
+  }
+  size_t generation = 0;
+
+  prof::Profiler &profiler = prof::Profiler::get();
+  if(opts.show_stats || !opts.trace_path.empty()) {
+    profiler.enable(opts.trace_path);
+  }
+  // past generations to step back to, in the window only
+  history::Store history;
+  const bool record_history = !opts.headless && opts.history_mb > 0
+    && automaton.get_storage_mode() != storage_mode::SPARSE && automaton.get_storage_mode() != storage_mode::CONTINUOUS
+    && automaton.get_storage_mode() != storage_mode::VOLUME;
+  if(!opts.headless && opts.history_mb > 0 && !record_history) {
+    // frames of continuous states are quantized, and could not be stepped on from exactly;
+    // those of volumes are only what the window shows
+    Logger::Warning("history is not recorded on the unbounded plane, of continuous states or of volumes\n");
+  }
+  std::vector<uint8_t> history_frame;
+  bool paused = false;
+
+  ProfilerOverlay overlay(app.dir);
+  // the history panel is toggled with H, and starts shown only along with the timings
+  const bool show_overlay = (opts.show_stats || record_history) && !opts.headless;
+  overlay.show_timing = opts.show_stats;
+  bool show_history = opts.show_stats;
+
+  auto &&setup = [&](auto &w) mutable -> void {
+    Logger::Info("init\n");
+    automaton.init_renderer(w, opts.factor);
+    if(record_history) {
+      history.reset(automaton.w, automaton.h, opts.history_mb << 20);
+      // at least a couple of keyframes must fit
+      if(size_t(automaton.w) * automaton.h * 2 > history.budget) {
+        Logger::Warning("history of %lu MiB is too small for a %dx%d grid\n", opts.history_mb, automaton.w, automaton.h);
+        history.reset(automaton.w, automaton.h, 0);
+      } else {
+        Logger::Info("history of %lu MiB, a keyframe every %d frames\n", opts.history_mb, history.keyframe_interval);
+      }
+    }
+    if(show_overlay) {
+      overlay.init(w);
+    }
+    Logger::Info("init fin\n");
+  };
+  // the textures renderer learns the hash a few generations late, so the repeat is reported as found
+  auto &&check_period = [&]() mutable -> void {
+    const period::Detector &detector = automaton.detector;
+    if(detector.is_periodic() && !periodic) {
+      Logger::Info("generation %lu repeats generation %lu: period %d\n", detector.since + detector.period, detector.since, detector.period);
+      char s[128];
+      snprintf(s, sizeof(s), "period %d since generation %lu", detector.period, detector.since);
+      overlay.status = s;
+    } else if(!detector.is_periodic() && periodic) {
+      overlay.status = "";
+    }
+    periodic = detector.is_periodic();
+  };
+  // the counts arrive a generation late from the gpu; every generation is reported once
+  auto &&check_histogram = [&]() mutable -> void {
+    if(!automaton.track_histogram || automaton.histogram.empty() || automaton.histogram_generation == histogram_generation) {
+      return;
+    }
+    histogram_generation = automaton.histogram_generation;
+    if(population_file != nullptr) {
+      fprintf(population_file, "%lu", histogram_generation);
+      for(uint64_t n : automaton.histogram) {
+        fprintf(population_file, "\t%lu", n);
+      }
+      fprintf(population_file, "\n");
+    }
+    if(show_overlay) {
+      char s[128];
+      snprintf(s, sizeof(s), "generation %lu: %lu live", histogram_generation, automaton.live_cells());
+      overlay.population = s;
+    }
+  };
+  auto &&step = [&]() mutable -> void {
+    profiler.poll_gpu();
+    // stepping on from a rewound generation forks a new future
+    if(!history.empty() && automaton.get_frame_generation() < history.last()) {
+      history.truncate(automaton.get_frame_generation());
+    }
+    // a blocked sweep must not run past the end of a headless run
+    automaton.generations_per_update = opts.temporal_block;
+    if(opts.headless) {
+      automaton.generations_per_update = int(std::min<size_t>(opts.temporal_block, opts.generations - generation));
+    }
+    const size_t before = automaton.generation;
+    automaton.update_state();
+    check_period();
+    check_histogram();
+    generation += automaton.generation - before;
+    if(exporter) {
+      exporter->push(generation, automaton.w, automaton.h, [&](std::vector<uint8_t> &frame) mutable -> void {
+        automaton.read_frame(frame);
+      });
+    }
+  };
+  auto &&record = [&]() mutable -> void {
+    if(!history.enabled()) {
+      return;
+    }
+    automaton.read_frame(history_frame);
+    history.push(automaton.get_frame_generation(), history_frame);
+  };
+  // shows a recorded generation, from which stepping goes on
+  auto &&seek = [&](size_t to) mutable -> void {
+    if(history.empty()) {
+      return;
+    }
+    const size_t found = history.seek(to, history_frame);
+    if(!automaton.write_frame(history_frame, found)) {
+      return;
+    }
+    generation = automaton.generation;
+    check_period();
+    check_histogram();
+  };
+  // keys and overlay widgets: space pauses, left and right step, home and end jump to either end
+  auto &&control_history = [&](Window &w) mutable -> void {
+    ProfilerOverlay::HistoryControls &hc = overlay.history;
+    int step_by = hc.step;
+    bool toggle_pause = hc.toggle_pause;
+    bool seek_to = hc.seek;
+    size_t to = hc.seek_to;
+    for(const int key : w.keys) {
+      switch(key) {
+        case GLFW_KEY_SPACE: toggle_pause = !toggle_pause; break;
+        case GLFW_KEY_LEFT:  step_by = -1; break;
+        case GLFW_KEY_RIGHT: step_by = 1; break;
+        case GLFW_KEY_HOME:  if(!history.empty()) seek_to = true, to = history.first(); break;
+        case GLFW_KEY_END:   if(!history.empty()) seek_to = true, to = history.last(); break;
+        case GLFW_KEY_H:     show_history = !show_history; break;
+      }
+    }
+    w.keys.clear();
+    hc.step = 0, hc.toggle_pause = hc.seek = false;
+    if(toggle_pause) {
+      paused = !paused;
+    }
+    const size_t current = automaton.get_frame_generation();
+    if(step_by != 0 || seek_to) {
+      paused = true;
+    }
+    if(seek_to) {
+      seek(to);
+    } else if(step_by < 0 && !history.empty() && current > history.first()) {
+      seek(history.before(current));
+    } else if(step_by > 0) {
+      if(!history.empty() && current < history.last()) {
+        seek(history.after(current));
+      } else {
+        step();
+        record();
+      }
+    }
+    hc.enabled = show_history;
+    hc.paused = paused;
+    hc.current = automaton.get_frame_generation();
+    hc.first = history.empty() ? hc.current : history.first();
+    hc.last = history.empty() ? hc.current : history.last();
+    hc.no_frames = history.size();
+    hc.bytes = history.bytes();
+  };
+  auto &&cleanup = [&](auto &w) mutable -> void {
+    Logger::Info("clear\n");
+    if(show_overlay) {
+      overlay.clear();
+    }
+    automaton.flush_histogram();
+    check_histogram();
+    if(opts.headless && !automaton.histogram.empty()) {
+      // summary line for rule sweeps
+      const size_t no_cells = automaton.get_no_cells();
+      Logger::Info("generation %lu: population %lu of %lu\n", automaton.histogram_generation, automaton.live_cells(), no_cells);
+    }
+    if(population_file != nullptr) {
+      fclose(population_file);
+    }
+    profiler.clear_gpu();
+    automaton.clear();
+    profiler.log_summary();
+    profiler.dump_trace();
+  };
+
+  if(opts.headless) {
+    app.w.run_headless(setup,
+      [&](auto &w) mutable -> bool {
+        step();
+        return generation < opts.generations && !(opts.stop_periodic && periodic);
+      },
+      cleanup
+    );
+    return;
+  }
 
   bool w_ret = app.w.run(
     // setup function
-    [&](auto &w) mutable -> void {
-      Logger::Info("init\n");
-      automaton.init_renderer(w, opts.factor);
-      Logger::Info("init fin\n");
-    },
+    setup,
     // display function
     [&](auto &w) mutable -> bool {
-      automaton.update_state();
+      if(record_history) {
+        control_history(w);
+      } else {
+        for(const int key : w.keys) {
+          automaton.on_key(key);
+        }
+        w.keys.clear();
+      }
+      // once periodic, --stop-periodic freezes the grid but keeps the window up
+      if(!paused && !(opts.stop_periodic && periodic)) {
+        step();
+        record();
+      }
 //      constexpr int ms = 1e4;
 //      usleep(50*ms);
       automaton.render(0);
+      if(show_overlay && (overlay.show_timing || overlay.history.enabled)) {
+        overlay.draw(w);
+      }
       return true;
     },
     // cleanup function
-    [&](auto &w) mutable -> void {
-      Logger::Info("clear\n");
-      automaton.clear();
-    }
+    cleanup
   );
 }
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <File.hpp>
+
+#include <ShaderProgram.hpp>
+#include <ShaderUniform.hpp>
+#include <StorageBuffer.hpp>
+#include <RuleString.hpp>
+
+using namespace std::literals::string_literals;
+
+// margolus block rules on the gpu: the tables of both phases go to a storage
+// buffer once, and every generation replaces the blocks of a texture in place,
+// see margolus.comp
+struct BlockUpdater {
+  gl::Uniform<gl::UniformType::SAMPLER2D> uGridTex;
+  gl::Uniform<gl::UniformType::UINTEGER> uPhase, uTableOffset, uBits, uAccessMode;
+  gl::Uniform<gl::UniformType::IVEC2> uSize;
+  gl::ShaderProgram<gl::ComputeShader> program;
+
+  using ShaderProgramCompute = decltype(program);
+
+  // must match the layout of margolus.comp
+  static constexpr int local_size = 8;
+  GLuint tablebuf = 0, statsbuf = 0;
+  glm::ivec2 size = glm::ivec2(0, 0);
+  uint32_t table_size = 0, bits = 1;
+
+  // as read back by read_stats: the counts are changes, modulo 2^32
+  struct Stats {
+    uint32_t hash_lo, hash_hi;
+    uint32_t counts[4];
+  };
+
+  explicit BlockUpdater(const std::string &dir):
+    uGridTex("gridTex"s),
+    uPhase("phase"s), uTableOffset("table_offset"s), uBits("bits"s), uAccessMode("access_mode"s),
+    uSize("size"s),
+    program({std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("margolus.comp"s))})
+  {}
+
+  void init(int w, int h, const ca::BlockSpec &spec) {
+    size = glm::ivec2(w, h);
+    table_size = uint32_t(spec.table_size());
+    bits = uint32_t(ca::BlockSpec::bits_per_cell(spec.no_states));
+    std::vector<uint32_t> tables(spec.even.begin(), spec.even.end());
+    tables.insert(tables.end(), spec.odd.begin(), spec.odd.end());
+    gl::StorageBuffer::init(tablebuf, tables.size() * sizeof(uint32_t), tables.data());
+    gl::StorageBuffer::init(statsbuf, sizeof(Stats));
+    ShaderProgramCompute::compile_program(program);
+    program.assign_uniforms(uGridTex, uPhase, uTableOffset, uBits, uAccessMode, uSize);
+  }
+
+  void run(GLuint gridtex, size_t generation, int access_mode) {
+    const uint32_t phase = generation & 1;
+    gl::StorageBuffer::zero(statsbuf);
+    ShaderProgramCompute::use(program);
+    uGridTex.set_data(0);
+    uPhase.set_data(phase);
+    uTableOffset.set_data(phase * table_size);
+    uBits.set_data(bits);
+    uAccessMode.set_data(access_mode);
+    uSize.set_data(size);
+    glBindImageTexture(0, gridtex, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R8UI); GLERROR
+    gl::StorageBuffer::bind_base(tablebuf, 0);
+    gl::StorageBuffer::bind_base(statsbuf, 1);
+    const glm::ivec2 blocks = size / 2;
+    ShaderProgramCompute::dispatch((blocks.x + local_size - 1) / local_size, (blocks.y + local_size - 1) / local_size, 1);
+    ShaderProgramCompute::barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    ShaderProgramCompute::unuse();
+  }
+
+  // blocks until the last run has finished
+  Stats read_stats() {
+    Stats stats;
+    gl::StorageBuffer::read(statsbuf, &stats, 1);
+    return stats;
+  }
+
+  bool is_active() const {
+    return statsbuf != 0;
+  }
+
+  void clear() {
+    if(!is_active()) {
+      return;
+    }
+    gl::StorageBuffer::clear(tablebuf);
+    gl::StorageBuffer::clear(statsbuf);
+    ShaderProgramCompute::clear(program);
+    ShaderProgramCompute::unassign_uniforms(uGridTex, uPhase, uTableOffset, uBits, uAccessMode, uSize);
+  }
+};
@@ -7,21 +7,75 @@
 #include <initializer_list>
 #include <type_traits>
 #include <utility>
-#include <bitset>
+#include <bit>
 #include <iostream>
+#include <string>
+
+#include <RuleString.hpp>
+#include <Random.hpp>
 
 namespace ca {
 
 inline uint8_t random(int y, int x, int no_states) {
-  return rand() % no_states;
+  return rng::random(y, x, no_states);
 }
 
+// a neighbourhood within the 3x3 box as a compile-time policy: Mask has bit
+// 3 (dy + 1) + (dx + 1) set for each neighbour at (dy, dx). the loops below test
+// constants only, so each policy compiles to the reads of its own cells
+template <uint16_t Mask>
+struct Stencil {
+  static constexpr uint16_t mask = Mask & ~uint16_t(1 << 4);
+  static constexpr int max_count = std::popcount(mask);
+
+  static constexpr bool has(int dy, int dx) {
+    return (mask >> ((dy + 1) * 3 + (dx + 1))) & 1;
+  }
+
+  template <typename BufT>
+  static int count(BufT &prev, int y, int x, int on_state) {
+    int counter = 0;
+    for(int iy : {-1, 0, 1}) {
+      for(int ix : {-1, 0, 1}) {
+        if(has(iy, ix) && prev[y + iy][x + ix] == on_state) {
+          ++counter;
+        }
+      }
+    }
+    return counter;
+  }
+
+  // x - 1 and x + 1 must be readable
+  static inline int count_row(const uint8_t *__restrict up, const uint8_t *__restrict mid, const uint8_t *__restrict down,
+                              int x, uint8_t on_state)
+  {
+    return (has(-1, -1) ? int(up[x - 1] == on_state) : 0)
+         + (has(-1, 0) ? int(up[x] == on_state) : 0)
+         + (has(-1, 1) ? int(up[x + 1] == on_state) : 0)
+         + (has(0, -1) ? int(mid[x - 1] == on_state) : 0)
+         + (has(0, 1) ? int(mid[x + 1] == on_state) : 0)
+         + (has(1, -1) ? int(down[x - 1] == on_state) : 0)
+         + (has(1, 0) ? int(down[x] == on_state) : 0)
+         + (has(1, 1) ? int(down[x + 1] == on_state) : 0);
+  }
+};
+
+using Moore = Stencil<RuleSpec::moore>;
+using VonNeumann = Stencil<RuleSpec::von_neumann>;
+using Hexagonal = Stencil<RuleSpec::hexagonal>;
+
 template <typename CA, typename BufT>
 int count_moore_neighborhood(BufT &prev, int y, int x, int on_state) {
+  return Moore::count(prev, y, x, on_state);
+}
+
+// the (2 range + 1)^2 box, one read per cell; the engines use running sums instead
+template <typename CA, typename BufT>
+int count_range_neighborhood(BufT &prev, int y, int x, int on_state, int range, bool middle) {
   int counter = 0;
-  for(int iy : {-1, 0, 1}) {
-    for(int ix : {-1, 0, 1}) {
-      if(!iy&&!ix)continue;
+  for(int iy = -range; iy <= range; ++iy) {
+    for(int ix = -range; ix <= range; ++ix) {
+      if(!iy && !ix && !middle)continue;
       if(prev[y + iy][x + ix] == on_state) {
         ++counter;
       }
@@ -32,8 +86,11 @@ int count_moore_neighborhood(BufT &prev, int y, int x, int on_state) {
 
 // https://conwaylife.com/wiki/List_of_Generations_rules
 // http://www.mirekw.com/ca/rullex_gene.html
+// the rule is read at run time, the neighbourhood N is compiled in
+template <typename N = Moore>
 struct BSC {
-  using self_t = BSC;
+  using self_t = BSC<N>;
+  using neighbourhood = N;
   static constexpr int outside_state = 0;
   static constexpr int dim = 4;
   static constexpr int update_mode = ::update_mode::ALL;
@@ -42,19 +99,25 @@ struct BSC {
     return random(y, x, no_states);
   }
 
-  std::bitset<8> bs_bitmask, ss_bitmask;
+  // bit i is set when i live neighbours cause birth/survival
+  uint16_t bs_bitmask, ss_bitmask;
   int no_states;
   const int DEAD, LIVE;
 
+  explicit BSC(const RuleSpec &rule):
+    bs_bitmask(rule.birth), ss_bitmask(rule.survival), no_states(rule.no_states),
+    DEAD(0), LIVE(no_states - 1)
+  {}
+
   explicit BSC(const std::vector<uint8_t> &bs, const std::vector<uint8_t> &ss, int c):
     bs_bitmask(0), ss_bitmask(0), no_states(c),
     DEAD(0), LIVE(no_states - 1)
   {
     for(uint8_t b : bs) {
-      bs_bitmask[b] = 1;
+      bs_bitmask |= uint16_t(1 << b);
     }
     for(uint8_t s : ss) {
-      ss_bitmask[s] = 1;
+      ss_bitmask |= uint16_t(1 << s);
     }
   }
 
@@ -64,26 +127,148 @@ struct BSC {
   // N - 3 age 2
   // ...
 
+  RuleSpec get_rule() const {
+    RuleSpec rule;
+    rule.birth = bs_bitmask;
+    rule.survival = ss_bitmask;
+    rule.no_states = no_states;
+    rule.stencil = N::mask;
+    return rule;
+  }
+
+  inline uint8_t transition(int state, int count) const {
+    if(state == DEAD) {
+      return ((bs_bitmask >> count) & 1) ? LIVE : DEAD;
+    } else if(state == LIVE) {
+      return ((ss_bitmask >> count) & 1) ? LIVE : LIVE - 1;
+    }
+    return state - 1;
+  }
+
   template <typename B>
   uint8_t next_state(B &&prev, int y, int x) {
-    const int count = count_moore_neighborhood<self_t>(prev, y, x, LIVE);
-    const int state = prev[y][x];
-    if(
-        (state == DEAD && bs_bitmask[count])
-        || (state == LIVE && ss_bitmask[count])
-    )
-    {
-      return LIVE;
+    return transition(prev[y][x], N::count(prev, y, x, LIVE));
+  }
+
+  // as StaticBSC::next_row, with the masks loaded once per row
+  void next_row(const uint8_t *__restrict up, const uint8_t *__restrict mid, const uint8_t *__restrict down,
+                uint8_t *__restrict dst, int x0, int x1) const
+  {
+    const uint16_t bs = bs_bitmask, ss = ss_bitmask;
+    const uint8_t live = LIVE;
+    for(int x = x0; x < x1; ++x) {
+      const int count = N::count_row(up, mid, down, x, live);
+      const uint8_t state = mid[x];
+      const uint16_t mask = (state == 0) ? bs : ss;
+      const bool on = (state == 0 || state == live) && ((mask >> count) & 1);
+      dst[x] = on ? live : uint8_t(state - (state != 0));
     }
-    return (state == 0) ? 0 : state - 1;
   }
 };
 
-decltype(auto) bsc(std::vector<uint8_t> bs, std::vector<uint8_t> ss, int c=2) {
-  return [=]() mutable -> BSC {
-    return BSC(bs, ss, c);
-  };
-}
+// BSC with the rule as template arguments: the birth/survival test folds into
+// shifts of constants, and next_row gives the host sweep a branch-light inner
+// loop over raw rows that the compiler can vectorize
+template <uint16_t BMask, uint16_t SMask, int C=2, typename N=Moore>
+struct StaticBSC {
+  using self_t = StaticBSC<BMask, SMask, C, N>;
+  using neighbourhood = N;
+  static constexpr int outside_state = 0;
+  static constexpr int dim = 4;
+  static constexpr int update_mode = ::update_mode::ALL;
+  static constexpr int no_states = C;
+  static constexpr int DEAD = 0, LIVE = C - 1;
+  static_assert(C >= 2 && C <= RuleSpec::max_states, "invalid number of states");
+  static_assert(((BMask | SMask) >> (N::max_count + 1)) == 0, "more neighbours than the neighbourhood has");
+
+  static uint8_t init_state(int y, int x) {
+    return random(y, x, no_states);
+  }
+
+  static RuleSpec get_rule() {
+    RuleSpec rule;
+    rule.birth = BMask;
+    rule.survival = SMask;
+    rule.no_states = C;
+    rule.stencil = N::mask;
+    return rule;
+  }
+
+  static inline uint8_t transition(int state, int count) {
+    if constexpr(C == 2) {
+      return ((state ? SMask : BMask) >> count) & 1;
+    } else {
+      if(state == DEAD) {
+        return ((BMask >> count) & 1) ? LIVE : DEAD;
+      } else if(state == LIVE) {
+        return ((SMask >> count) & 1) ? LIVE : LIVE - 1;
+      }
+      return state - 1;
+    }
+  }
+
+  template <typename B>
+  static uint8_t next_state(B &&prev, int y, int x) {
+    return transition(prev[y][x], N::count(prev, y, x, LIVE));
+  }
+
+  // cells x0..x1-1 of a row, given the rows above and below; x0 - 1 and x1 must be readable
+  static void next_row(const uint8_t *__restrict up, const uint8_t *__restrict mid, const uint8_t *__restrict down,
+                       uint8_t *__restrict dst, int x0, int x1)
+  {
+    for(int x = x0; x < x1; ++x) {
+      dst[x] = transition(mid[x], N::count_row(up, mid, down, x, LIVE));
+    }
+  }
+};
+
+// https://conwaylife.com/wiki/Larger_than_Life
+// counts are over the whole box, including the cell itself when spec.middle is set
+struct LtL {
+  using self_t = LtL;
+  static constexpr int outside_state = 0;
+  static constexpr int dim = 4;
+  static constexpr int update_mode = ::update_mode::ALL;
+
+  LtlSpec spec;
+  int no_states;
+  const int DEAD, LIVE;
+
+  explicit LtL(const LtlSpec &spec):
+    spec(spec), no_states(spec.no_states),
+    DEAD(0), LIVE(no_states - 1)
+  {}
+
+  uint8_t init_state(int y, int x) {
+    return random(y, x, no_states);
+  }
+
+  LtlSpec get_ltl() const {
+    return spec;
+  }
+
+  int get_range() const {
+    return spec.range;
+  }
+
+  bool counts_middle() const {
+    return spec.middle;
+  }
+
+  inline uint8_t transition(int state, int count) const {
+    if(state == DEAD) {
+      return (count >= spec.bmin && count <= spec.bmax) ? LIVE : DEAD;
+    } else if(state == LIVE) {
+      return (count >= spec.smin && count <= spec.smax) ? LIVE : LIVE - 1;
+    }
+    return state - 1;
+  }
+
+  template <typename B>
+  uint8_t next_state(B &&prev, int y, int x) const {
+    return transition(prev[y][x], count_range_neighborhood<self_t>(prev, y, x, LIVE, spec.range, spec.middle));
+  }
+};
 
 struct LangtonsAnt {
   using self_t = LangtonsAnt;
@@ -126,10 +311,10 @@ struct LangtonsAnt {
   std::pair<size_t, uint8_t> next_state(B &&prev) {
     const int w = prev.width, h = prev.height;
     if(cursor == -1) {
-      cursor = rand() % (w * h);
+      cursor = rng::get(rng::get_seed(), 0, -1, 0) % uint32_t(w * h);
     }
     if(dir == -1) {
-      dir = rand() % NO_DIRS;
+      dir = rng::get(rng::get_seed(), 0, -1, 1) % NO_DIRS;
     }
 
     int y = cursor / w, x = cursor % w;
@@ -202,101 +387,213 @@ struct Wireworld {
 } // namespace ca
 
 // http://www.conwaylife.com/wiki/List_of_Life-like_cellular_automata
+// the named rules, shared by the menu and the command line
 namespace cellular {
-  template <size_t... Is> using sequence = std::index_sequence<Is...>;
-
-  // 2 states
-  decltype(auto) Replicator     = ca::bsc({1,3,5,7},    {1,3,5,7});
-  decltype(auto) Fredkin        = ca::bsc({1,3,5,7},    {0,2,4,6,8});
-  decltype(auto) Seeds          = ca::bsc({2},          {});
-  decltype(auto) LiveOrDie      = ca::bsc({2},          {0});
-  decltype(auto) Flock          = ca::bsc({3},          {1,2});
-  decltype(auto) Mazectric      = ca::bsc({3},          {1,2,3,4});
-  decltype(auto) Maze           = ca::bsc({3},          {1,2,3,4,5});
-  decltype(auto) MazectricMice  = ca::bsc({3,7},        {1,2,3,4});
-  decltype(auto) MazeMice       = ca::bsc({3,7},        {1,2,3,4,5});
-  decltype(auto) GameOfLife     = ca::bsc({3},          {2,3});
-  decltype(auto) EightLife      = ca::bsc({3},          {2,3,8});
-  decltype(auto) LongLife       = ca::bsc({3,4,5},      {5});
-  decltype(auto) TxT            = ca::bsc({3,6},        {1,2,5});
-  decltype(auto) HighLife       = ca::bsc({3,6},        {2,3});
-  decltype(auto) Move           = ca::bsc({3,6,8},      {2,4,5});
-  decltype(auto) Stains         = ca::bsc({3,6,7,8},    {2,3,5,6,7,8});
-  decltype(auto) DayAndNight    = ca::bsc({3,6,7,8},    {3,4,6,7,8});
-  decltype(auto) Anneal         = ca::bsc({4,6,7,8},    {3,5,6,7,8});
-  decltype(auto) DryLife        = ca::bsc({3,7},        {2,3});
-  decltype(auto) PedestrLife    = ca::bsc({3,8},        {2,3});
-  decltype(auto) Amoeba         = ca::bsc({3,5,7},      {1,3,5,8});
-  decltype(auto) Diamoeba       = ca::bsc({3,5,6,7,8},  {5,6,7,8});
+  enum rule_kind : int {
+    GENERATIONS, LANGTONSANT, WIREWORLD, LARGERTHANLIFE
+  };
 
-  using LangtonsAnt  = ca::LangtonsAnt;
+  struct RuleEntry {
+    const char *name;
+    const char *rulestring;
+    rule_kind kind = rule_kind::GENERATIONS;
+
+    ca::RuleSpec rule() const {
+      if(kind != rule_kind::GENERATIONS) {
+        return ca::RuleSpec();
+      }
+      return ca::parse_registry_rule(name, rulestring, ca::parse_rulestring);
+    }
+
+    ca::LtlSpec ltl() const {
+      if(kind != rule_kind::LARGERTHANLIFE) {
+        return ca::LtlSpec();
+      }
+      return ca::parse_registry_rule(name, rulestring, ca::parse_ltl_rulestring);
+    }
 
-  // 3 states
-  decltype(auto) BriansBrain    = ca::bsc({2},          {},                3 );
-  decltype(auto) Brain6         = ca::bsc({2,4,6},      {6},               3 );
-  decltype(auto) Frogs          = ca::bsc({3,4},        {1,2},             3 );
-  decltype(auto) Lines          = ca::bsc({4,5,8},      {0,1,2,3,4,5},     3 );
+    int no_states() const {
+      switch(kind) {
+        case rule_kind::LANGTONSANT: return ca::LangtonsAnt::no_states;
+        case rule_kind::WIREWORLD: return ca::Wireworld::no_states;
+        case rule_kind::LARGERTHANLIFE: return ltl().no_states;
+        default: return rule().no_states;
+      }
+    }
+  };
 
-  // 4 states
-  decltype(auto) Caterpillars   = ca::bsc({3,7,8},      {1,2,4,5,6,7},     4 );
-  decltype(auto) OrthoGo        = ca::bsc({2},          {3},               4 );
-  decltype(auto) SediMental     = ca::bsc({2,5,6,7,8},  {4,5,6,7,8},       4 );
-  decltype(auto) StarWars       = ca::bsc({2},          {3,4,5},           4 );
+  const std::vector<RuleEntry> registry = {
+    // 2 states
+    { "Replicator"      , "B1357/S1357"              },
+    { "Fredkin"         , "B1357/S02468"             },
+    { "Seeds"           , "B2/S"                     },
+    { "Live Or Die"     , "B2/S0"                    },
+    { "Flock"           , "B3/S12"                   },
+    { "Game Of Life"    , "B3/S23"                   },
+    { "Mazectric"       , "B3/S1234"                 },
+    { "Maze"            , "B3/S12345"                },
+    { "MazectricMice"   , "B37/S1234"                },
+    { "MazeMice"        , "B37/S12345"               },
+    { "Eight Life"      , "B3/S238"                  },
+    { "Long Life"       , "B345/S5"                  },
+    { "2x2"             , "B36/S125"                 },
+    { "High Life"       , "B36/S23"                  },
+    { "Move"            , "B368/S245"                },
+    { "Stains"          , "B3678/S235678"            },
+    { "Day And Night"   , "B3678/S34678"             },
+    { "Anneal"          , "B4678/S35678"             },
+    { "Dry Life"        , "B37/S23"                  },
+    { "Pedestr Life"    , "B38/S23"                  },
+    { "Amoeba"          , "B357/S1358"               },
+    { "Diamoeba"        , "B35678/S5678"             },
+    { "Langton's Ant"   , ""                         , rule_kind::LANGTONSANT },
+    { "Bosco's Rule"    , "R5,C0,M1,S34..58,B34..45,NM"     , rule_kind::LARGERTHANLIFE },
+    { "Majority"        , "R4,C0,M1,S41..81,B41..81,NM"     , rule_kind::LARGERTHANLIFE },
+    { "Waffle"          , "R7,C0,M1,S100..200,B75..170,NM"  , rule_kind::LARGERTHANLIFE },
+    { "Globe"           , "R8,C0,M0,S163..223,B74..252,NM"  , rule_kind::LARGERTHANLIFE },
+    // 3 states
+    { "Brian's Brain"   , "B2/S/C3"                  },
+    { "Brain6"          , "B246/S6/C3"               },
+    { "Frogs"           , "B34/S12/C3"               },
+    { "Lines"           , "B458/S012345/C3"          },
+    // 4 states
+    { "Caterpillars"    , "B378/S124567/C4"          },
+    { "OrthoGo"         , "B2/S3/C4"                 },
+    { "SediMental"      , "B25678/S45678/C4"         },
+    { "StarWars"        , "B2/S345/C4"               },
+    { "Wireworld"       , ""                         , rule_kind::WIREWORLD },
+    // 5 states
+    { "Banners"         , "B3457/S2367/C5"           },
+    { "Glissergy"       , "B245678/S035678/C5"       },
+    { "Spirals"         , "B234/S2/C5"               },
+    { "Transers"        , "B26/S345/C5"              },
+    { "Wanderers"       , "B34678/S345/C5"           },
+    // 6 states
+    { "Chenille"        , "B24567/S05678/C6"         },
+    { "FrozenSpirals"   , "B23/S356/C6"              },
+    { "LivingOnTheEdge" , "B3/S345/C6"               },
+    { "PrairieOnFire"   , "B34/S345/C6"              },
+    { "Rake"            , "B2678/S3467/C6"           },
+    { "Snake"           , "B25/S03467/C6"            },
+    { "SoftFreeze"      , "B38/S13458/C6"            },
+    { "Sticks"          , "B2/S3456/C6"              },
+    { "Worms"           , "B25/S3467/C6"             },
+    // 7 states
+    { "Glisserati"      , "B245678/S035678/C7"       },
+    // 8 states
+    { "BelZhab"         , "B23/S145678/C8"           },
+    { "CircuitGenesis"  , "B1234/S2345/C8"           },
+    { "Cooties"         , "B2/S23/C8"                },
+    { "FlamingStarbows" , "B23/S347/C8"              },
+    { "Lava"            , "B45678/S12345/C8"         },
+    { "MeteorGuns"      , "B3/S01245678/C8"          },
+    { "Swirl"           , "B34/S23/C8"               },
+    // 9 states
+    { "Burst"           , "B3468/S0235678/C9"        },
+    { "Burst2"          , "B3468/S235678/C9"         },
+    // 16 states
+    { "Xtasy"           , "B2356/S1456/C16"          },
+    // 18 states
+    { "EbbAndFlow"      , "B36/S012478/C18"          },
+    { "EbbAndFlow2"     , "B37/S012468/C18"          },
+    // 21 states
+    { "Fireworks"       , "B13/S2/C21"               },
+    // 24 states
+    { "Bloomerang"      , "B34678/S234/C24"          },
+    // 25 states
+    { "Faders"          , "B2/S2/C25"                },
+    { "Nova"            , "B2478/S45678/C25"         },
+    { "Bombers"         , "B24/S345/C25"             },
+    // 48 states
+    { "ThrillGrill"     , "B34/S1234/C48"            },
+  };
 
-  using Wireworld    = ca::Wireworld;
+  // case, spaces and punctuation are ignored: "game of life" and "GameOfLife" both work
+  inline int find_rule(const std::string &name) {
+    auto &&simplify = [](const std::string &s) -> std::string {
+      std::string t;
+      for(char c : s) {
+        if(isalnum((unsigned char)c))t += char(tolower((unsigned char)c));
+      }
+      return t;
+    };
+    const std::string key = simplify(name);
+    for(size_t i = 0; i < registry.size(); ++i) {
+      if(simplify(registry[i].name) == key) {
+        return int(i);
+      }
+    }
+    return -1;
+  }
+
+  // a registry name or any rulestring accepted by ca::parse_rulestring
+  inline bool resolve_rule(const std::string &name_or_rulestring, ca::RuleSpec &rule, std::string &error) {
+    const int index = find_rule(name_or_rulestring);
+    if(index != -1) {
+      if(registry[index].kind != rule_kind::GENERATIONS) {
+        error = std::string(registry[index].name) + " is not a B/S rule";
+        return false;
+      }
+      rule = registry[index].rule();
+      return true;
+    }
+    return ca::parse_rulestring(name_or_rulestring, rule, error);
+  }
+
+  // larger than life rules are told apart by their leading range, R..
+  inline bool is_ltl(const std::string &name_or_rulestring) {
+    const int index = find_rule(name_or_rulestring);
+    if(index != -1) {
+      return registry[index].kind == rule_kind::LARGERTHANLIFE;
+    }
+    const size_t i = name_or_rulestring.find_first_not_of(" \t");
+    return i != std::string::npos && i + 1 < name_or_rulestring.length()
+      && toupper((unsigned char)name_or_rulestring[i]) == 'R' && isdigit((unsigned char)name_or_rulestring[i + 1]);
+  }
+
+  inline bool resolve_ltl(const std::string &name_or_rulestring, ca::LtlSpec &rule, std::string &error) {
+    const int index = find_rule(name_or_rulestring);
+    if(index != -1) {
+      if(registry[index].kind != rule_kind::LARGERTHANLIFE) {
+        error = std::string(registry[index].name) + " is not a larger than life rule";
+        return false;
+      }
+      rule = registry[index].ltl();
+      return true;
+    }
+    return ca::parse_ltl_rulestring(name_or_rulestring, rule, error);
+  }
 
-  // 5 states
-  decltype(auto) Banners        = ca::bsc({3,4,5,7},    {2,3,6,7},         5 );
-  decltype(auto) Glissergy      = ca::bsc({2,4,5,6,7,8},{0,3,5,6,7,8},     5 );
-  decltype(auto) Spirals        = ca::bsc({2,3,4},      {2},               5 );
-  decltype(auto) Transers       = ca::bsc({2,6},        {3,4,5},           5 );
-  decltype(auto) Wanderers      = ca::bsc({3,4,6,7,8},  {3,4,5},           5 );
-
-  // 6 states
-  decltype(auto) Chenille       = ca::bsc({2,4,5,6,7},  {0,5,6,7,8},       6 );
-  decltype(auto) FrozenSpirals  = ca::bsc({2,3},        {3,5,6},           6 );
-  decltype(auto) LivingOnTheEdge= ca::bsc({3},          {3,4,5},           6 );
-  decltype(auto) PrairieOnFire  = ca::bsc({3,4},        {3,4,5},           6 );
-  decltype(auto) Rake           = ca::bsc({2,6,7,8},    {3,4,6,7},         6 );
-  decltype(auto) Snake          = ca::bsc({2,5},        {0,3,4,6,7},       6 );
-  decltype(auto) SoftFreeze     = ca::bsc({3,8},        {1,3,4,5,8},       6 );
-  decltype(auto) Sticks         = ca::bsc({2},          {3,4,5,6},         6 );
-  decltype(auto) Worms          = ca::bsc({2,5},        {3,4,6,7},         6 );
-
-  // 7 states
-  decltype(auto) Glisserati     = ca::bsc({2,4,5,6,7,8},{0,3,5,6,7,8},     7 );
-
-  // 8 states
-  decltype(auto) BelZhab        = ca::bsc({2,3},        {1,4,5,6,7,8},     8 );
-  decltype(auto) CircuitGenesis = ca::bsc({1,2,3,4},    {2,3,4,5},         8 );
-  decltype(auto) Cooties        = ca::bsc({2},          {2,3},             8 );
-  decltype(auto) FlamingStarbows= ca::bsc({2,3},        {3,4,7},           8 );
-  decltype(auto) Lava           = ca::bsc({4,5,6,7,8},  {1,2,3,4,5},       8 );
-  decltype(auto) MeteorGuns     = ca::bsc({3},          {0,1,2,4,5,6,7,8}, 8 );
-  decltype(auto) Swirl          = ca::bsc({3,4},        {2,3},             8 );
-
-  // 9 states
-  decltype(auto) Burst          = ca::bsc({3,4,6,8},    {0,2,3,5,6,7,8},   9 );
-  decltype(auto) Burst2         = ca::bsc({3,4,6,8},    {2,3,5,6,7,8},     9 );
-
-  // 16 states
-  decltype(auto) Xtasy          = ca::bsc({2,3,5,6},    {1,4,5,6},         16);
-
-  // 18 states
-  decltype(auto) EbbAndFlow     = ca::bsc({3,6},        {0,1,2,4,7,8},     18);
-  decltype(auto) EbbAndFlow2    = ca::bsc({3,7},        {0,1,2,4,6,8},     18);
-
-  // 21 states
-  decltype(auto) Fireworks      = ca::bsc({1,3},        {2},               21);
-
-  // 24 states
-  decltype(auto) Bloomerang     = ca::bsc({3,4,6,7,8},  {2,3,4},           24);
-
-  // 25 states
-  decltype(auto) Bombers        = ca::bsc({2,4},        {3,4,5},           25);
-  decltype(auto) Nova           = ca::bsc({2,4,7,8},    {4,5,6,7,8},       25);
-  decltype(auto) Faders         = ca::bsc({2},          {2},               25);
-
-  // 48 states
-  decltype(auto) ThrillGrill    = ca::bsc({3,4},        {1,2,3,4},         48);
+  using GameOfLife   = ca::StaticBSC<0b000001000, 0b000001100>;
+  using HighLife     = ca::StaticBSC<0b001001000, 0b000001100>;
+  using Seeds        = ca::StaticBSC<0b000000100, 0b000000000>;
+  using DayAndNight  = ca::StaticBSC<0b111001000, 0b111011000>;
+  using BriansBrain  = ca::StaticBSC<0b000000100, 0b000000000, 3>;
+
+  // calls func with the matching compiled-in rule when there is one, with a ca::BSC
+  // of the rule's neighbourhood otherwise
+  template <typename F>
+  decltype(auto) visit_rule(const ca::RuleSpec &rule, F &&func) {
+    if(rule == GameOfLife::get_rule()) {
+      return func(GameOfLife());
+    } else if(rule == HighLife::get_rule()) {
+      return func(HighLife());
+    } else if(rule == Seeds::get_rule()) {
+      return func(Seeds());
+    } else if(rule == DayAndNight::get_rule()) {
+      return func(DayAndNight());
+    } else if(rule == BriansBrain::get_rule()) {
+      return func(BriansBrain());
+    }
+    if(rule.stencil == ca::RuleSpec::hexagonal) {
+      return func(ca::BSC<ca::Hexagonal>(rule));
+    } else if(rule.stencil == ca::RuleSpec::von_neumann) {
+      return func(ca::BSC<ca::VonNeumann>(rule));
+    }
+    return func(ca::BSC<ca::Moore>(rule));
+  }
+
+  using LargerThanLife = ca::LtL;
+  using LangtonsAnt  = ca::LangtonsAnt;
+  using Wireworld    = ca::Wireworld;
 } // namespace cellular
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <Random.hpp>
+
+// automata with states in [0, 1], updated from convolutions of the grid with
+// large radial kernels (see Convolution.hpp). for display, export and the
+// period detector the states are quantized to no_states levels
+namespace continuous {
+
+// weights over the (2 radius + 1)^2 box, row by row, summing to 1
+struct Kernel {
+  int radius = 0;
+  std::vector<float> weights;
+
+  template <typename F>
+  static Kernel radial(int radius, F &&shape) {
+    Kernel k;
+    k.radius = radius;
+    const int n = 2 * radius + 1;
+    k.weights.assign(n * n, 0.f);
+    double total = 0;
+    for(int dy = -radius; dy <= radius; ++dy) {
+      for(int dx = -radius; dx <= radius; ++dx) {
+        const double w = shape(std::sqrt(double(dy * dy + dx * dx)));
+        k.weights[(dy + radius) * n + dx + radius] = float(w);
+        total += w;
+      }
+    }
+    if(total > 0) {
+      for(float &w : k.weights) {
+        w = float(w / total);
+      }
+    }
+    return k;
+  }
+};
+
+// soups of noise in squares of side 2 * radius, half of which are left empty, so
+// that patterns have room to grow or move
+inline float init_patch(int y, int x, int radius) {
+  const int side = std::max(1, 2 * radius);
+  if(rng::get(rng::get_seed(), 1, y / side, x / side) & 1) {
+    return 0.f;
+  }
+  return rng::get_float(rng::get_seed(), 0, y, x);
+}
+
+// https://arxiv.org/abs/1812.05433 (Bert Wang-Chak Chan, Lenia)
+// a smooth ring kernel (concentric rings weighted by peaks) and a gaussian growth
+// around mu; the defaults are Orbium, which glides
+struct Lenia {
+  using self_t = Lenia;
+  static constexpr int outside_state = 0;
+  static constexpr int dim = 4;
+  static constexpr int update_mode = ::update_mode::ALL;
+  static constexpr int no_states = 256;
+
+  int radius = 13;
+  float mu = .15, sigma = .015, dt = .1;
+  std::vector<float> peaks = {1.f};
+
+  float init_state(int y, int x) const {
+    return init_patch(y, x, radius);
+  }
+
+  std::vector<Kernel> kernels() const {
+    const int n = int(peaks.size());
+    return {Kernel::radial(radius, [&](double d) -> double {
+      const double r = d / radius * n;
+      if(r >= n) {
+        return 0;
+      }
+      const double u = r - std::floor(r);
+      if(u <= 0 || u >= 1) {
+        return 0;
+      }
+      return peaks[int(r)] * std::exp(4 - 1 / (u * (1 - u)));
+    })};
+  }
+
+  // sums[0]: the weighted neighbourhood
+  float next(float state, const float *sums) const {
+    const float d = sums[0] - mu;
+    const float growth = 2 * std::exp(-d * d / (2 * sigma * sigma)) - 1;
+    return std::clamp(state + dt * growth, 0.f, 1.f);
+  }
+};
+
+// https://arxiv.org/abs/1111.1567 (Stephan Rafler, SmoothLife), in discrete time:
+// the filling of the disk of radius ri decides between the birth and the death
+// interval of the filling of the annulus out to ra
+struct SmoothLife {
+  using self_t = SmoothLife;
+  static constexpr int outside_state = 0;
+  static constexpr int dim = 4;
+  static constexpr int update_mode = ::update_mode::ALL;
+  static constexpr int no_states = 256;
+
+  float ra = 12, ri = 4;
+  float b1 = .278, b2 = .365, d1 = .267, d2 = .445;
+  float alpha_n = .028, alpha_m = .147;
+
+  float init_state(int y, int x) const {
+    return init_patch(y, x, int(ra));
+  }
+
+  // edges are antialiased over one cell
+  std::vector<Kernel> kernels() const {
+    const int radius = int(std::ceil(ra + .5));
+    return {
+      Kernel::radial(radius, [&](double d) -> double {
+        return std::clamp(ri + .5 - d, 0., 1.);
+      }),
+      Kernel::radial(radius, [&](double d) -> double {
+        return std::clamp(d - ri + .5, 0., 1.) * std::clamp(ra + .5 - d, 0., 1.);
+      }),
+    };
+  }
+
+  static float sigma1(float x, float a, float alpha) {
+    return 1 / (1 + std::exp(-(x - a) * 4 / alpha));
+  }
+
+  // sums[0]: the inner filling m, sums[1]: the outer filling n
+  float next(float state, const float *sums) const {
+    const float m = sums[0], n = sums[1];
+    const float alive = sigma1(m, .5, alpha_m);
+    const float lo = b1 * (1 - alive) + d1 * alive, hi = b2 * (1 - alive) + d2 * alive;
+    return sigma1(n, lo, alpha_n) * (1 - sigma1(n, hi, alpha_n));
+  }
+};
+
+// the named rules, for the menu and --rule
+enum rule_kind : int {
+  LENIA, SMOOTHLIFE, NO_RULES
+};
+
+constexpr const char *rule_names[] = {"Lenia", "SmoothLife"};
+
+inline int find_rule(const std::string &name) {
+  std::string key;
+  for(char c : name) {
+    if(isalnum((unsigned char)c))key += char(tolower((unsigned char)c));
+  }
+  if(key == "lenia" || key == "orbium") {
+    return LENIA;
+  } else if(key == "smoothlife") {
+    return SMOOTHLIFE;
+  }
+  return -1;
+}
+
+template <typename F>
+void visit_rule(int kind, F &&func) {
+  switch(kind) {
+    case LENIA: func(Lenia()); break;
+    case SMOOTHLIFE: func(SmoothLife()); break;
+  }
+}
+
+} // namespace continuous
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <utility>
+#include <algorithm>
+
+#include <Logger.hpp>
+#include <Threads.hpp>
+#include <Continuous.hpp>
+
+// convolution of a float grid with several kernels at once, wrapped around or
+// with zeros outside. small kernels are applied directly; large ones by
+// multiplying spectra, which costs O(log N) per cell instead of O(radius^2)
+namespace conv {
+
+using complex = std::complex<float>;
+
+// radix-2 transform of a power of two points, in place and unscaled
+class FFT {
+  int n = 0;
+  std::vector<complex> twiddles;
+  std::vector<int> reversed;
+public:
+  static bool is_power_of_two(int n) {
+    return n > 0 && (n & (n - 1)) == 0;
+  }
+
+  static int next_power_of_two(int n) {
+    int p = 1;
+    while(p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  void init(int n_) {
+    n = n_;
+    twiddles.resize(n / 2);
+    for(int k = 0; k < n / 2; ++k) {
+      const double a = -2 * M_PI * k / n;
+      twiddles[k] = complex(float(std::cos(a)), float(std::sin(a)));
+    }
+    reversed.resize(n);
+    int log2n = 0;
+    while((1 << log2n) < n) {
+      ++log2n;
+    }
+    for(int i = 0; i < n; ++i) {
+      int r = 0;
+      for(int b = 0; b < log2n; ++b) {
+        r |= ((i >> b) & 1) << (log2n - 1 - b);
+      }
+      reversed[i] = r;
+    }
+  }
+
+  int size() const {
+    return n;
+  }
+
+  void run(complex *x, bool inverse) const {
+    for(int i = 0; i < n; ++i) {
+      if(i < reversed[i]) {
+        std::swap(x[i], x[reversed[i]]);
+      }
+    }
+    for(int len = 2; len <= n; len <<= 1) {
+      const int half = len / 2, step = n / len;
+      for(int i = 0; i < n; i += len) {
+        for(int k = 0; k < half; ++k) {
+          const complex tw = inverse ? std::conj(twiddles[k * step]) : twiddles[k * step];
+          const complex t = x[i + k + half] * tw;
+          x[i + k + half] = x[i + k] - t;
+          x[i + k] += t;
+        }
+      }
+    }
+  }
+};
+
+class Convolver {
+  int w = 0, h = 0, radius = 0;
+  bool looped = true;
+  int no_kernels = 0;
+  bool use_fft = false;
+  // fft: padded size. the transform wraps around, so a looped board of a power of
+  // two side is taken as is; otherwise the padding is wide enough that the wrapped
+  // (or, when bounded, zero) halo on either side cannot overlap
+  int pw = 0, ph = 0;
+  FFT fft_w, fft_h;
+  // per pair of kernels a and b, scaled spectrum(a) + i spectrum(b): both results
+  // are real, so one inverse transform gives a in the real and b in the imaginary part
+  std::vector<std::vector<complex>> spectra;
+  std::vector<complex> grid, product;
+  // per-thread columns, for the transforms down the columns: a block of them is
+  // gathered at once, so that every cache line read from a row is used whole
+  static constexpr int column_block = 8;
+  std::vector<std::vector<complex>> columns;
+  // direct: the nonzero weights and the padded grid they are applied to
+  struct Tap {
+    int dy, dx;
+    float weight;
+  };
+  std::vector<std::vector<Tap>> taps;
+  std::vector<float> padded;
+public:
+  void init(int w_, int h_, bool looped_, const std::vector<continuous::Kernel> &kernels) {
+    w = w_, h = h_, looped = looped_;
+    no_kernels = int(kernels.size());
+    radius = 0;
+    size_t no_taps = 0;
+    taps.assign(no_kernels, {});
+    for(int k = 0; k < no_kernels; ++k) {
+      const continuous::Kernel &kernel = kernels[k];
+      radius = std::max(radius, kernel.radius);
+      const int n = 2 * kernel.radius + 1;
+      for(int dy = -kernel.radius; dy <= kernel.radius; ++dy) {
+        for(int dx = -kernel.radius; dx <= kernel.radius; ++dx) {
+          const float weight = kernel.weights[(dy + kernel.radius) * n + dx + kernel.radius];
+          if(weight != 0) {
+            taps[k].push_back({dy, dx, weight});
+          }
+        }
+      }
+      no_taps += taps[k].size();
+    }
+    pw = padded_size(w), ph = padded_size(h);
+    // the transform of the grid is shared, then one multiply and inverse transform per
+    // pair, in multiply-adds per cell. the factor puts the crossover near radius 8
+    const double fft_cost = 5 * std::log2(double(pw) * ph) * (1 + (no_kernels + 1) / 2) * (double(pw) * ph) / (double(w) * h);
+    use_fft = no_taps > fft_cost;
+    Logger::Info("[conv] %dx%d, %d kernels of radius %d, %lu taps: %s\n", w, h, no_kernels, radius, no_taps,
+                 use_fft ? "fft" : "direct");
+    spectra.clear();
+    grid.clear(), product.clear(), padded.clear();
+    if(!use_fft) {
+      return;
+    }
+    fft_w.init(pw), fft_h.init(ph);
+    columns.assign(sys::get_max_threads(), std::vector<complex>(size_t(ph) * column_block));
+    const float scale = 1.f / (float(pw) * ph);
+    for(int k = 0; k < no_kernels; k += 2) {
+      std::vector<complex> s(size_t(pw) * ph, complex(0, 0));
+      // out(x) = sum over d of in(x + d) weight(d), so weight(d) goes to -d
+      for(int j = k; j < std::min(k + 2, no_kernels); ++j) {
+        const complex unit = (j == k) ? complex(scale, 0) : complex(0, scale);
+        std::vector<complex> one(size_t(pw) * ph, complex(0, 0));
+        for(const Tap &t : taps[j]) {
+          const int y = ((-t.dy % ph) + ph) % ph, x = ((-t.dx % pw) + pw) % pw;
+          one[size_t(y) * pw + x] += t.weight;
+        }
+        transform(one, false);
+        for(size_t i = 0; i < one.size(); ++i) {
+          s[i] += one[i] * unit;
+        }
+      }
+      spectra.push_back(std::move(s));
+    }
+    grid.resize(size_t(pw) * ph);
+    product.resize(size_t(pw) * ph);
+  }
+
+  int padded_size(int n) const {
+    if(looped) {
+      return FFT::is_power_of_two(n) ? n : FFT::next_power_of_two(n + 2 * radius);
+    }
+    return FFT::next_power_of_two(n + radius);
+  }
+
+  // the cell of a board of side n at i of the padded side pn, or -1 for a zero
+  int source(int i, int n, int pn) const {
+    if(i < n) {
+      return i;
+    } else if(looped && i < n + radius) {
+      return i - n;
+    } else if(looped && i >= pn - radius) {
+      return i - pn + n;
+    }
+    return -1;
+  }
+
+  bool is_fft() const {
+    return use_fft;
+  }
+
+  // 2d transform: the rows, then the columns through a per-thread copy
+  void transform(std::vector<complex> &data, bool inverse) {
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < ph; ++y) {
+      fft_w.run(&data[size_t(y) * pw], inverse);
+    }
+    const int block = std::min(column_block, pw);
+    #pragma omp parallel for schedule(static)
+    for(int x0 = 0; x0 < pw; x0 += block) {
+      complex *cols = columns[sys::get_thread_num() % columns.size()].data();
+      for(int y = 0; y < ph; ++y) {
+        for(int c = 0; c < block; ++c) {
+          cols[c * ph + y] = data[size_t(y) * pw + x0 + c];
+        }
+      }
+      for(int c = 0; c < block; ++c) {
+        fft_h.run(&cols[c * ph], inverse);
+      }
+      for(int y = 0; y < ph; ++y) {
+        for(int c = 0; c < block; ++c) {
+          data[size_t(y) * pw + x0 + c] = cols[c * ph + y];
+        }
+      }
+    }
+  }
+
+  // out[k] gets w * h sums of kernel k
+  void run(const float *src, const std::vector<float *> &out) {
+    if(use_fft) {
+      run_fft(src, out);
+    } else {
+      run_direct(src, out);
+    }
+  }
+
+  void run_fft(const float *src, const std::vector<float *> &out) {
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < ph; ++y) {
+      const int sy = source(y, h, ph);
+      for(int x = 0; x < pw; ++x) {
+        const int sx = source(x, w, pw);
+        grid[size_t(y) * pw + x] = (sy < 0 || sx < 0) ? complex(0, 0) : complex(src[size_t(sy) * w + sx], 0);
+      }
+    }
+    transform(grid, false);
+    for(int k = 0; k < no_kernels; k += 2) {
+      const std::vector<complex> &s = spectra[k / 2];
+      #pragma omp parallel for schedule(static)
+      for(int i = 0; i < pw * ph; ++i) {
+        product[i] = grid[i] * s[i];
+      }
+      transform(product, true);
+      const bool pair = k + 1 < no_kernels;
+      #pragma omp parallel for schedule(static)
+      for(int y = 0; y < h; ++y) {
+        for(int x = 0; x < w; ++x) {
+          const complex v = product[size_t(y) * pw + x];
+          out[k][size_t(y) * w + x] = v.real();
+          if(pair) {
+            out[k + 1][size_t(y) * w + x] = v.imag();
+          }
+        }
+      }
+    }
+  }
+
+  void run_direct(const float *src, const std::vector<float *> &out) {
+    const int sw = w + 2 * radius, sh = h + 2 * radius;
+    padded.resize(size_t(sw) * sh);
+    #pragma omp parallel for schedule(static)
+    for(int r = 0; r < sh; ++r) {
+      int gy = r - radius;
+      if(looped) {
+        gy = ((gy % h) + h) % h;
+      }
+      for(int c = 0; c < sw; ++c) {
+        int gx = c - radius;
+        if(looped) {
+          gx = ((gx % w) + w) % w;
+        }
+        padded[size_t(r) * sw + c] = (gy < 0 || gy >= h || gx < 0 || gx >= w) ? 0.f : src[size_t(gy) * w + gx];
+      }
+    }
+    for(int k = 0; k < no_kernels; ++k) {
+      #pragma omp parallel for schedule(static)
+      for(int y = 0; y < h; ++y) {
+        float *dst = &out[k][size_t(y) * w];
+        std::fill_n(dst, w, 0.f);
+        for(const Tap &t : taps[k]) {
+          const float *row = &padded[size_t(y + radius + t.dy) * sw + radius + t.dx];
+          for(int x = 0; x < w; ++x) {
+            dst[x] += t.weight * row[x];
+          }
+        }
+      }
+    }
+  }
+};
+
+} // namespace conv
@@ -0,0 +1,659 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+
+#if __unix__ || __linux__ || __APPLE__
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <Arena.hpp>
+#include <Period.hpp>
+#include <Random.hpp>
+#include <Automaton.hpp>
+
+extern char **environ;
+
+// one board split into horizontal strips, one per process. every generation a
+// strip sends its first and last rows to the strips above and below (the board
+// wraps around vertically) and receives their rows as ghost rows, while it
+// computes the rows that do not need them. the transport is pluggable: posix
+// shared memory between processes of one machine, tcp between machines.
+// cells are initialized and hashed with global coordinates, so a distributed
+// run matches a single host run of the same board and seed cell for cell
+namespace dist {
+
+using clock = std::chrono::steady_clock;
+
+// gives up on a peer that has not answered for this long
+constexpr double timeout_seconds = 60;
+
+struct Transport {
+  int rank = 0, no_ranks = 1;
+
+  int up() const {
+    return (rank + no_ranks - 1) % no_ranks;
+  }
+
+  int down() const {
+    return (rank + 1) % no_ranks;
+  }
+
+  // sends the first row up and the last row down; the rows must stay untouched until end_exchange
+  virtual void begin_exchange(const uint8_t *top, const uint8_t *bottom, size_t n) = 0;
+  // receives the last row of the strip above and the first row of the strip below
+  virtual void end_exchange(uint8_t *ghost_top, uint8_t *ghost_bottom, size_t n) = 0;
+  // every rank's k values, ordered by rank
+  virtual void allgather(const uint64_t *mine, size_t k, uint64_t *all) = 0;
+
+  virtual ~Transport()
+  {}
+};
+
+inline void wait_for(const char *what, const std::atomic_ref<uint64_t> &seq, uint64_t value) {
+  const clock::time_point t0 = clock::now();
+  for(int spin = 0; seq.load(std::memory_order_acquire) < value; ++spin) {
+    if(spin < 1024) {
+      continue;
+    }
+    std::this_thread::yield();
+    if((spin & 0xffff) == 0 && std::chrono::duration<double>(clock::now() - t0).count() > timeout_seconds) {
+      TERMINATE("[dist] timed out waiting for %s\n", what);
+    }
+  }
+}
+
+#if __unix__ || __linux__ || __APPLE__
+
+// one shared segment: a row mailbox and a value mailbox per rank, each in two
+// copies by parity. a rank overwrites its copy of round n only in round n+2,
+// after its neighbours have published round n+1 and so have read round n
+class ShmTransport : public Transport {
+  static constexpr uint64_t magic = 0x6175746f6d61746eULL;
+  static constexpr size_t max_values = 64;
+
+  std::string name;
+  size_t row_size;
+  uint8_t *base = nullptr;
+  size_t size = 0;
+  uint64_t no_exchanges = 0, no_gathers = 0;
+
+  // header: magic, then per rank a line with the row and value sequence numbers
+  uint64_t *header() const {
+    return (uint64_t *)base;
+  }
+
+  std::atomic_ref<uint64_t> row_seq(int r) const {
+    return std::atomic_ref<uint64_t>(header()[8 * (r + 1)]);
+  }
+
+  std::atomic_ref<uint64_t> value_seq(int r) const {
+    return std::atomic_ref<uint64_t>(header()[8 * (r + 1) + 1]);
+  }
+
+  uint8_t *row(int r, uint64_t seq, int which) const {
+    const size_t offset = 64 * (no_ranks + 1);
+    return base + offset + ((size_t(r) * 2 + (seq & 1)) * 2 + which) * row_size;
+  }
+
+  uint64_t *values(int r, uint64_t seq) const {
+    const size_t offset = 64 * (no_ranks + 1) + size_t(no_ranks) * 4 * row_size;
+    return (uint64_t *)(base + offset) + (size_t(r) * 2 + (seq & 1)) * max_values;
+  }
+public:
+  ShmTransport(const std::string &name, int rank_, int no_ranks_, size_t row_size):
+    name(name), row_size((row_size + 63) / 64 * 64)
+  {
+    rank = rank_, no_ranks = no_ranks_;
+    size = 64 * (no_ranks + 1) + size_t(no_ranks) * 4 * this->row_size + size_t(no_ranks) * 2 * max_values * sizeof(uint64_t);
+    int fd = -1;
+    if(rank == 0) {
+      shm_unlink(name.c_str());
+      fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+      if(fd < 0 || ftruncate(fd, size) != 0) {
+        TERMINATE("[dist] unable to create shared memory '%s'\n", name.c_str());
+      }
+    } else {
+      // rank 0 may not have created it yet
+      const clock::time_point t0 = clock::now();
+      struct stat st;
+      while((fd = shm_open(name.c_str(), O_RDWR, 0600)) < 0 || fstat(fd, &st) != 0 || size_t(st.st_size) < size) {
+        if(fd >= 0) {
+          close(fd);
+        }
+        if(std::chrono::duration<double>(clock::now() - t0).count() > timeout_seconds) {
+          TERMINATE("[dist] unable to open shared memory '%s'\n", name.c_str());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+    base = (uint8_t *)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+      TERMINATE("[dist] unable to map shared memory '%s'\n", name.c_str());
+    }
+    std::atomic_ref<uint64_t> ready(header()[0]);
+    if(rank == 0) {
+      ready.store(magic, std::memory_order_release);
+    } else {
+      wait_for("shared memory", ready, magic);
+    }
+    Logger::Info("[dist] rank %d of %d: shared memory '%s', %lu bytes\n", rank, no_ranks, name.c_str(), size);
+  }
+
+  void begin_exchange(const uint8_t *top, const uint8_t *bottom, size_t n) override {
+    ASSERT(n <= row_size);
+    const uint64_t seq = ++no_exchanges;
+    memcpy(row(rank, seq, 0), top, n);
+    memcpy(row(rank, seq, 1), bottom, n);
+    row_seq(rank).store(seq, std::memory_order_release);
+  }
+
+  void end_exchange(uint8_t *ghost_top, uint8_t *ghost_bottom, size_t n) override {
+    const uint64_t seq = no_exchanges;
+    wait_for("the strip above", row_seq(up()), seq);
+    memcpy(ghost_top, row(up(), seq, 1), n);
+    wait_for("the strip below", row_seq(down()), seq);
+    memcpy(ghost_bottom, row(down(), seq, 0), n);
+  }
+
+  void allgather(const uint64_t *mine, size_t k, uint64_t *all) override {
+    ASSERT(k <= max_values);
+    const uint64_t seq = ++no_gathers;
+    std::copy(mine, mine + k, values(rank, seq));
+    value_seq(rank).store(seq, std::memory_order_release);
+    for(int r = 0; r < no_ranks; ++r) {
+      wait_for("a rank", value_seq(r), seq);
+      std::copy(values(r, seq), values(r, seq) + k, all + r * k);
+    }
+  }
+
+  ~ShmTransport() {
+    if(base != nullptr) {
+      // every rank has mapped the segment once the first exchange is done
+      munmap(base, size);
+      if(rank == 0) {
+        shm_unlink(name.c_str());
+      }
+    }
+  }
+};
+
+// a ring of connections: each rank connects to the rank below and accepts the
+// rank above. transfers go through poll() on non-blocking sockets, so that
+// two ranks sending each other large rows at once cannot deadlock. the rows
+// of every generation are exchanged by one comm thread, woken for each
+class TcpTransport : public Transport {
+  int fd_up = -1, fd_down = -1;
+  std::vector<uint8_t> send_top, send_bottom, recv_top, recv_bottom;
+  std::thread comm;
+  std::mutex mtx;
+  std::condition_variable cv;
+  // exchanges begun and finished, and the length of their rows
+  uint64_t requested = 0, completed = 0;
+  size_t row_size = 0;
+  bool stopping = false;
+
+  struct Op {
+    int fd;
+    bool send;
+    uint8_t *data;
+    size_t size, done;
+  };
+
+  static void split_endpoint(const std::string &endpoint, std::string &host, std::string &port) {
+    const size_t colon = endpoint.rfind(':');
+    if(colon == std::string::npos) {
+      TERMINATE("[dist] endpoint '%s' is not host:port\n", endpoint.c_str());
+    }
+    host = endpoint.substr(0, colon), port = endpoint.substr(colon + 1);
+  }
+
+  void comm_loop() {
+    while(true) {
+      size_t n = 0;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&]() -> bool { return stopping || requested > completed; });
+        if(requested == completed) {
+          return;
+        }
+        n = row_size;
+      }
+      pump({
+        (Op){ .fd=fd_up, .send=true, .data=send_top.data(), .size=n, .done=0 },
+        (Op){ .fd=fd_down, .send=true, .data=send_bottom.data(), .size=n, .done=0 },
+        (Op){ .fd=fd_up, .send=false, .data=recv_top.data(), .size=n, .done=0 },
+        (Op){ .fd=fd_down, .send=false, .data=recv_bottom.data(), .size=n, .done=0 },
+      });
+      {
+        std::lock_guard<std::mutex> guard(mtx);
+        ++completed;
+      }
+      cv.notify_all();
+    }
+  }
+
+  static void pump(std::vector<Op> ops) {
+    const clock::time_point t0 = clock::now();
+    while(true) {
+      std::vector<pollfd> fds;
+      std::vector<size_t> which;
+      for(size_t i = 0; i < ops.size(); ++i) {
+        if(ops[i].done < ops[i].size) {
+          fds.push_back((pollfd){ .fd=ops[i].fd, .events=short(ops[i].send ? POLLOUT : POLLIN), .revents=0 });
+          which.push_back(i);
+        }
+      }
+      if(fds.empty()) {
+        return;
+      }
+      if(poll(fds.data(), fds.size(), 1000) < 0) {
+        TERMINATE("[dist] poll failed\n");
+      }
+      for(size_t j = 0; j < fds.size(); ++j) {
+        Op &op = ops[which[j]];
+        if(fds[j].revents & (POLLERR | POLLHUP | POLLNVAL) && !(fds[j].revents & POLLIN)) {
+          TERMINATE("[dist] connection lost\n");
+        }
+        if(!(fds[j].revents & (POLLIN | POLLOUT))) {
+          continue;
+        }
+        const ssize_t n = op.send ? send(op.fd, op.data + op.done, op.size - op.done, MSG_NOSIGNAL)
+                                  : recv(op.fd, op.data + op.done, op.size - op.done, 0);
+        if(n == 0 && !op.send) {
+          TERMINATE("[dist] connection closed\n");
+        }
+        if(n > 0) {
+          op.done += n;
+        }
+      }
+      if(std::chrono::duration<double>(clock::now() - t0).count() > timeout_seconds) {
+        TERMINATE("[dist] timed out on a transfer\n");
+      }
+    }
+  }
+public:
+  TcpTransport(const std::vector<std::string> &endpoints, int rank_) {
+    rank = rank_, no_ranks = int(endpoints.size());
+    std::string host, port;
+    split_endpoint(endpoints[rank], host, port);
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    const int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(uint16_t(std::stoi(port)));
+    if(bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 1) != 0) {
+      TERMINATE("[dist] rank %d: unable to listen on port %s\n", rank, port.c_str());
+    }
+    // the rank below may still be starting
+    split_endpoint(endpoints[down()], host, port);
+    const clock::time_point t0 = clock::now();
+    while(fd_down < 0) {
+      addrinfo hints = {}, *res = nullptr;
+      hints.ai_family = AF_INET, hints.ai_socktype = SOCK_STREAM;
+      if(getaddrinfo(host.c_str(), port.c_str(), &hints, &res) == 0) {
+        fd_down = socket(AF_INET, SOCK_STREAM, 0);
+        if(connect(fd_down, res->ai_addr, res->ai_addrlen) != 0) {
+          close(fd_down);
+          fd_down = -1;
+        }
+        freeaddrinfo(res);
+      }
+      if(fd_down < 0) {
+        if(std::chrono::duration<double>(clock::now() - t0).count() > timeout_seconds) {
+          TERMINATE("[dist] rank %d: unable to connect to %s\n", rank, endpoints[down()].c_str());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      }
+    }
+    fd_up = accept(listener, nullptr, nullptr);
+    close(listener);
+    if(fd_up < 0) {
+      TERMINATE("[dist] rank %d: accept failed\n", rank);
+    }
+    // each side names itself, so that a misconfigured ring fails loudly
+    int32_t me = rank, them = -1;
+    pump({
+      (Op){ .fd=fd_down, .send=true, .data=(uint8_t *)&me, .size=sizeof(me), .done=0 },
+      (Op){ .fd=fd_up, .send=false, .data=(uint8_t *)&them, .size=sizeof(them), .done=0 },
+    });
+    if(them != up()) {
+      TERMINATE("[dist] rank %d: expected rank %d above, got %d\n", rank, up(), them);
+    }
+    for(const int fd : {fd_up, fd_down}) {
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    Logger::Info("[dist] rank %d of %d: tcp, listening on %s\n", rank, no_ranks, endpoints[rank].c_str());
+    comm = std::thread([this]() mutable -> void {
+      comm_loop();
+    });
+  }
+
+  // the comm thread only touches the buffers between these two
+  void begin_exchange(const uint8_t *top, const uint8_t *bottom, size_t n) override {
+    send_top.assign(top, top + n), send_bottom.assign(bottom, bottom + n);
+    recv_top.resize(n), recv_bottom.resize(n);
+    {
+      std::lock_guard<std::mutex> guard(mtx);
+      row_size = n;
+      ++requested;
+    }
+    cv.notify_all();
+  }
+
+  void end_exchange(uint8_t *ghost_top, uint8_t *ghost_bottom, size_t n) override {
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv.wait(lock, [&]() -> bool { return completed == requested; });
+    }
+    std::copy(recv_top.begin(), recv_top.begin() + n, ghost_top);
+    std::copy(recv_bottom.begin(), recv_bottom.begin() + n, ghost_bottom);
+  }
+
+  // around the ring: in step s every rank passes on the block it received in step s-1
+  void allgather(const uint64_t *mine, size_t k, uint64_t *all) override {
+    std::copy(mine, mine + k, all + rank * k);
+    for(int s = 0; s + 1 < no_ranks; ++s) {
+      const int out = (rank - s + no_ranks) % no_ranks, in = (rank - s - 1 + no_ranks) % no_ranks;
+      pump({
+        (Op){ .fd=fd_down, .send=true, .data=(uint8_t *)(all + out * k), .size=k * sizeof(uint64_t), .done=0 },
+        (Op){ .fd=fd_up, .send=false, .data=(uint8_t *)(all + in * k), .size=k * sizeof(uint64_t), .done=0 },
+      });
+    }
+  }
+
+  ~TcpTransport() {
+    {
+      std::lock_guard<std::mutex> guard(mtx);
+      stopping = true;
+    }
+    cv.notify_all();
+    if(comm.joinable()) {
+      comm.join();
+    }
+    for(const int fd : {fd_up, fd_down}) {
+      if(fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+};
+
+#endif
+
+// "shm:/name" or "tcp:host:port,host:port,..." with one endpoint per rank
+inline std::unique_ptr<Transport> make_transport(const std::string &spec, int rank, int no_ranks, size_t row_size) {
+#if __unix__ || __linux__ || __APPLE__
+  if(spec.compare(0, 4, "shm:") == 0) {
+    return std::make_unique<ShmTransport>(spec.substr(4), rank, no_ranks, row_size);
+  }
+  if(spec.compare(0, 4, "tcp:") == 0) {
+    std::vector<std::string> endpoints;
+    for(size_t i = 4, j; i <= spec.size(); i = j + 1) {
+      j = std::min(spec.find(',', i), spec.size());
+      endpoints.push_back(spec.substr(i, j - i));
+    }
+    if(int(endpoints.size()) != no_ranks) {
+      TERMINATE("[dist] %lu endpoints for %d ranks\n", endpoints.size(), no_ranks);
+    }
+    return std::make_unique<TcpTransport>(endpoints, rank);
+  }
+#endif
+  TERMINATE("[dist] unknown transport '%s'\n", spec.c_str());
+  return nullptr;
+}
+
+struct Options {
+  int no_ranks = 1;
+  // -1: start the other ranks on this machine and run rank 0
+  int rank = -1;
+  std::string transport = "";
+  int w = 1024, h = 1024;
+  size_t generations = 1000;
+  int max_period = 0;
+  // arguments to start the other ranks with
+  std::vector<std::string> args;
+};
+
+// starts ranks 1..no_ranks-1 as copies of this executable
+inline std::vector<pid_t> spawn_ranks(const Options &opts) {
+  std::vector<pid_t> pids;
+#if __unix__ || __linux__ || __APPLE__
+#ifdef __linux__
+  const std::string exec = "/proc/self/exe";
+#else
+  const std::string exec = opts.args.front();
+#endif
+  for(int r = 1; r < opts.no_ranks; ++r) {
+    std::vector<std::string> args = opts.args;
+    for(const std::string &arg : {std::string("--rank"), std::to_string(r), std::string("--transport"), opts.transport, std::string("--seed"), std::to_string(rng::get_seed())}) {
+      args.push_back(arg);
+    }
+    std::vector<char *> argv;
+    for(std::string &arg : args) {
+      argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    pid_t pid;
+    if(posix_spawn(&pid, exec.c_str(), nullptr, nullptr, argv.data(), environ) != 0) {
+      TERMINATE("[dist] unable to start rank %d\n", r);
+    }
+    pids.push_back(pid);
+  }
+#endif
+  return pids;
+}
+
+// the rows [y0, y1) of the board, with a ghost row above and below and a
+// column of padding on either side for the horizontal wrap
+template <typename AUT>
+class Strip {
+  AUT &aut;
+  Transport &transport;
+  const int w, h, y0, y1, sh, stride;
+  std::vector<uint8_t, mem::uninitialized_allocator<uint8_t>> buf1, buf2;
+  uint8_t *src, *dst;
+
+  uint8_t *row(uint8_t *buf, int y) const {
+    return &buf[size_t(y) * stride];
+  }
+
+  static void wrap_row(uint8_t *r, int w) {
+    r[0] = r[w], r[w + 1] = r[1];
+  }
+
+  // local rows [from, to); row 1 is the first row of the strip
+  uint64_t compute_rows(int from, int to) {
+    uint64_t delta = 0;
+    #pragma omp parallel for schedule(static) reduction(^:delta)
+    for(int y = from; y < to; ++y) {
+      uint8_t *out = row(dst, y);
+      if constexpr(has_row_kernel<AUT>) {
+        aut.next_row(row(src, y - 1), row(src, y), row(src, y + 1), out, 1, w + 1);
+      } else {
+        const uint8_t *s = src;
+        const int st = stride, ww = w;
+        auto &&grid = make_grid<4>([=](int y, int x) mutable -> uint8_t {
+          return s[size_t(y) * st + ((x % ww) + ww) % ww + 1];
+        }, w, sh + 2);
+        for(int x = 0; x < w; ++x) {
+          out[x + 1] = aut.next_state(grid, y, x);
+        }
+      }
+      wrap_row(out, w);
+      const uint8_t *in = row(src, y);
+      for(int x = 1; x <= w; ++x) {
+        if(in[x] != out[x]) {
+          const uint32_t index = uint32_t(y0 + y - 1) * w + (x - 1);
+          delta ^= period::key(index, in[x]) ^ period::key(index, out[x]);
+        }
+      }
+    }
+    return delta;
+  }
+public:
+  Strip(AUT &aut, Transport &transport, int w, int h):
+    aut(aut), transport(transport), w(w), h(h),
+    y0(int(int64_t(h) * transport.rank / transport.no_ranks)),
+    y1(int(int64_t(h) * (transport.rank + 1) / transport.no_ranks)),
+    sh(y1 - y0), stride(w + 2)
+  {
+    ASSERT(sh > 0);
+    buf1.resize(size_t(sh + 2) * stride);
+    buf2.resize(buf1.size());
+    src = buf1.data(), dst = buf2.data();
+    // first touch in the schedule of compute_rows
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < sh + 2; ++y) {
+      std::fill_n(row(dst, y), stride, 0);
+      uint8_t *r = row(src, y);
+      for(int x = 0; x < w; ++x) {
+        r[x + 1] = (y >= 1 && y <= sh) ? aut.init_state(y0 + y - 1, x) : 0;
+      }
+      wrap_row(r, w);
+    }
+    Logger::Info("[dist] rank %d: rows [%d, %d) of %dx%d\n", transport.rank, y0, y1, w, h);
+  }
+
+  uint64_t hash() const {
+    uint64_t hh = 0;
+    #pragma omp parallel for schedule(static) reduction(^:hh)
+    for(int y = 1; y <= sh; ++y) {
+      const uint8_t *r = &src[size_t(y) * stride];
+      for(int x = 0; x < w; ++x) {
+        hh ^= period::key(uint32_t(y0 + y - 1) * w + x, r[x + 1]);
+      }
+    }
+    return hh;
+  }
+
+  std::vector<uint64_t> count_states() const {
+    std::vector<uint64_t> counts(aut.no_states, 0);
+    for(int y = 1; y <= sh; ++y) {
+      const uint8_t *r = &src[size_t(y) * stride];
+      for(int x = 1; x <= w; ++x) {
+        ++counts[r[x]];
+      }
+    }
+    return counts;
+  }
+
+  // the rows next to the ghost rows wait for the exchange, the interior does not
+  uint64_t step() {
+    transport.begin_exchange(row(src, 1) + 1, row(src, sh) + 1, w);
+    uint64_t delta = (sh > 2) ? compute_rows(2, sh) : 0;
+    transport.end_exchange(row(src, 0) + 1, row(src, sh + 1) + 1, w);
+    wrap_row(row(src, 0), w);
+    wrap_row(row(src, sh + 1), w);
+    delta ^= compute_rows(1, 2);
+    if(sh > 1) {
+      delta ^= compute_rows(sh, sh + 1);
+    }
+    std::swap(src, dst);
+    return delta;
+  }
+};
+
+template <typename AUT>
+void run(AUT &aut, Options opts) {
+  std::vector<pid_t> pids;
+  if(opts.rank < 0) {
+    opts.rank = 0;
+    if(opts.transport.empty()) {
+      opts.transport = "shm:/automaton-" + std::to_string(getpid());
+    }
+    pids = spawn_ranks(opts);
+  }
+  if(opts.h < opts.no_ranks) {
+    TERMINATE("[dist] %d rows cannot be split into %d strips\n", opts.h, opts.no_ranks);
+  }
+  std::unique_ptr<Transport> transport = make_transport(opts.transport, opts.rank, opts.no_ranks, opts.w);
+  Strip<AUT> strip(aut, *transport, opts.w, opts.h);
+  // the global hash needs a round trip every generation, so it is only kept for period detection
+  period::Detector detector;
+  detector.reset(opts.max_period);
+  uint64_t grid_hash = strip.hash();
+  std::vector<uint64_t> gathered(opts.no_ranks);
+  auto &&reduce_hash = [&](uint64_t h) mutable -> uint64_t {
+    transport->allgather(&h, 1, gathered.data());
+    uint64_t total = 0;
+    for(const uint64_t g : gathered) {
+      total ^= g;
+    }
+    return total;
+  };
+  if(detector.enabled()) {
+    detector.push(0, reduce_hash(grid_hash));
+  }
+  const clock::time_point t0 = clock::now();
+  size_t generation = 0;
+  while(generation < opts.generations) {
+    const uint64_t delta = strip.step();
+    grid_hash ^= delta;
+    ++generation;
+    if(detector.enabled() && detector.push(generation, reduce_hash(grid_hash))) {
+      if(opts.rank == 0) {
+        Logger::Info("generation %lu repeats generation %lu: period %d\n", generation, detector.since, detector.period);
+      }
+      break;
+    }
+  }
+  const double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+  // summary on rank 0: cells per state and the hash of the whole board
+  std::vector<uint64_t> counts = strip.count_states();
+  counts.push_back(grid_hash);
+  std::vector<uint64_t> all(counts.size() * opts.no_ranks);
+  transport->allgather(counts.data(), counts.size(), all.data());
+  if(opts.rank == 0) {
+    std::vector<uint64_t> total(counts.size(), 0);
+    for(int r = 0; r < opts.no_ranks; ++r) {
+      for(size_t s = 0; s < counts.size(); ++s) {
+        total[s] = (s + 1 == counts.size()) ? total[s] ^ all[r * counts.size() + s] : total[s] + all[r * counts.size() + s];
+      }
+    }
+    const size_t no_cells = size_t(opts.w) * opts.h;
+    uint64_t population = 0;
+    for(int s = 1; s < aut.no_states; ++s) {
+      population += total[s];
+    }
+    Logger::Info("generation %lu: population %lu of %lu, hash %016lx\n", generation, population, no_cells, total.back());
+    Logger::Info("[dist] %d ranks: %.2f s, %.1f Mcells/s\n", opts.no_ranks, seconds, double(no_cells) * generation / seconds * 1e-6);
+  }
+  transport.reset();
+  for(const pid_t pid : pids) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      Logger::Warning("[dist] a rank exited abnormally\n");
+    }
+  }
+}
+
+} // namespace dist
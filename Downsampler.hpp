@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <File.hpp>
+
+#include <ShaderProgram.hpp>
+#include <ShaderUniform.hpp>
+#include <Texture.hpp>
+
+using namespace std::literals::string_literals;
+
+// for negative zoom factors: sums blocks of the simulation texture into a
+// display-resolution texture on the gpu, so that only the small texture is sampled
+struct Downsampler {
+  gl::Uniform<gl::UniformType::SAMPLER2D> uSrcTex, uDstTex;
+  gl::Uniform<gl::UniformType::IVEC2> uDstSize, uBlock;
+  gl::Uniform<gl::UniformType::FLOAT> uScaleStates;
+  gl::ShaderProgram<gl::ComputeShader> program;
+
+  using ShaderProgramCompute = decltype(program);
+
+  static constexpr int local_size = 8;
+  GLuint tex = 0;
+  glm::ivec2 size = glm::ivec2(0, 0);
+  glm::ivec2 block = glm::ivec2(1, 1);
+  float scale_states = 1;
+
+  explicit Downsampler(const std::string &dir):
+    uSrcTex("srcTex"s), uDstTex("dstTex"s),
+    uDstSize("dst_size"s), uBlock("block"s),
+    uScaleStates("scale_states"s),
+    program({std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("downsample.comp"s))})
+  {}
+
+  // the display texture holds values up to no_states - 1, each summing block.x * block.y cells
+  void init(int tw, int th, glm::ivec2 block_, float scale_states_) {
+    size = glm::ivec2(tw, th);
+    block = block_;
+    scale_states = scale_states_;
+    gl::Texture<GL_TEXTURE_2D>::init(tex);
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, tw, th, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    ShaderProgramCompute::compile_program(program);
+    program.assign_uniforms(uSrcTex, uDstTex, uDstSize, uBlock, uScaleStates);
+    Logger::Info("[downsample %dx%d blocks of %dx%d]\n", tw, th, block.x, block.y);
+  }
+
+  void run(GLuint srctex) {
+    ShaderProgramCompute::use(program);
+    uSrcTex.set_data(0);
+    uDstTex.set_data(1);
+    uDstSize.set_data(size);
+    uBlock.set_data(block);
+    uScaleStates.set_data(scale_states);
+    glBindImageTexture(0, srctex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8UI); GLERROR
+    glBindImageTexture(1, tex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI); GLERROR
+    ShaderProgramCompute::dispatch((size.x + local_size - 1) / local_size, (size.y + local_size - 1) / local_size, 1);
+    ShaderProgramCompute::barrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    ShaderProgramCompute::unuse();
+  }
+
+  GLuint get_texture() const {
+    return tex;
+  }
+
+  bool is_active() const {
+    return tex != 0;
+  }
+
+  void clear() {
+    if(!is_active()) {
+      return;
+    }
+    gl::Texture<GL_TEXTURE_2D>::clear(tex);
+    tex = 0;
+    ShaderProgramCompute::clear(program);
+    ShaderProgramCompute::unassign_uniforms(uSrcTex, uDstTex, uDstSize, uBlock, uScaleStates);
+  }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+
+namespace gl {
+
+// sync object placed after gpu work whose results are read back later
+struct Fence {
+  static void init(GLsync &sync) {
+    sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); GLERROR
+  }
+
+  // non-blocking unless wait is set
+  static bool is_signaled(GLsync sync, bool wait=false) {
+    const GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+    const GLenum status = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout); GLERROR
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+  }
+
+  static void clear(GLsync &sync) {
+    if(sync != nullptr) {
+      glDeleteSync(sync); GLERROR
+    }
+    sync = nullptr;
+  }
+};
+
+} // namespace gl
@@ -64,6 +64,36 @@ std::string get_cwd() {
   return buf;
 }
 
+// per-user directory for caches (measurements, compiled programs), created on demand
+std::string get_cache_directory() {
+  std::string base = "";
+#if defined(_POSIX_VERSION)
+  const char *xdg_cache = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  if(xdg_cache != nullptr && xdg_cache[0] != '\0') {
+    base = xdg_cache;
+  } else if(home != nullptr && home[0] != '\0') {
+    base = std::string(home) + "/.cache";
+    mkdir(base.c_str(), 0755);
+  }
+#else
+  const char *local_appdata = getenv("LOCALAPPDATA");
+  if(local_appdata != nullptr) {
+    base = local_appdata;
+  }
+#endif
+  if(base.empty()) {
+    return get_cwd();
+  }
+  const std::string dir = std::string(Path(base) / Path(std::string("automaton")));
+#if defined(_POSIX_VERSION)
+  mkdir(dir.c_str(), 0755);
+#else
+  _mkdir(dir.c_str());
+#endif
+  return dir;
+}
+
 std::string get_executable_directory(int argc, char *argv[]) {
 #ifdef __linux__
   std::vector<char> buf(PATH_MAX);
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <File.hpp>
+#include <PNGEncoder.hpp>
+
+enum export_format {
+  // 8-bit grayscale frames concatenated into a file or a pipe
+  RAW,
+  // one png file per frame, the path a pattern with one integer conversion such as %06lu
+  PNG,
+  NO_EXPORT_FORMATS
+};
+
+// writes every n-th generation on a separate thread.
+// the queue is bounded: when the writer falls behind, new frames are dropped
+// instead of stalling the simulation loop
+struct FrameExporter {
+  struct Frame {
+    size_t generation = 0;
+    int w = 0, h = 0;
+    std::vector<uint8_t> data;
+  };
+
+  const std::string path;
+  const export_format format;
+  const int every;
+  const size_t max_queue;
+  uint8_t palette[256];
+
+  FILE *fp = nullptr;
+  bool is_pipe = false;
+  // a png path around its conversion, which the generation replaces padded to width
+  struct Pattern {
+    std::string prefix, suffix;
+    int width = 0;
+    bool zero_pad = false;
+  } pattern;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<Frame> queue;
+  std::vector<std::vector<uint8_t>> free_buffers;
+  bool stopping = false;
+  size_t no_written = 0, no_dropped = 0;
+  std::thread writer;
+
+  static export_format format_from_path(const std::string &path) {
+    if(sys::File(path.c_str()).is_ext(".png")) {
+      return export_format::PNG;
+    }
+    return export_format::RAW;
+  }
+
+  // the path is never used as a format: it must have exactly one conversion of
+  // an unsigned or signed integer (%d, %u, %lu, %zu, with a width and 0 flag),
+  // and %% stands for a percent sign
+  static bool parse_pattern(const std::string &path, Pattern &pattern, std::string &error) {
+    pattern = Pattern();
+    int no_conversions = 0;
+    for(size_t i = 0; i < path.length(); ++i) {
+      std::string &out = (no_conversions == 0) ? pattern.prefix : pattern.suffix;
+      if(path[i] != '%') {
+        out += path[i];
+        continue;
+      } else if(i + 1 < path.length() && path[i + 1] == '%') {
+        out += '%';
+        ++i;
+        continue;
+      }
+      size_t j = i + 1;
+      Pattern p;
+      if(j < path.length() && path[j] == '0') {
+        p.zero_pad = true;
+        ++j;
+      }
+      for(; j < path.length() && isdigit((unsigned char)path[j]); ++j) {
+        p.width = p.width * 10 + (path[j] - '0');
+        if(p.width > 64) {
+          error = "width of the conversion is above 64";
+          return false;
+        }
+      }
+      while(j < path.length() && (path[j] == 'l' || path[j] == 'z')) {
+        ++j;
+      }
+      if(j == path.length() || (path[j] != 'd' && path[j] != 'u' && path[j] != 'i')) {
+        error = "'" + path.substr(i, j + 1 - i) + "' is not an integer conversion";
+        return false;
+      } else if(++no_conversions > 1) {
+        error = "more than one conversion";
+        return false;
+      }
+      pattern.width = p.width, pattern.zero_pad = p.zero_pad;
+      i = j;
+    }
+    if(no_conversions == 0) {
+      error = "no conversion for the generation, e.g. frames/%06lu.png";
+      return false;
+    }
+    return true;
+  }
+
+  std::string frame_path(size_t generation) const {
+    std::string number = std::to_string(generation);
+    if(int(number.length()) < pattern.width) {
+      number.insert(0, pattern.width - number.length(), pattern.zero_pad ? '0' : ' ');
+    }
+    return pattern.prefix + number + pattern.suffix;
+  }
+
+  explicit FrameExporter(const std::string &path, int no_states, int every=1, size_t max_queue=8):
+    path(path),
+    format(format_from_path(path)),
+    every(std::max(every, 1)),
+    max_queue(std::max<size_t>(max_queue, 1))
+  {
+    // same mapping as the grayscale color scheme in aut4.frag
+    for(int i = 0; i < 256; ++i) {
+      palette[i] = (no_states < 2) ? 0 : std::min(255, i * 255 / (no_states - 1));
+    }
+    std::string error;
+    if(format == export_format::PNG && !parse_pattern(path, pattern, error)) {
+      TERMINATE("export pattern '%s': %s\n", path.c_str(), error.c_str());
+    }
+    if(format == export_format::RAW) {
+      if(path == "-") {
+        fp = stdout;
+      } else if(!path.empty() && path[0] == '|') {
+        fp = popen(path.c_str() + 1, "w");
+        is_pipe = true;
+      } else {
+        fp = fopen(path.c_str(), "wb");
+      }
+      if(fp == nullptr) {
+        TERMINATE("unable to open export target '%s'\n", path.c_str());
+      }
+    }
+    Logger::Info("exporting every %d generation(s) to '%s' as %s\n", this->every, path.c_str(), (format == export_format::PNG) ? "png" : "raw");
+    writer = std::thread([this]() mutable -> void { this->run_writer(); });
+  }
+
+  bool wants(size_t generation) const {
+    return generation % every == 0;
+  }
+
+  // fill is called with a buffer to copy the grid into, only if the frame is not dropped
+  template <typename F>
+  void push(size_t generation, int w, int h, F &&fill) {
+    if(!wants(generation)) {
+      return;
+    }
+    Frame frame;
+    {
+      std::lock_guard<std::mutex> guard(mtx);
+      if(queue.size() >= max_queue) {
+        ++no_dropped;
+        return;
+      }
+      if(!free_buffers.empty()) {
+        frame.data = std::move(free_buffers.back());
+        free_buffers.pop_back();
+      }
+    }
+    frame.generation = generation;
+    frame.w = w, frame.h = h;
+    frame.data.resize(size_t(w) * h);
+    fill(frame.data);
+    {
+      std::lock_guard<std::mutex> guard(mtx);
+      queue.push_back(std::move(frame));
+    }
+    cv.notify_one();
+  }
+
+  void write_frame(Frame &frame) {
+    for(auto &px : frame.data) {
+      px = palette[px];
+    }
+    if(format == export_format::RAW) {
+      if(no_written == 0) {
+        Logger::Info("raw frames %dx%d, e.g. ffmpeg -f rawvideo -pix_fmt gray -s %dx%d -i %s out.mp4\n",
+                     frame.w, frame.h, frame.w, frame.h, is_pipe ? "-" : path.c_str());
+      }
+      fwrite(frame.data.data(), 1, frame.data.size(), fp);
+    } else {
+      const std::string filename = frame_path(frame.generation);
+      if(!PNGEncoder::write(filename.c_str(), frame.data.data(), frame.w, frame.h)) {
+        Logger::Warning("unable to write frame '%s'\n", filename.c_str());
+      }
+    }
+  }
+
+  void run_writer() {
+    while(true) {
+      Frame frame;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&]() -> bool { return stopping || !queue.empty(); });
+        if(queue.empty()) {
+          break;
+        }
+        frame = std::move(queue.front());
+        queue.pop_front();
+      }
+      write_frame(frame);
+      {
+        std::lock_guard<std::mutex> guard(mtx);
+        ++no_written;
+        free_buffers.push_back(std::move(frame.data));
+      }
+    }
+    if(fp != nullptr) {
+      fflush(fp);
+    }
+  }
+
+  ~FrameExporter() {
+    {
+      std::lock_guard<std::mutex> guard(mtx);
+      stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+    if(fp != nullptr && fp != stdout) {
+      is_pipe ? pclose(fp) : fclose(fp);
+    }
+    Logger::Info("export finished: %lu frames written, %lu dropped\n", no_written, no_dropped);
+  }
+};
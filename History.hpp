@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+
+// past generations within a memory budget, for stepping back and seeking.
+// every frame is stored as the xor of the tiles that changed since the frame
+// before it, and every keyframe_interval-th frame in full as well. xor deltas
+// undo themselves, so a frame is rebuilt from the nearest full frame on either
+// side, at most keyframe_interval / 2 deltas away. the oldest frames up to the
+// next keyframe are dropped once the budget is exceeded
+namespace history {
+
+class Store {
+  static constexpr int tile_size = 64;
+
+  struct Entry {
+    size_t generation = 0;
+    // the whole frame, on keyframes only
+    std::vector<uint8_t> frame;
+    // changed tiles since the previous entry, and the xor of their cells, packed tile by tile
+    std::vector<uint32_t> tiles;
+    std::vector<uint8_t> xors;
+
+    bool is_key() const {
+      return !frame.empty();
+    }
+
+    size_t bytes() const {
+      return frame.size() + tiles.size() * sizeof(uint32_t) + xors.size() + sizeof(Entry);
+    }
+  };
+
+  int w = 0, h = 0, tw = 0, th = 0;
+  std::deque<Entry> entries;
+  // the newest frame, which the next one is compared against
+  std::vector<uint8_t> newest;
+  size_t no_bytes = 0;
+  size_t since_keyframe = 0;
+public:
+  size_t budget = 0;
+  int keyframe_interval = 32;
+
+  bool enabled() const {
+    return budget > 0;
+  }
+
+  void reset(int w_, int h_, size_t budget_) {
+    w = w_, h = h_;
+    tw = (w + tile_size - 1) / tile_size, th = (h + tile_size - 1) / tile_size;
+    budget = budget_;
+    entries.clear();
+    newest.clear();
+    no_bytes = 0;
+    since_keyframe = 0;
+  }
+
+  bool empty() const {
+    return entries.empty();
+  }
+
+  size_t size() const {
+    return entries.size();
+  }
+
+  size_t bytes() const {
+    return no_bytes;
+  }
+
+  size_t first() const {
+    return entries.front().generation;
+  }
+
+  size_t last() const {
+    return entries.back().generation;
+  }
+
+  // the rectangle of cells of a tile
+  void tile_rect(uint32_t t, int &y0, int &y1, int &x0, int &x1) const {
+    y0 = int(t / tw) * tile_size, x0 = int(t % tw) * tile_size;
+    y1 = std::min(h, y0 + tile_size), x1 = std::min(w, x0 + tile_size);
+  }
+
+  void apply(const Entry &e, std::vector<uint8_t> &frame) const {
+    const uint8_t *x = e.xors.data();
+    for(const uint32_t t : e.tiles) {
+      int y0, y1, x0, x1;
+      tile_rect(t, y0, y1, x0, x1);
+      for(int y = y0; y < y1; ++y) {
+        uint8_t *row = &frame[size_t(y) * w];
+        for(int xx = x0; xx < x1; ++xx) {
+          row[xx] ^= *x++;
+        }
+      }
+    }
+  }
+
+  // frames must come in order of generation; generations may be skipped
+  void push(size_t generation, const std::vector<uint8_t> &frame) {
+    // after a rewind, the frame already recorded comes again
+    if(!enabled() || frame.size() != size_t(w) * h || (!entries.empty() && generation <= last())) {
+      return;
+    }
+    Entry e;
+    e.generation = generation;
+    if(!entries.empty()) {
+      std::vector<uint8_t> changed(tw * th, 0);
+      #pragma omp parallel for schedule(static)
+      for(int t = 0; t < tw * th; ++t) {
+        int y0, y1, x0, x1;
+        tile_rect(t, y0, y1, x0, x1);
+        for(int y = y0; y < y1 && !changed[t]; ++y) {
+          changed[t] = !std::equal(&frame[size_t(y) * w + x0], &frame[size_t(y) * w + x1], &newest[size_t(y) * w + x0]);
+        }
+      }
+      for(int t = 0; t < tw * th; ++t) {
+        if(!changed[t]) {
+          continue;
+        }
+        e.tiles.push_back(t);
+        int y0, y1, x0, x1;
+        tile_rect(t, y0, y1, x0, x1);
+        for(int y = y0; y < y1; ++y) {
+          for(int x = x0; x < x1; ++x) {
+            e.xors.push_back(frame[size_t(y) * w + x] ^ newest[size_t(y) * w + x]);
+          }
+        }
+      }
+    }
+    if(entries.empty() || ++since_keyframe >= size_t(keyframe_interval)) {
+      e.frame = frame;
+      since_keyframe = 0;
+    }
+    no_bytes += e.bytes();
+    entries.push_back(std::move(e));
+    newest = frame;
+    // drop whole keyframe intervals from the front, keeping the newest
+    while(no_bytes > budget) {
+      const auto next_key = std::find_if(entries.begin() + 1, entries.end(), [](const Entry &e) -> bool { return e.is_key(); });
+      if(next_key == entries.end()) {
+        break;
+      }
+      while(entries.begin() != next_key) {
+        no_bytes -= entries.front().bytes();
+        entries.pop_front();
+      }
+    }
+  }
+
+  // index of the newest entry at or before the generation
+  size_t find(size_t generation) const {
+    const auto it = std::upper_bound(entries.begin(), entries.end(), generation,
+      [](size_t g, const Entry &e) -> bool { return g < e.generation; });
+    return (it == entries.begin()) ? 0 : size_t(it - entries.begin()) - 1;
+  }
+
+  // the recorded generations next to one, for stepping
+  size_t before(size_t generation) const {
+    const size_t i = find(generation);
+    return entries[(i > 0 && entries[i].generation == generation) ? i - 1 : i].generation;
+  }
+
+  size_t after(size_t generation) const {
+    if(generation < first()) {
+      return first();
+    }
+    const size_t i = find(generation);
+    return entries[std::min(i + 1, entries.size() - 1)].generation;
+  }
+
+  // rebuilds the frame of the newest entry at or before the generation and returns its generation
+  size_t seek(size_t generation, std::vector<uint8_t> &frame) const {
+    const size_t i = find(generation);
+    // the nearest full frame before, after, or the newest frame
+    size_t before = i;
+    while(!entries[before].is_key()) {
+      --before;
+    }
+    size_t after = i;
+    while(after + 1 < entries.size() && !entries[after].is_key()) {
+      ++after;
+    }
+    if(!entries[after].is_key()) {
+      after = entries.size() - 1;
+    }
+    if(i - before <= after - i) {
+      frame = entries[before].frame;
+      for(size_t j = before + 1; j <= i; ++j) {
+        apply(entries[j], frame);
+      }
+    } else {
+      frame = entries[after].is_key() ? entries[after].frame : newest;
+      for(size_t j = after; j > i; --j) {
+        apply(entries[j], frame);
+      }
+    }
+    return entries[i].generation;
+  }
+
+  // forgets the frames after the generation, before the simulation goes on from it
+  void truncate(size_t generation) {
+    if(entries.empty() || generation >= last()) {
+      return;
+    }
+    const size_t i = find(generation);
+    seek(entries[i].generation, newest);
+    while(entries.size() > i + 1) {
+      no_bytes -= entries.back().bytes();
+      entries.pop_back();
+    }
+    since_keyframe = 0;
+    for(size_t j = entries.size() - 1; !entries[j].is_key(); --j) {
+      ++since_keyframe;
+    }
+  }
+};
+
+} // namespace history
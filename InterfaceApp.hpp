@@ -1,10 +1,12 @@
 #pragma once
 
 #include <cstring>
+#include <string>
 #include <vector>
 
 #include <String.hpp>
 #include <Window.hpp>
+#include <Automaton.hpp>
 
 #define NK_INCLUDE_FIXED_TYPES
 #define NK_INCLUDE_STANDARD_IO
@@ -23,8 +25,45 @@
 #define MAX_ELEMENT_BUFFER (128 * 1024)
 
 typedef struct _AutOptions {
-  int factor;
-  bool force_cpu;
+  int factor = 2;
+  bool force_cpu = false;
+  // unbounded plane of tiles instead of a board the size of the window, for rules that keep empty space empty
+  bool sparse = false;
+  // run without presenting frames, for a fixed number of generations
+  bool headless = false;
+  size_t generations = 1000;
+  // generations the cpu advances per sweep over the board (temporal blocking), 1 for plain sweeps
+  int temporal_block = 1;
+  // frame export: raw file, "-" for stdout, "|command" for a pipe, or "pattern%06lu.png"
+  std::string export_path = "";
+  int export_every = 1;
+  int export_queue = 8;
+  // frame timing overlay and chrome trace output
+  bool show_stats = false;
+  std::string trace_path = "";
+  // memory for rewinding past generations in the window, in MiB; 0 (the default) disables,
+  // as recording reads every frame back from the gpu
+  size_t history_mb = 0;
+  // seed of the initial soup, drawn from the clock unless given
+  bool has_seed = false;
+  uint32_t seed = 0;
+  // longest period the grid hash is checked for (0 disables), and whether to stop once periodic
+  int max_period = 64;
+  bool stop_periodic = false;
+  // cells per state of every generation, one tab-separated line each
+  std::string population_path = "";
+  // registry names or rulestrings to run one after another instead of the menu choice
+  std::vector<std::string> rules;
+  // soup search: census of this many random soups instead of opening a window
+  size_t no_soups = 0;
+  std::string census_path = "";
+  // board split into strips over this many processes (0 for a normal run); rank -1 starts them all here
+  int no_ranks = 0;
+  int rank = -1;
+  std::string transport = "";
+  int board_w = 1024, board_h = 1024;
+  // cells of three-dimensional rules along x, y and z
+  int volume_w = 256, volume_h = 256, volume_d = 256;
 } AutOptions;
 
 struct InterfaceApp {
@@ -43,90 +82,6 @@ struct InterfaceApp {
     NO_LINEAR
   };
 
-  enum Cellular : int {
-    // 2 states
-    REPLICATOR,
-    FREDKIN,
-    SEEDS,
-    LIVEORDIE,
-    FLOCK,
-    MAZECTRIC,
-    MAZE,
-    MAZECTRICMICE,
-    MAZEMICE,
-    GAMEOFLIFE,
-    EIGHTLIFE,
-    LONGLIFE,
-    TXT,
-    HIGHLIFE,
-    MOVE,
-    STAINS,
-    DAYANDNIGHT,
-    ANNEAL,
-    DRYLIFE,
-    PEDESTRLIFE,
-    AMOEBA,
-    DIAMOEBA,
-    LANGTONSANT,
-    // 3 states
-    BRIANSBRAIN,
-    BRAIN6,
-    FROGS,
-    LINES,
-    // 4 states
-    CATERPILLARS,
-    ORTHOGO,
-    SEDIMENTAL,
-    STARWARS,
-    WIREWORLD,
-    // 5 states
-    BANNERS,
-    GLISSERGY,
-    SPIRALS,
-    TRANSERS,
-    WANDERERS,
-    // 6 states
-    CHENILLE,
-    FROZENSPIRALS,
-    LIVINGONTHEEDGE,
-    PRAIRIEONFIRE,
-    RAKE,
-    SNAKE,
-    SOFTFREEZE,
-    STICKS,
-    WORMS,
-    // 7 states
-    GLISSERATI,
-    // 8 states
-    BELZHAB,
-    CIRCUITGENESIS,
-    COOTIES,
-    FLAMINGSTARBOWS,
-    LAVA,
-    METEORGUNS,
-    SWIRL,
-    // 9 states
-    BURST,
-    BURST2,
-    // 16 states
-    XTASY,
-    // 18 states
-    EBBANDFLOW,
-    EBBANDFLOW2,
-    // 21 states
-    FIREWORKS,
-    // 24 states
-    BLOOMERANG,
-    // 25 states
-    FADERS,
-    NOVA,
-    BOMBERS,
-    // 48 states
-    THRILLGRILL,
-    //
-    NO_CELLULAR
-  };
-
   enum Probabilistic : int {
     // 2 states
     ISING,
@@ -134,23 +89,72 @@ struct InterfaceApp {
   };
 
   enum AutomataType : int {
-    LINEAR, CELLULAR, PROBABILISTIC, NO_AUTOMATA_TYPES
+    LINEAR, CELLULAR, PROBABILISTIC, CONTINUOUS, VOLUME, BLOCK, NO_AUTOMATA_TYPES
   };
   const sys::Path root_path;
 
   const std::vector<int> factors = {-16, -8, -4, -3, -2, 1, 2, 4, 8, 16, 32};
   int factor = 2;
   int force_cpu = 0;
+  int show_stats = 0;
+  int sparse = 0;
   int autType = CELLULAR;
   int autStates = 2;
-  int autOption = Cellular::DAYANDNIGHT;
+  int autOption = cellular::find_rule("Day And Night");
+  // overrides the selected cellular automaton when it parses
+  char ruleBuffer[64] = "";
+  // what ruleBuffer held when it was last parsed, and what it parsed to
+  std::string parsedRule = "";
+  ca::RuleSpec ruleSpec;
+  std::string ruleStatus = "";
+  // of every cellular registry entry, parsed once
+  std::vector<int> registryStates;
   float isingBeta = .5;
   bool finished = false;
   bool shouldQuit = false;
 
   InterfaceApp(Window &w, const std::string &dir):
     w(w), root_path(dir)
-  {}
+  {
+    for(const cellular::RuleEntry &entry : cellular::registry) {
+      registryStates.push_back(entry.no_states());
+    }
+  }
+
+  void update_rule() {
+    if(parsedRule == ruleBuffer) {
+      return;
+    }
+    parsedRule = ruleBuffer;
+    std::string error;
+    if(parsedRule.empty()) {
+      ruleStatus = "";
+    } else if(cellular::is_ltl(parsedRule)) {
+      ruleStatus = "larger than life";
+    } else if(ruletable::is_table(parsedRule)) {
+      ruleStatus = "rule table";
+    } else if(cellular::resolve_rule(parsedRule, ruleSpec, error)) {
+      ruleStatus = std::to_string(ruleSpec.no_states) + " states";
+    } else {
+      ruleStatus = error;
+    }
+  }
+
+  static void load_font(struct nk_glfw &nkglfw, struct nk_context *ctx, const sys::Path &root_path, float height) {
+    struct nk_font_atlas *atlas;
+    nk_glfw3_font_stash_begin(&nkglfw, &atlas);
+    const sys::Path font_path = root_path / sys::Path("resources"s) / sys::Path("DroidSans.ttf"s);
+    Logger::Info("loading font from %s\n", std::string(font_path).c_str());
+    struct nk_font *droid = nk_font_atlas_add_from_file(atlas, std::string(font_path).c_str(), height, 0);
+    /*struct nk_font *roboto = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/Roboto-Regular.ttf", 14, 0);*/
+    /*struct nk_font *future = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/kenvector_future_thin.ttf", 13, 0);*/
+    /*struct nk_font *clean = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/ProggyClean.ttf", 12, 0);*/
+    /*struct nk_font *tiny = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/ProggyTiny.ttf", 10, 0);*/
+    /*struct nk_font *cousine = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/Cousine-Regular.ttf", 13, 0);*/
+    nk_glfw3_font_stash_end(&nkglfw);
+    /* nk_style_load_all_cursors(ctx, atlas->cursors); */
+    nk_style_set_font(ctx, &droid->handle);
+  }
 
   void run() {
     w.update_size();
@@ -160,21 +164,7 @@ struct InterfaceApp {
       [&](auto &w) mutable -> void {
         ctx = nk_glfw3_init(&nkglfw, g_window, NK_GLFW3_INSTALL_CALLBACKS);
         /* Logger::Info("ctx %p\n", ctx); */
-        {
-          struct nk_font_atlas *atlas;
-          nk_glfw3_font_stash_begin(&nkglfw, &atlas);
-          const sys::Path font_path = root_path / sys::Path("resources"s) / sys::Path("DroidSans.ttf"s);
-          Logger::Info("loading font from %s\n", std::string(font_path).c_str());
-          struct nk_font *droid = nk_font_atlas_add_from_file(atlas, std::string(font_path).c_str(), 24, 0);
-          /*struct nk_font *roboto = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/Roboto-Regular.ttf", 14, 0);*/
-          /*struct nk_font *future = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/kenvector_future_thin.ttf", 13, 0);*/
-          /*struct nk_font *clean = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/ProggyClean.ttf", 12, 0);*/
-          /*struct nk_font *tiny = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/ProggyTiny.ttf", 10, 0);*/
-          /*struct nk_font *cousine = nk_font_atlas_add_from_file(atlas, "nuklear/extra_font/Cousine-Regular.ttf", 13, 0);*/
-          nk_glfw3_font_stash_end(&nkglfw);
-          /* nk_style_load_all_cursors(ctx, atlas->cursors); */
-          nk_style_set_font(ctx, &droid->handle);
-        }
+        load_font(nkglfw, ctx, root_path, 24);
         background = nk_rgb(136,181,216);
       },
       // display
@@ -206,6 +196,24 @@ struct InterfaceApp {
             }
             autType = AutomataType::PROBABILISTIC;
           }
+          if(nk_option_label(ctx, "Continuous", autType == AutomataType::CONTINUOUS)) {
+            if(autType != AutomataType::CONTINUOUS) {
+              autOption = 0;
+            }
+            autType = AutomataType::CONTINUOUS;
+          }
+          if(nk_option_label(ctx, "3D", autType == AutomataType::VOLUME)) {
+            if(autType != AutomataType::VOLUME) {
+              autOption = 0;
+            }
+            autType = AutomataType::VOLUME;
+          }
+          if(nk_option_label(ctx, "Block", autType == AutomataType::BLOCK)) {
+            if(autType != AutomataType::BLOCK) {
+              autOption = 0;
+            }
+            autType = AutomataType::BLOCK;
+          }
           /* nk_group_end(ctx); */
           {
             char aut_states_s[256];
@@ -228,125 +236,24 @@ struct InterfaceApp {
               if (nk_option_label(ctx, "Rule 184" ,autOption == Linear::RULE184)) autOption = Linear::RULE184;
             }
           } else if(autType == AutomataType::CELLULAR) {
-            switch(autStates) {
-              case 2:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Replicator"     ,autOption == Cellular::REPLICATOR     )) autOption = Cellular::REPLICATOR;
-                if (nk_option_label(ctx, "Fredkin"        ,autOption == Cellular::FREDKIN        )) autOption = Cellular::FREDKIN;
-                if (nk_option_label(ctx, "Seeds"          ,autOption == Cellular::SEEDS          )) autOption = Cellular::SEEDS;
-                if (nk_option_label(ctx, "Live Or Die"    ,autOption == Cellular::LIVEORDIE      )) autOption = Cellular::LIVEORDIE;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Flock"          ,autOption == Cellular::FLOCK          )) autOption = Cellular::FLOCK;
-                if (nk_option_label(ctx, "Game Of Life"   ,autOption == Cellular::GAMEOFLIFE     )) autOption = Cellular::GAMEOFLIFE;
-                if (nk_option_label(ctx, "Mazectric"      ,autOption == Cellular::MAZECTRIC      )) autOption = Cellular::MAZECTRIC;
-                if (nk_option_label(ctx, "Maze"           ,autOption == Cellular::MAZE           )) autOption = Cellular::MAZE;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "MazectricMice"  ,autOption == Cellular::MAZECTRICMICE  )) autOption = Cellular::MAZECTRICMICE;
-                if (nk_option_label(ctx, "MazeMice"       ,autOption == Cellular::MAZEMICE       )) autOption = Cellular::MAZEMICE;
-                if (nk_option_label(ctx, "Eight Life"     ,autOption == Cellular::EIGHTLIFE      )) autOption = Cellular::EIGHTLIFE;
-                if (nk_option_label(ctx, "Long Life"      ,autOption == Cellular::LONGLIFE       )) autOption = Cellular::LONGLIFE;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "2x2"            ,autOption == Cellular::TXT            )) autOption = Cellular::TXT;
-                if (nk_option_label(ctx, "High Life"      ,autOption == Cellular::HIGHLIFE       )) autOption = Cellular::HIGHLIFE;
-                if (nk_option_label(ctx, "Move"           ,autOption == Cellular::MOVE           )) autOption = Cellular::MOVE;
-                if (nk_option_label(ctx, "Stains"         ,autOption == Cellular::STAINS         )) autOption = Cellular::STAINS;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Day And Night"  ,autOption == Cellular::DAYANDNIGHT    )) autOption = Cellular::DAYANDNIGHT;
-                if (nk_option_label(ctx, "Anneal"         ,autOption == Cellular::ANNEAL         )) autOption = Cellular::ANNEAL;
-                if (nk_option_label(ctx, "Dry Life"       ,autOption == Cellular::DRYLIFE        )) autOption = Cellular::DRYLIFE;
-                if (nk_option_label(ctx, "Pedestr Life"   ,autOption == Cellular::PEDESTRLIFE    )) autOption = Cellular::PEDESTRLIFE;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Amoeba"         ,autOption == Cellular::AMOEBA         )) autOption = Cellular::AMOEBA;
-                if (nk_option_label(ctx, "Diamoeba"       ,autOption == Cellular::DIAMOEBA       )) autOption = Cellular::DIAMOEBA;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Langton's Ant"  ,autOption == Cellular::LANGTONSANT    )) autOption = Cellular::LANGTONSANT;
-              break;
-              case 3:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Brian's Brain"  ,autOption == Cellular::BRIANSBRAIN    )) autOption = Cellular::BRIANSBRAIN;
-                if (nk_option_label(ctx, "Brain6"         ,autOption == Cellular::BRAIN6         )) autOption = Cellular::BRAIN6;
-                if (nk_option_label(ctx, "Frogs"          ,autOption == Cellular::FROGS          )) autOption = Cellular::FROGS;
-                if (nk_option_label(ctx, "Lines"          ,autOption == Cellular::LINES          )) autOption = Cellular::LINES;
-              break;
-              case 4:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Caterpillars"   ,autOption == Cellular::CATERPILLARS   ))autOption = Cellular::CATERPILLARS;
-                if (nk_option_label(ctx, "OrthoGo"        ,autOption == Cellular::ORTHOGO        )) autOption = Cellular::ORTHOGO;
-                if (nk_option_label(ctx, "SediMental"     ,autOption == Cellular::SEDIMENTAL     )) autOption = Cellular::SEDIMENTAL;
-                if (nk_option_label(ctx, "StarWars"       ,autOption == Cellular::STARWARS       )) autOption = Cellular::STARWARS;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Wireworld"      ,autOption == Cellular::WIREWORLD      )) autOption = Cellular::WIREWORLD;
-              break;
-              case 5:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Banners"        ,autOption == Cellular::BANNERS        )) autOption = Cellular::BANNERS;
-                if (nk_option_label(ctx, "Glissergy"      ,autOption == Cellular::GLISSERGY      )) autOption = Cellular::GLISSERGY;
-                if (nk_option_label(ctx, "Spirals"        ,autOption == Cellular::SPIRALS        )) autOption = Cellular::SPIRALS;
-                if (nk_option_label(ctx, "Transers"       ,autOption == Cellular::TRANSERS       )) autOption = Cellular::TRANSERS;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Wanderers"      ,autOption == Cellular::WANDERERS      )) autOption = Cellular::WANDERERS;
-              break;
-              case 6:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Chenille"       ,autOption == Cellular::CHENILLE       )) autOption = Cellular::CHENILLE;
-                if (nk_option_label(ctx, "FrozenSpirals"  ,autOption == Cellular::FROZENSPIRALS  )) autOption = Cellular::FROZENSPIRALS;
-                if (nk_option_label(ctx, "LivingOnTheEdge",autOption == Cellular::LIVINGONTHEEDGE)) autOption = Cellular::LIVINGONTHEEDGE;
-                if (nk_option_label(ctx, "PrairieOnFire"  ,autOption == Cellular::PRAIRIEONFIRE  )) autOption = Cellular::PRAIRIEONFIRE;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Rake"           ,autOption == Cellular::RAKE           )) autOption = Cellular::RAKE;
-                if (nk_option_label(ctx, "Snake"          ,autOption == Cellular::SNAKE          )) autOption = Cellular::SNAKE;
-                if (nk_option_label(ctx, "SoftFreeze"     ,autOption == Cellular::SOFTFREEZE     )) autOption = Cellular::SOFTFREEZE;
-                if (nk_option_label(ctx, "Sticks"         ,autOption == Cellular::STICKS         )) autOption = Cellular::STICKS;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Worms"          ,autOption == Cellular::WORMS          )) autOption = Cellular::WORMS;
-              break;
-              case 7:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Glisserati"     ,autOption == Cellular::GLISSERATI     )) autOption = Cellular::GLISSERATI;
-              break;
-              case 8:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "BelZhab"        ,autOption == Cellular::BELZHAB        )) autOption = Cellular::BELZHAB;
-                if (nk_option_label(ctx, "CircuitGenesis" ,autOption == Cellular::CIRCUITGENESIS )) autOption = Cellular::CIRCUITGENESIS;
-                if (nk_option_label(ctx, "Cooties"        ,autOption == Cellular::COOTIES        )) autOption = Cellular::COOTIES;
-                if (nk_option_label(ctx, "FlamingStarbows",autOption == Cellular::FLAMINGSTARBOWS)) autOption = Cellular::FLAMINGSTARBOWS;
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Lava"           ,autOption == Cellular::LAVA           )) autOption = Cellular::LAVA;
-                if (nk_option_label(ctx, "MeteorGuns"     ,autOption == Cellular::METEORGUNS     )) autOption = Cellular::METEORGUNS;
-                if (nk_option_label(ctx, "Swirl"          ,autOption == Cellular::SWIRL          )) autOption = Cellular::SWIRL;
-              break;
-              case 9:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Burst"          ,autOption == Cellular::BURST          )) autOption = Cellular::BURST;
-                if (nk_option_label(ctx, "Burst2"         ,autOption == Cellular::BURST2         )) autOption = Cellular::BURST2;
-              break;
-              case 16:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Xtasy"          ,autOption == Cellular::XTASY          )) autOption = Cellular::XTASY;
-              break;
-              case 18:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "EbbAndFlow"     ,autOption == Cellular::EBBANDFLOW     )) autOption = Cellular::EBBANDFLOW;
-                if (nk_option_label(ctx, "EbbAndFlow2"    ,autOption == Cellular::EBBANDFLOW2    )) autOption = Cellular::EBBANDFLOW2;
-              break;
-              case 21:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Fireworks"      ,autOption == Cellular::FIREWORKS      )) autOption = Cellular::FIREWORKS;
-              break;
-              case 24:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Bloomerang"     ,autOption == Cellular::BLOOMERANG     )) autOption = Cellular::BLOOMERANG;
-              break;
-              case 25:
-                nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "Faders"         ,autOption == Cellular::FADERS         )) autOption = Cellular::FADERS;
-                if (nk_option_label(ctx, "Nova"           ,autOption == Cellular::NOVA           )) autOption = Cellular::NOVA;
-                if (nk_option_label(ctx, "Bombers"        ,autOption == Cellular::BOMBERS        )) autOption = Cellular::BOMBERS;
-              break;
-              case 48:
+            int col = 0;
+            for(size_t i = 0; i < cellular::registry.size(); ++i) {
+              const cellular::RuleEntry &entry = cellular::registry[i];
+              if(registryStates[i] != autStates) {
+                continue;
+              }
+              if(col++ % 4 == 0) {
                 nk_layout_row_dynamic(ctx, 30, 4);
-                if (nk_option_label(ctx, "ThrillGrill"    ,autOption == Cellular::THRILLGRILL    )) autOption = Cellular::THRILLGRILL;
-              break;
+              }
+              if (nk_option_label(ctx, entry.name, autOption == int(i))) autOption = i;
+            }
+            nk_layout_row_dynamic(ctx, 30, 2);
+            nk_label(ctx, "Rule (B3/S23, B2/S34H, 23/3/3, R5,C0,M1,S34..58,B34..45,NM, path.rule)", NK_TEXT_LEFT);
+            nk_edit_string_zero_terminated(ctx, NK_EDIT_FIELD, ruleBuffer, sizeof(ruleBuffer), nk_filter_ascii);
+            update_rule();
+            if(!ruleStatus.empty()) {
+              nk_layout_row_dynamic(ctx, 30, 1);
+              nk_label(ctx, ruleStatus.c_str(), NK_TEXT_LEFT);
             }
           } else if(autType == AutomataType::PROBABILISTIC) {
             if(autStates == 2) {
@@ -360,6 +267,30 @@ struct InterfaceApp {
                 nk_slider_float(ctx, .010, &isingBeta, 10., .010);
               }
             }
+          } else if(autType == AutomataType::CONTINUOUS) {
+            // states in [0, 1], whatever the slider says
+            nk_layout_row_dynamic(ctx, 30, continuous::NO_RULES);
+            for(int i = 0; i < continuous::NO_RULES; ++i) {
+              if (nk_option_label(ctx, continuous::rule_names[i], autOption == i)) autOption = i;
+            }
+          } else if(autType == AutomataType::VOLUME) {
+            // of any number of states, whatever the slider says
+            int col = 0;
+            for(size_t i = 0; i < volume::registry.size(); ++i) {
+              if(col++ % 4 == 0) {
+                nk_layout_row_dynamic(ctx, 30, 4);
+              }
+              if (nk_option_label(ctx, volume::registry[i].name, autOption == int(i))) autOption = i;
+            }
+          } else if(autType == AutomataType::BLOCK) {
+            // margolus rules come with their own states
+            int col = 0;
+            for(size_t i = 0; i < margolus::registry.size(); ++i) {
+              if(col++ % 4 == 0) {
+                nk_layout_row_dynamic(ctx, 30, 4);
+              }
+              if (nk_option_label(ctx, margolus::registry[i].name, autOption == int(i))) autOption = i;
+            }
           }
           /* nk_group_end(ctx); */
 
@@ -370,9 +301,11 @@ struct InterfaceApp {
           for(const int f : factors) {
             if(nk_option_label(ctx, std::to_string(f).c_str(), factor == f)) factor = f;
           }
-          nk_layout_row_dynamic(ctx, 30, 2);
+          nk_layout_row_dynamic(ctx, 30, 4);
           nk_label(ctx, "Rendering", NK_TEXT_LEFT);
           nk_checkbox_label(ctx, "Force CPU", &force_cpu);
+          nk_checkbox_label(ctx, "Show stats", &show_stats);
+          nk_checkbox_label(ctx, "Infinite plane", &sparse);
           /* nk_group_end(ctx); */
 
 
@@ -6,10 +6,12 @@
 #include <type_traits>
 #include <utility>
 
+#include <Random.hpp>
+
 namespace la {
 
 inline uint8_t random(int y, int x, int no_states) {
-  return rand() % no_states;
+  return rng::random(y, x, no_states);
 }
 
 constexpr int DEAD = 0, LIVE = 1;
@@ -2,25 +2,153 @@
 
 #include <cstdarg>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
 
 #include <string>
-
-#ifdef FLAG_THREADS
+#include <vector>
+#include <tuple>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <mutex>
-#endif
+#include <condition_variable>
+#include <type_traits>
 
 #include <File.hpp>
 #include <Debug.hpp>
 
+enum log_level : int {
+  LOG_DEBUG, LOG_INFO, LOG_WARNING, LOG_ERROR
+};
+
+// messages below this level are compiled out
+#ifndef LOG_LEVEL
+  #ifndef NDEBUG
+    #define LOG_LEVEL LOG_DEBUG
+  #else
+    #define LOG_LEVEL LOG_INFO
+  #endif
+#endif
+
+// asynchronous logger: every thread appends binary records (format pointer
+// plus raw argument bytes) to its own lock-free ring, and a background thread
+// formats and writes them, merged across threads in the order they were
+// logged. strings are copied into the record, so temporaries such as
+// std::string::c_str() are safe to pass. the ring of a thread that exits goes
+// back to a free list, for the next thread that logs
 class Logger {
+  struct Record {
+    void (*print)(FILE *, const Record &) = nullptr;
+    const char *prefix = nullptr;
+    const char *fmt = nullptr;
+    // global order of the record, see next_seq
+    uint64_t seq = 0;
+    char payload[224];
+  };
+
+  // single producer (the owning thread), single consumer (the flusher)
+  struct Ring {
+    static constexpr size_t capacity = 4096;
+    alignas(64) std::atomic<size_t> head = 0;
+    alignas(64) std::atomic<size_t> tail = 0;
+    std::atomic<size_t> no_dropped = 0;
+    // whether a thread is logging into it; guarded by rings_mtx
+    bool owned = true;
+    Record records[capacity];
+
+    Record *reserve() {
+      const size_t h = head.load(std::memory_order_relaxed);
+      if(h - tail.load(std::memory_order_acquire) == capacity) {
+        return nullptr;
+      }
+      return &records[h % capacity];
+    }
+
+    void commit() {
+      head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t size() const {
+      return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+  };
+
+  template <typename T>
+  static constexpr bool is_string = std::is_same_v<std::decay_t<T>, const char *> || std::is_same_v<std::decay_t<T>, char *>;
+
+  template <typename T>
+  static constexpr size_t fixed_size() {
+    if constexpr(is_string<T>) {
+      return 1;
+    } else {
+      static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>, "unsupported log argument type");
+      return sizeof(T);
+    }
+  }
+
+  template <typename T>
+  static void encode(Record &r, size_t &off, size_t &spare, T arg) {
+    if constexpr(is_string<T>) {
+      const char *s = (arg != nullptr) ? arg : "(null)";
+      const size_t len = strnlen(s, spare);
+      memcpy(&r.payload[off], s, len);
+      r.payload[off + len] = '\0';
+      off += len + 1, spare -= len;
+    } else {
+      memcpy(&r.payload[off], &arg, sizeof(T));
+      off += sizeof(T);
+    }
+  }
+
+  template <typename T>
+  static auto decode(const Record &r, size_t &off) {
+    if constexpr(is_string<T>) {
+      const char *s = &r.payload[off];
+      off += strlen(s) + 1;
+      return s;
+    } else {
+      T val;
+      memcpy(&val, &r.payload[off], sizeof(T));
+      off += sizeof(T);
+      return val;
+    }
+  }
+
+  template <typename... Ts>
+  static void print_record(FILE *file, const Record &r) {
+    size_t off = 0;
+    // braced initialization decodes the arguments left to right
+    std::tuple<decltype(decode<Ts>(r, off))...> args{decode<Ts>(r, off)...};
+    fputs(r.prefix, file);
+    std::apply([&](auto... vals) mutable -> void {
+      #pragma GCC diagnostic push
+      #pragma GCC diagnostic ignored "-Wformat-security"
+      #pragma GCC diagnostic ignored "-Wformat-nonliteral"
+      fprintf(file, r.fmt, vals...);
+      #pragma GCC diagnostic pop
+    }, args);
+  }
+
   std::string filename;
   FILE *file = nullptr;
 
+  std::mutex rings_mtx;
+  std::vector<std::unique_ptr<Ring>> rings;
+  std::atomic<uint64_t> next_seq = 0;
+
+  std::mutex flush_mtx;
+  std::condition_variable flush_cv, flushed_cv;
+  size_t flush_requested = 0, flush_done = 0;
+  std::atomic<bool> wakeup = false;
+  bool stopping = false;
+  std::thread flusher;
+
   static char *log_file;
   static FILE *log_file_ptr;
-#ifdef FLAG_THREADS
-  std::mutex mtx;
-#endif
+  static Logger *instance;
 
   explicit Logger(const char *filename):
     filename(filename)
@@ -32,31 +160,179 @@ class Logger {
     #else
       file = stdout;
     #endif
+    flusher = std::thread([this]() mutable -> void { this->run_flusher(); });
   }
   ~Logger() {
+    {
+      std::lock_guard<std::mutex> guard(flush_mtx);
+      stopping = true;
+    }
+    flush_cv.notify_one();
+    flusher.join();
     if(file != nullptr && file != stdout && file != stderr) {
       fclose(file);
     }
   }
-  void Write(const char *fmt, va_list args) {
-#ifdef FLAT_THREADS
-    std::lock_guard<std::mutex> guard(mtx);
-#endif
-    if(file == nullptr)return;
-    ASSERT(file != nullptr);
-    vfprintf(file, fmt, args);
-    fflush(file);
-  }
-  void WriteFmt(const char *prefix, const char *fmt, va_list args) {
-#ifdef FLAT_THREADS
-    std::lock_guard<std::mutex> guard(mtx);
-#endif
-    if(file == nullptr)return;
-    ASSERT(file != nullptr);
-    vfprintf(file, (std::string() + prefix + fmt).c_str(), args);
-    fflush(file);
+
+  // gives the ring back when its thread exits, unless the logger is gone by then
+  struct RingOwner {
+    Logger *logger = nullptr;
+    Ring *ring = nullptr;
+
+    ~RingOwner() {
+      if(logger != nullptr && logger == instance) {
+        logger->release_ring(ring);
+      }
+    }
+  };
+
+  Ring *get_ring() {
+    thread_local RingOwner owner;
+    if(owner.logger != this) {
+      std::lock_guard<std::mutex> guard(rings_mtx);
+      owner.ring = nullptr;
+      // a free ring is reused once the flusher has written out what it holds
+      for(auto &ring : rings) {
+        if(!ring->owned && ring->size() == 0) {
+          owner.ring = ring.get();
+          break;
+        }
+      }
+      if(owner.ring == nullptr) {
+        rings.emplace_back(new Ring());
+        owner.ring = rings.back().get();
+      }
+      owner.ring->owned = true;
+      owner.logger = this;
+    }
+    return owner.ring;
+  }
+
+  void release_ring(Ring *ring) {
+    std::lock_guard<std::mutex> guard(rings_mtx);
+    ring->owned = false;
+  }
+
+  // writes the records of all rings, lowest sequence number first
+  void drain() {
+    std::lock_guard<std::mutex> guard(rings_mtx);
+    const size_t no_rings = rings.size();
+    std::vector<size_t> tails(no_rings), heads(no_rings);
+    for(size_t i = 0; i < no_rings; ++i) {
+      tails[i] = rings[i]->tail.load(std::memory_order_relaxed);
+      heads[i] = rings[i]->head.load(std::memory_order_acquire);
+    }
+    while(true) {
+      size_t next = no_rings;
+      uint64_t seq = UINT64_MAX;
+      for(size_t i = 0; i < no_rings; ++i) {
+        if(tails[i] != heads[i] && rings[i]->records[tails[i] % Ring::capacity].seq < seq) {
+          next = i, seq = rings[i]->records[tails[i] % Ring::capacity].seq;
+        }
+      }
+      if(next == no_rings) {
+        break;
+      }
+      const Record &r = rings[next]->records[tails[next] % Ring::capacity];
+      if(file != nullptr) {
+        r.print(file, r);
+      }
+      rings[next]->tail.store(++tails[next], std::memory_order_release);
+    }
+    for(auto &ring : rings) {
+      const size_t no_dropped = ring->no_dropped.exchange(0);
+      if(no_dropped && file != nullptr) {
+        fprintf(file, "WARN: logger dropped %lu records\n", no_dropped);
+      }
+    }
+    if(file != nullptr) {
+      fflush(file);
+    }
+  }
+
+  void run_flusher() {
+    while(true) {
+      size_t ticket;
+      bool stop;
+      {
+        std::unique_lock<std::mutex> lock(flush_mtx);
+        flush_cv.wait_for(lock, std::chrono::milliseconds(20), [&]() -> bool {
+          return stopping || flush_requested > flush_done || wakeup.load();
+        });
+        wakeup = false;
+        ticket = flush_requested;
+        stop = stopping;
+      }
+      drain();
+      {
+        std::lock_guard<std::mutex> guard(flush_mtx);
+        flush_done = ticket;
+      }
+      flushed_cv.notify_all();
+      if(stop) {
+        break;
+      }
+    }
+  }
+
+  template <log_level Level, typename... Ts>
+  void Write(const char *prefix, const char *fmt, Ts... args) {
+    constexpr size_t reserved = (fixed_size<Ts>() + ... + 0);
+    static_assert(reserved <= sizeof(Record::payload), "too many log arguments");
+    Ring *ring = get_ring();
+    Record *r = ring->reserve();
+    if(r == nullptr) {
+      // debug and info records are dropped rather than stalling the caller
+      if constexpr(Level < LOG_WARNING) {
+        ++ring->no_dropped;
+        return;
+      }
+      while((r = ring->reserve()) == nullptr) {
+        wake_flusher();
+        std::this_thread::yield();
+      }
+    }
+    r->print = &print_record<Ts...>;
+    r->prefix = prefix;
+    r->fmt = fmt;
+    r->seq = next_seq.fetch_add(1, std::memory_order_relaxed);
+    [[maybe_unused]] size_t off = 0, spare = sizeof(Record::payload) - reserved;
+    (encode<Ts>(*r, off, spare, args), ...);
+    ring->commit();
+    if(ring->size() > Ring::capacity / 2) {
+      wake_flusher();
+    }
+  }
+
+  void wake_flusher() {
+    if(!wakeup.exchange(true)) {
+      flush_cv.notify_one();
+    }
+  }
+
+  template <log_level Level, typename... Ts>
+  static void Log(const char *prefix, const char *fmt, Ts... args) {
+    if constexpr(Level >= LOG_LEVEL) {
+      if(instance == nullptr) {
+        fputs(prefix, stderr);
+        print_record_sync(stderr, fmt, args...);
+        return;
+      }
+      instance->Write<Level>(prefix, fmt, args...);
+      if constexpr(Level >= LOG_ERROR) {
+        Flush();
+      }
+    }
+  }
+
+  template <typename... Ts>
+  static void print_record_sync(FILE *file, const char *fmt, Ts... args) {
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wformat-security"
+    #pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    fprintf(file, fmt, args...);
+    #pragma GCC diagnostic pop
   }
-  static Logger *instance;
 public:
   static void Setup(const char *filename) {
     if(instance == nullptr) {
@@ -64,42 +340,37 @@ public:
     }
     Logger::Info("Started log %s\n", filename);
   }
-  static void Say(const char *fmt, ...) {
-    ASSERT(instance != nullptr);
-    va_list argptr;
-    va_start(argptr, fmt);
-    instance->Write(fmt, argptr);
-    va_end(argptr);
+  template <typename... Ts>
+  static void Say(const char *fmt, Ts... args) {
+    Log<LOG_INFO>("", fmt, args...);
   }
-  static void Debug(const char *fmt, ...) {
-    #ifndef NDEBUG
-    ASSERT(instance != nullptr);
-    va_list argptr;
-    va_start(argptr, fmt);
-    instance->WriteFmt("DEBG: ", fmt, argptr);
-    va_end(argptr);
-    #endif
+  template <typename... Ts>
+  static void Debug(const char *fmt, Ts... args) {
+    Log<LOG_DEBUG>("DEBG: ", fmt, args...);
   }
-  static void Info(const char *fmt, ...) {
-    ASSERT(instance != nullptr);
-    va_list argptr;
-    va_start(argptr, fmt);
-    instance->WriteFmt("INFO: ", fmt, argptr);
-    va_end(argptr);
+  template <typename... Ts>
+  static void Info(const char *fmt, Ts... args) {
+    Log<LOG_INFO>("INFO: ", fmt, args...);
   }
-  static void Warning(const char *fmt, ...) {
-    ASSERT(instance != nullptr);
-    va_list argptr;
-    va_start(argptr, fmt);
-    instance->WriteFmt("WARN: ", fmt, argptr);
-    va_end(argptr);
+  template <typename... Ts>
+  static void Warning(const char *fmt, Ts... args) {
+    Log<LOG_WARNING>("WARN: ", fmt, args...);
   }
-  static void Error(const char *fmt, ...) {
-    ASSERT(instance != nullptr);
-    va_list argptr;
-    va_start(argptr, fmt);
-    instance->WriteFmt("ERROR: ", fmt, argptr);
-    va_end(argptr);
+  template <typename... Ts>
+  static void Error(const char *fmt, Ts... args) {
+    Log<LOG_ERROR>("ERROR: ", fmt, args...);
+  }
+  // blocks until everything logged so far is written out
+  static void Flush() {
+    if(instance == nullptr) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(instance->flush_mtx);
+    const size_t ticket = ++instance->flush_requested;
+    instance->flush_cv.notify_one();
+    instance->flushed_cv.wait(lock, [&]() -> bool {
+      return instance->flush_done >= ticket;
+    });
   }
   static void MirrorLog(FILE *redir) {
     #ifdef __unix__
@@ -108,6 +379,7 @@ public:
       return;
     }
     ASSERT(instance->file != nullptr);
+    Flush();
     dup2(fileno(redir), fileno(instance->file));
     if(errno) {
       perror("error");
@@ -116,7 +388,7 @@ public:
     #endif
   }
   static void Close() {
-    Logger::Info("Closing log %s", instance->filename.c_str());
+    Logger::Info("Closing log %s\n", instance->filename.c_str());
     ASSERT(instance != nullptr);
     delete instance;
     instance = nullptr;
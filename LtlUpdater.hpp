@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <File.hpp>
+
+#include <ShaderProgram.hpp>
+#include <ShaderUniform.hpp>
+#include <Texture.hpp>
+#include <StorageBuffer.hpp>
+#include <RuleString.hpp>
+
+using namespace std::literals::string_literals;
+
+// larger than life on the gpu: a pass of running sums along the rows into a
+// 16-bit texture, then one down the columns that applies the rule, see ltl.comp
+struct LtlUpdater {
+  gl::Uniform<gl::UniformType::SAMPLER2D> uSrcTex, uDstTex, uSumTex;
+  gl::Uniform<gl::UniformType::UINTEGER> uPass, uC, uMiddle, uAccessMode;
+  gl::Uniform<gl::UniformType::INTEGER> uRange, uSegment;
+  gl::Uniform<gl::UniformType::IVEC2> uBirth, uSurvival, uSize;
+  gl::ShaderProgram<gl::ComputeShader> program;
+
+  using ShaderProgramCompute = decltype(program);
+
+  static constexpr int local_size = 64;
+  static constexpr int max_wg_count = 65535;
+  GLuint sumtex = 0;
+  glm::ivec2 size = glm::ivec2(0, 0);
+  // cells per invocation: the first costs 2 * range + 1 reads, the others two
+  int segment = 64;
+
+  explicit LtlUpdater(const std::string &dir):
+    uSrcTex("srcTex"s), uDstTex("dstTex"s), uSumTex("sumTex"s),
+    uPass("pass"s), uC("c"s), uMiddle("middle"s), uAccessMode("access_mode"s),
+    uRange("range"s), uSegment("segment"s),
+    uBirth("birth"s), uSurvival("survival"s), uSize("size"s),
+    program({std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("ltl.comp"s))})
+  {}
+
+  void init(int w, int h, int range) {
+    size = glm::ivec2(w, h);
+    segment = std::max(64, 4 * range);
+    gl::Texture<GL_TEXTURE_2D>::init(sumtex);
+    gl::Texture<GL_TEXTURE_2D>::bind(sumtex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, nullptr); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    ShaderProgramCompute::compile_program(program);
+    program.assign_uniforms(uSrcTex, uDstTex, uSumTex, uPass, uC, uMiddle, uAccessMode, uRange, uSegment, uBirth, uSurvival, uSize);
+    Logger::Info("[ltl range %d, segments of %d cells]\n", range, segment);
+  }
+
+  // one invocation per segment, in as many rows of work groups as the count limit needs
+  static void dispatch(size_t no_invocations) {
+    const size_t no_groups = (no_invocations + local_size - 1) / local_size;
+    const size_t gx = std::min<size_t>(no_groups, max_wg_count);
+    ShaderProgramCompute::dispatch(gx, (no_groups + gx - 1) / gx, 1);
+  }
+
+  void run(GLuint srctex, GLuint dsttex, GLuint hashbuf, const ca::LtlSpec &spec, int access_mode) {
+    ShaderProgramCompute::use(program);
+    uSrcTex.set_data(0);
+    uDstTex.set_data(1);
+    uSumTex.set_data(2);
+    uC.set_data(spec.no_states);
+    uMiddle.set_data(spec.middle);
+    uAccessMode.set_data(access_mode);
+    uRange.set_data(spec.range);
+    uSegment.set_data(segment);
+    glm::ivec2 birth(spec.bmin, spec.bmax), survival(spec.smin, spec.smax);
+    uBirth.set_data(birth);
+    uSurvival.set_data(survival);
+    uSize.set_data(size);
+    glBindImageTexture(0, srctex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8UI); GLERROR
+    glBindImageTexture(1, dsttex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI); GLERROR
+    glBindImageTexture(2, sumtex, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R16UI); GLERROR
+    gl::StorageBuffer::bind_base(hashbuf, 0);
+    uPass.set_data(0);
+    dispatch(size_t(size.y) * ((size.x + segment - 1) / segment));
+    ShaderProgramCompute::barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    uPass.set_data(1);
+    dispatch(size_t(size.x) * ((size.y + segment - 1) / segment));
+    ShaderProgramCompute::barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    ShaderProgramCompute::unuse();
+  }
+
+  bool is_active() const {
+    return sumtex != 0;
+  }
+
+  void clear() {
+    if(!is_active()) {
+      return;
+    }
+    gl::Texture<GL_TEXTURE_2D>::clear(sumtex);
+    sumtex = 0;
+    ShaderProgramCompute::clear(program);
+    ShaderProgramCompute::unassign_uniforms(uSrcTex, uDstTex, uSumTex, uPass, uC, uMiddle, uAccessMode, uRange, uSegment, uBirth, uSurvival, uSize);
+  }
+};
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <RuleString.hpp>
+#include <Random.hpp>
+
+// block cellular automata on the margolus neighbourhood: each generation replaces
+// the 2x2 blocks of its partition through the table of ca::BlockSpec, and the
+// blocks of one generation are independent of each other. see Renderer<...,
+// BLOCKS, ...>, and shaders/margolus.comp for the gpu
+namespace margolus {
+
+// the row of cell k of a block (top left, top right, bottom left, bottom right)
+// above the origin of the block: row 0 of the grid is drawn at the bottom of the
+// window, so the top of a block is its second row. shaders/margolus.comp matches
+constexpr int block_row(int k) {
+  return 1 - (k >> 1);
+}
+
+struct Rule {
+  using self_t = Rule;
+  static constexpr int outside_state = 0;
+  static constexpr int dim = 4;
+  static constexpr int update_mode = ::update_mode::ALL;
+
+  ca::BlockSpec spec;
+  int no_states;
+
+  explicit Rule(const ca::BlockSpec &spec):
+    spec(spec), no_states(spec.no_states)
+  {}
+
+  ca::BlockSpec get_block() const {
+    return spec;
+  }
+
+  uint8_t init_state(int y, int x) const {
+    return rng::random(y, x, no_states);
+  }
+
+  int bits_per_cell() const {
+    return ca::BlockSpec::bits_per_cell(no_states);
+  }
+
+  // the table of odd generations has the offset partition
+  const std::vector<uint8_t> &table(size_t generation) const {
+    return (generation & 1) ? spec.odd : spec.even;
+  }
+};
+
+// two states, bit-sliced: the cells of 32 blocks are the even bits of four words
+// (top left, top right, bottom left, bottom right), and each cell of the next
+// block is a boolean function of the four, taken as an or of the blocks (minterms)
+// that set it. ones[k] has bit m set when block m sets cell k
+struct Sliced {
+  std::array<uint16_t, 4> ones = {0, 0, 0, 0};
+
+  explicit Sliced(const std::vector<uint8_t> &table) {
+    for(int m = 0; m < 16; ++m) {
+      for(int k = 0; k < 4; ++k) {
+        ones[k] |= uint16_t(((table[m] >> k) & 1) << m);
+      }
+    }
+  }
+
+  // top and bottom: two rows of 32 blocks, whose cells are bits 2j, 2j + 1 of each
+  inline void apply(uint64_t &top, uint64_t &bottom) const {
+    constexpr uint64_t even = 0x5555555555555555ULL;
+    const uint64_t a = top, b = top >> 1, c = bottom, d = bottom >> 1;
+    const uint64_t ab[4] = {~a & ~b, a & ~b, ~a & b, a & b};
+    const uint64_t cd[4] = {~c & ~d, c & ~d, ~c & d, c & d};
+    uint64_t out[4] = {0, 0, 0, 0};
+    for(int m = 0; m < 16; ++m) {
+      const uint64_t minterm = ab[m & 3] & cd[m >> 2];
+      for(int k = 0; k < 4; ++k) {
+        out[k] |= minterm & (uint64_t(0) - ((ones[k] >> m) & 1));
+      }
+    }
+    top = (out[0] & even) | ((out[1] & even) << 1);
+    bottom = (out[2] & even) | ((out[3] & even) << 1);
+  }
+};
+
+// sand falls down into empty cells, and slides sideways off other sand when the
+// cells on that side are empty. with 3 states, walls (state 2) neither move nor
+// take sand. for 2 states this is mcell's Sand
+inline ca::BlockSpec falling_sand(int no_states) {
+  enum { EMPTY, SAND, WALL };
+  ca::BlockSpec r;
+  r.no_states = no_states;
+  const int bits = ca::BlockSpec::bits_per_cell(no_states);
+  r.even.assign(r.table_size(), 0);
+  for(int index = 0; index < int(r.table_size()); ++index) {
+    if(!r.is_block(index)) {
+      r.even[index] = uint8_t(index);
+      continue;
+    }
+    // top left, top right, bottom left, bottom right
+    int c[4];
+    for(int i = 0; i < 4; ++i) {
+      c[i] = (index >> (bits * i)) & ((1 << bits) - 1);
+    }
+    for(int col = 0; col < 2; ++col) {
+      if(c[col] == SAND && c[col + 2] == EMPTY) {
+        c[col] = EMPTY, c[col + 2] = SAND;
+      }
+    }
+    for(int col = 0; col < 2; ++col) {
+      const int other = 1 - col;
+      if(c[col] == SAND && c[other] == EMPTY && c[other + 2] == EMPTY) {
+        c[col] = EMPTY, c[other + 2] = SAND;
+      }
+    }
+    int next = 0;
+    for(int i = 0; i < 4; ++i) {
+      next |= c[i] << (bits * i);
+    }
+    r.even[index] = uint8_t(next);
+  }
+  r.odd = r.even;
+  return r;
+}
+
+// one step of a single grain of sand, starting in the top row of a block: by the
+// table with the rows of block_row, and bit-sliced, it has to end up a row lower,
+// toward row 0
+inline bool grain_falls() {
+  const ca::BlockSpec sand = falling_sand(2);
+  const Sliced sliced(sand.even);
+  for(int col = 0; col < 2; ++col) {
+    const int next = sand.even[1 << col];
+    for(int k = 0; k < 4; ++k) {
+      if(((next >> k) & 1) && block_row(k) >= block_row(col)) {
+        return false;
+      }
+    }
+    uint64_t top = uint64_t(1) << col, bottom = 0;
+    sliced.apply(top, bottom);
+    if(top != 0 || bottom != (uint64_t(1) << col)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the named rules, for the menu and --rule.
+// http://psoup.math.wisc.edu/mcell/rullex_marg.html
+struct RuleEntry {
+  const char *name;
+  const char *rulestring;
+  ca::BlockSpec (*make)() = nullptr;
+
+  ca::BlockSpec rule() const {
+    if(make != nullptr) {
+      return make();
+    }
+    return ca::parse_registry_rule(name, rulestring, ca::parse_block_rulestring);
+  }
+};
+
+const std::vector<RuleEntry> registry = {
+  { "Critters"       , "MS,D15;14;13;3;11;5;6;1;7;9;10;2;12;4;8;0" },
+  { "Billiard Balls" , "MS,D0;8;4;3;2;5;9;7;1;6;10;11;12;13;14;15"  },
+  { "Tron"           , "MS,D15;1;2;3;4;5;6;7;8;9;10;11;12;13;14;0"  },
+  { "Single Rotation", "MS,D0;2;8;3;1;5;6;7;4;9;10;11;12;13;14;15"  },
+  { "Sand"           , "MS,D0;4;8;12;4;12;12;13;8;12;12;14;12;13;14;15" },
+  { "Sand Walls"     , nullptr, []() -> ca::BlockSpec { return falling_sand(3); } },
+};
+
+inline int find_rule(const std::string &name) {
+  auto &&simplify = [](const std::string &s) -> std::string {
+    std::string t;
+    for(char c : s) {
+      if(isalnum((unsigned char)c))t += char(tolower((unsigned char)c));
+    }
+    return t;
+  };
+  const std::string key = simplify(name);
+  for(size_t i = 0; i < registry.size(); ++i) {
+    if(simplify(registry[i].name) == key) {
+      return int(i);
+    }
+  }
+  return -1;
+}
+
+// a registry name or mcell's MS notation
+inline bool is_block_rule(const std::string &name_or_rulestring) {
+  if(find_rule(name_or_rulestring) != -1) {
+    return true;
+  }
+  const size_t i = name_or_rulestring.find_first_not_of(" \t");
+  return i != std::string::npos && i + 1 < name_or_rulestring.length()
+    && toupper((unsigned char)name_or_rulestring[i]) == 'M' && toupper((unsigned char)name_or_rulestring[i + 1]) == 'S';
+}
+
+inline bool resolve_rule(const std::string &name_or_rulestring, ca::BlockSpec &rule, std::string &error) {
+  const int index = find_rule(name_or_rulestring);
+  if(index != -1) {
+    rule = registry[index].rule();
+    return true;
+  }
+  return ca::parse_block_rulestring(name_or_rulestring, rule, error);
+}
+
+} // namespace margolus
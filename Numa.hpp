@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include <Logger.hpp>
+#include <Threads.hpp>
+
+// placement of host buffers and threads across numa nodes.
+// pages belong to the node of the thread that first writes them, so buffers
+// are allocated untouched and then written in the same static schedule as
+// the updates; pinning keeps each thread on the cores of its pages.
+// queries go through raw syscalls so that libnuma is not needed to link.
+namespace sys {
+
+// node of the page holding each address, -1 if unknown
+inline std::vector<int> get_page_nodes(const std::vector<const void *> &pages) {
+  std::vector<int> nodes(pages.size(), -1);
+#if defined(__linux__) && defined(SYS_move_pages)
+  // with no target nodes, move_pages only reports where the pages are
+  std::vector<void *> ptrs(pages.size());
+  std::transform(pages.begin(), pages.end(), ptrs.begin(), [](const void *p) -> void * { return const_cast<void *>(p); });
+  if(syscall(SYS_move_pages, 0, ptrs.size(), ptrs.data(), nullptr, nodes.data(), 0) != 0) {
+    std::fill(nodes.begin(), nodes.end(), -1);
+  }
+#endif
+  return nodes;
+}
+
+inline int get_current_node() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu = 0, node = 0;
+  if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return int(node);
+  }
+#endif
+  return -1;
+}
+
+// pins the thread team to the cpus of the process, one each in order, unless
+// OMP_PROC_BIND already says how to bind. with a static schedule, thread i
+// then always runs on the same cores and updates the rows it first touched.
+// the main thread keeps its mask: threads it starts later (the gl driver's)
+// would otherwise inherit a single cpu
+inline void pin_threads() {
+#if defined(__linux__) && defined(_OPENMP)
+  if(getenv("OMP_PROC_BIND") != nullptr) {
+    Logger::Info("[numa] threads bound by OMP_PROC_BIND=%s\n", getenv("OMP_PROC_BIND"));
+    return;
+  }
+  cpu_set_t allowed;
+  if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return;
+  }
+  std::vector<int> cpus;
+  for(int c = 0; c < CPU_SETSIZE; ++c) {
+    if(CPU_ISSET(c, &allowed)) {
+      cpus.push_back(c);
+    }
+  }
+  const int no_threads = get_max_threads();
+  if(cpus.size() < 2 || no_threads < 2) {
+    return;
+  }
+  std::vector<int> nodes(no_threads, -1);
+  #pragma omp parallel num_threads(no_threads)
+  {
+    const int t = get_thread_num();
+    if(t > 0) {
+      cpu_set_t one;
+      CPU_ZERO(&one);
+      // spread over the allowed cpus when there are more of them than threads
+      CPU_SET(cpus[size_t(t) * cpus.size() / no_threads], &one);
+      sched_setaffinity(0, sizeof(one), &one);
+    }
+    nodes[t] = get_current_node();
+  }
+  std::string s;
+  for(int t = 0; t < no_threads; ++t) {
+    s += " " + std::to_string(nodes[t]);
+  }
+  Logger::Info("[numa] pinned %d worker threads to %lu cpus, nodes:%s\n", no_threads - 1, cpus.size(), s.c_str());
+#endif
+}
+
+// logs how many pages of the buffer each node holds, sampling at most max_samples pages
+inline void log_placement(const char *name, const void *data, size_t size, size_t max_samples=4096) {
+#ifdef __linux__
+  const size_t page = size_t(sysconf(_SC_PAGESIZE));
+  const uintptr_t begin = uintptr_t(data) / page * page, end = uintptr_t(data) + size;
+  if(data == nullptr || size == 0) {
+    return;
+  }
+  const size_t no_pages = (end - begin + page - 1) / page;
+  const size_t stride = std::max<size_t>(1, no_pages / max_samples);
+  std::vector<const void *> pages;
+  for(size_t i = 0; i < no_pages; i += stride) {
+    pages.push_back((const void *)(begin + i * page));
+  }
+  std::vector<size_t> counts;
+  size_t unknown = 0;
+  for(const int node : get_page_nodes(pages)) {
+    if(node < 0) {
+      ++unknown;
+      continue;
+    }
+    if(size_t(node) >= counts.size()) {
+      counts.resize(node + 1, 0);
+    }
+    ++counts[node];
+  }
+  std::string s;
+  for(size_t n = 0; n < counts.size(); ++n) {
+    s += " node" + std::to_string(n) + ":" + std::to_string(counts[n]);
+  }
+  if(unknown > 0) {
+    s += " unknown:" + std::to_string(unknown);
+  }
+  Logger::Info("[numa] %s: %lu of %lu pages sampled,%s\n", name, pages.size(), no_pages, s.c_str());
+#endif
+}
+
+} // namespace sys
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+// minimal 8-bit grayscale png writer, no zlib dependency:
+// the image data is wrapped into uncompressed (stored) deflate blocks
+struct PNGEncoder {
+  static uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc=0) {
+    static uint32_t table[256] = {0};
+    static bool table_ready = false;
+    if(!table_ready) {
+      for(uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for(int k = 0; k < 8; ++k) {
+          c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+      }
+      table_ready = true;
+    }
+    crc = ~crc;
+    for(size_t i = 0; i < len; ++i) {
+      crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+  }
+
+  static uint32_t adler32(const uint8_t *data, size_t len, uint32_t adler=1) {
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+    for(size_t i = 0; i < len; ++i) {
+      a = (a + data[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+  }
+
+  static void put_u32(std::vector<uint8_t> &out, uint32_t v) {
+    out.push_back(v >> 24), out.push_back(v >> 16), out.push_back(v >> 8), out.push_back(v);
+  }
+
+  static void write_chunk(FILE *fp, const char *type, const std::vector<uint8_t> &payload) {
+    std::vector<uint8_t> head;
+    put_u32(head, payload.size());
+    head.insert(head.end(), type, type + 4);
+    uint32_t crc = crc32(head.data() + 4, 4);
+    crc = crc32(payload.data(), payload.size(), crc);
+    std::vector<uint8_t> tail;
+    put_u32(tail, crc);
+    fwrite(head.data(), 1, head.size(), fp);
+    fwrite(payload.data(), 1, payload.size(), fp);
+    fwrite(tail.data(), 1, tail.size(), fp);
+  }
+
+  static bool write(const char *filename, const uint8_t *pixels, int w, int h) {
+    FILE *fp = fopen(filename, "wb");
+    if(fp == nullptr) {
+      return false;
+    }
+    static const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    fwrite(signature, 1, sizeof(signature), fp);
+
+    std::vector<uint8_t> ihdr;
+    put_u32(ihdr, w), put_u32(ihdr, h);
+    // bit depth 8, grayscale, deflate, adaptive filtering, no interlace
+    ihdr.insert(ihdr.end(), {8, 0, 0, 0, 0});
+    write_chunk(fp, "IHDR", ihdr);
+
+    // every scanline is prefixed with filter type 0
+    std::vector<uint8_t> raw;
+    raw.reserve(size_t(w + 1) * h);
+    for(int y = 0; y < h; ++y) {
+      raw.push_back(0);
+      raw.insert(raw.end(), pixels + size_t(y) * w, pixels + size_t(y + 1) * w);
+    }
+    std::vector<uint8_t> idat = {0x78, 0x01};
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    size_t pos = 0;
+    do {
+      const uint16_t len = std::min<size_t>(65535, raw.size() - pos);
+      const bool last = (pos + len == raw.size());
+      idat.push_back(last ? 1 : 0);
+      idat.push_back(len & 0xff), idat.push_back(len >> 8);
+      idat.push_back(~len & 0xff), idat.push_back((~len >> 8) & 0xff);
+      idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+      pos += len;
+    } while(pos < raw.size());
+    put_u32(idat, adler32(raw.data(), raw.size()));
+    write_chunk(fp, "IDAT", idat);
+    write_chunk(fp, "IEND", {});
+    fclose(fp);
+    return true;
+  }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include <Random.hpp>
+
+// periodicity detection from a rolling 64-bit hash of the whole grid.
+// the hash is the xor of a zobrist key per live cell, so a generation only
+// has to fold in the cells that changed: h ^= key(i, old) ^ key(i, new).
+// the keys are computed rather than tabulated, and shaders/bsc.comp and
+// shaders/soup.comp compute the same ones on the gpu. keep them in sync.
+namespace period {
+
+// zero for dead cells, so that an empty grid hashes to 0
+constexpr uint64_t key(uint32_t index, uint32_t state) {
+  if(state == 0) {
+    return 0;
+  }
+  const uint64_t lo = rng::hash(rng::hash(index) ^ state);
+  const uint64_t hi = rng::hash(rng::hash(index ^ 0x9e3779b9U) ^ state);
+  return (hi << 32) | lo;
+}
+
+inline uint64_t hash_grid(const uint8_t *cells, int size) {
+  uint64_t h = 0;
+  #pragma omp parallel for reduction(^:h)
+  for(int i = 0; i < size; ++i) {
+    h ^= key(i, cells[i]);
+  }
+  return h;
+}
+
+// remembers the generation of each of the last max_period hashes
+struct Detector {
+  int max_period = 64;
+  // the last repeat found: the state of generation `since` came back every `period` generations
+  int period = 0;
+  size_t since = 0;
+  std::unordered_map<uint64_t, size_t> seen;
+  std::vector<std::pair<uint64_t, size_t>> ring;
+
+  bool enabled() const {
+    return max_period > 0;
+  }
+
+  bool is_periodic() const {
+    return period > 0;
+  }
+
+  void reset(int max_period_) {
+    max_period = max_period_;
+    period = 0, since = 0;
+    seen.clear();
+    ring.assign(std::max(max_period, 0), {0, SIZE_MAX});
+  }
+
+  // returns true when the state of this generation has been seen within max_period generations
+  bool push(size_t generation, uint64_t hash) {
+    if(!enabled()) {
+      return false;
+    }
+    const auto found = seen.find(hash);
+    if(found != seen.end() && generation - found->second <= size_t(max_period)) {
+      period = int(generation - found->second);
+      since = found->second;
+    } else {
+      period = 0;
+    }
+    // forget the hash that falls out of the window
+    auto &slot = ring[generation % ring.size()];
+    if(slot.second != SIZE_MAX) {
+      const auto old = seen.find(slot.first);
+      if(old != seen.end() && old->second == slot.second) {
+        seen.erase(old);
+      }
+    }
+    slot = {hash, generation};
+    seen[hash] = generation;
+    return is_periodic();
+  }
+};
+
+} // namespace period
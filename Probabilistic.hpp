@@ -8,13 +8,14 @@
 #include <complex>
 #include <type_traits>
 #include <utility>
-#include <random>
 
 
+#include <Random.hpp>
+
 namespace sca {
 
 inline uint8_t random(int y, int x, int no_states) {
-  return rand() % no_states;
+  return rng::random(y, x, no_states);
 }
 
 struct ising_model {
@@ -27,12 +28,10 @@ struct ising_model {
   static constexpr int DEAD = 0, LIVE = 1;
 
   float beta, h;
-  std::random_device rd;
-  std::mt19937 rng;
-  std::uniform_real_distribution<> uniform_dist;
+  // index of the next flip attempt, the generation key of the counter rng
+  uint32_t step = 0;
   explicit ising_model(float beta=1., float h=.0):
-    beta(beta), h(h),
-    rd(), rng(rd()), uniform_dist(.0, 1.)
+    beta(beta), h(h)
   {}
 
   static inline uint8_t init_state(int y, int x) {
@@ -42,7 +41,8 @@ struct ising_model {
   template <typename B>
   inline std::pair<size_t, uint8_t> next_state(B &&prev) {
     const int w = prev.width, h = prev.height;
-    const int cursor = rand() % (w * h);
+    const uint32_t seed = rng::get_seed(), t = step++;
+    const int cursor = rng::get(seed, t, 0, 0) % uint32_t(w * h);
     const int y = cursor / w, x = cursor % w;
     static_assert(DEAD == 0 && LIVE == 1, "wrong index assumptions");
     static constexpr int vals_lut[] = {-1, 1};
@@ -54,7 +54,7 @@ struct ising_model {
       }
     }
     int dE = -2*S*nb;
-    const float r = uniform_dist(rng);
+    const float r = rng::get_float(seed, t, 0, 1);
     if(dE > 0 || std::log(r + 1e-5) < dE * beta) {
       return std::make_pair(cursor, (prev[y][x] == DEAD) ? LIVE : DEAD);
     }
@@ -105,7 +105,7 @@ struct ising_model {
 //      }
 //    }
 //    int dE = -1.5*S*nb;
-//    const float r = uniform_dist(rng);
+//    const float r = rng::get_float(seed, t, 0, 1);
 //    if(dE > 0 || std::log(r + 1e-5) < dE * beta) {
 //      return std::make_pair(cursor, (prev[y][x] == DEAD) ? LIVE : DEAD);
 //    }
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <Query.hpp>
+
+namespace prof {
+
+enum phase : int {
+  // host-side simulation step (or compute dispatch submission)
+  UPDATE,
+  // convolution of continuous states with their kernels
+  CONVOLVE,
+  // downsampling and texture upload / mipmap generation
+  UPLOAD,
+  RENDER,
+  SWAP,
+  FRAME,
+  // GL_TIME_ELAPSED of the compute dispatches
+  GPU_UPDATE,
+  NO_PHASES
+};
+
+constexpr const char *phase_names[] = {
+  "update", "convolve", "upload", "render", "swap", "frame", "gpu update"
+};
+
+using clock = std::chrono::steady_clock;
+
+// rolling window of the last samples, bucketed in powers of two from 1/32 ms
+struct Histogram {
+  static constexpr int window = 256;
+  static constexpr int no_buckets = 12;
+  static constexpr float first_edge = 1. / 32;
+
+  float samples[window] = {0};
+  int counts[no_buckets] = {0};
+  size_t no_samples = 0;
+  double sum = 0;
+
+  static int bucket(float ms) {
+    int b = 0;
+    for(float edge = first_edge; b + 1 < no_buckets && ms >= edge; edge *= 2) {
+      ++b;
+    }
+    return b;
+  }
+
+  static float bucket_edge(int b) {
+    return first_edge * float(1 << b);
+  }
+
+  void add(float ms) {
+    const int i = no_samples % window;
+    if(no_samples >= window) {
+      --counts[bucket(samples[i])];
+      sum -= samples[i];
+    }
+    samples[i] = ms;
+    ++counts[bucket(ms)];
+    sum += ms;
+    ++no_samples;
+  }
+
+  int size() const {
+    return std::min<size_t>(no_samples, window);
+  }
+
+  float last() const {
+    return no_samples ? samples[(no_samples - 1) % window] : 0;
+  }
+
+  float mean() const {
+    return size() ? sum / size() : 0;
+  }
+
+  float max() const {
+    return size() ? *std::max_element(samples, samples + size()) : 0;
+  }
+
+  float percentile(float p) const {
+    if(!size()) {
+      return 0;
+    }
+    std::vector<float> sorted(samples, samples + size());
+    const size_t k = std::min<size_t>(sorted.size() - 1, p * sorted.size());
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    return sorted[k];
+  }
+};
+
+// collects cpu scopes and gpu timer queries; disabled unless stats or a trace are requested
+class Profiler {
+  struct Event {
+    phase p;
+    double ts, dur;
+    int tid;
+  };
+
+  struct PendingQuery {
+    GLuint query;
+    phase p;
+    double ts;
+  };
+
+  Histogram histograms[NO_PHASES];
+  clock::time_point origin = clock::now();
+  std::string trace_path = "";
+  std::vector<Event> events;
+  static constexpr size_t max_events = 1 << 22;
+
+  std::vector<GLuint> free_queries;
+  std::deque<PendingQuery> pending_queries;
+  bool gpu_timer_open = false;
+  static constexpr size_t max_pending_queries = 16;
+public:
+  bool enabled = false;
+
+  static Profiler &get() {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  void enable(const std::string &trace_filename="") {
+    enabled = true;
+    trace_path = trace_filename;
+    origin = clock::now();
+  }
+
+  double micros(clock::time_point t) const {
+    return std::chrono::duration<double, std::micro>(t - origin).count();
+  }
+
+  const Histogram &histogram(phase p) const {
+    return histograms[p];
+  }
+
+  void record(phase p, double ts, double dur, int tid=0) {
+    histograms[p].add(dur * 1e-3);
+    if(!trace_path.empty() && events.size() < max_events) {
+      events.push_back((Event){ .p=p, .ts=ts, .dur=dur, .tid=tid });
+    }
+  }
+
+  void record(phase p, clock::time_point t0, clock::time_point t1) {
+    record(p, micros(t0), std::chrono::duration<double, std::micro>(t1 - t0).count());
+  }
+
+  // GL_TIME_ELAPSED queries cannot nest, so only one gpu scope may be open at a time
+  void gpu_begin(phase p) {
+    if(!enabled || gpu_timer_open || pending_queries.size() >= max_pending_queries) {
+      return;
+    }
+    GLuint query = 0;
+    if(free_queries.empty()) {
+      gl::TimerQuery::init(query);
+    } else {
+      query = free_queries.back();
+      free_queries.pop_back();
+    }
+    gl::TimerQuery::begin(query);
+    pending_queries.push_back((PendingQuery){ .query=query, .p=p, .ts=micros(clock::now()) });
+    gpu_timer_open = true;
+  }
+
+  void gpu_end() {
+    if(!gpu_timer_open) {
+      return;
+    }
+    gl::TimerQuery::end();
+    gpu_timer_open = false;
+  }
+
+  // collect finished queries without stalling the pipeline
+  void poll_gpu() {
+    while(!pending_queries.empty() && !(gpu_timer_open && pending_queries.size() == 1)) {
+      const PendingQuery &q = pending_queries.front();
+      if(!gl::TimerQuery::is_available(q.query)) {
+        break;
+      }
+      const double dur = gl::TimerQuery::get_result(q.query) * 1e-3;
+      record(q.p, q.ts, dur, 1);
+      free_queries.push_back(q.query);
+      pending_queries.pop_front();
+    }
+  }
+
+  // query objects belong to the current context
+  void clear_gpu() {
+    if(gpu_timer_open) {
+      gpu_end();
+    }
+    for(auto &q : pending_queries) {
+      free_queries.push_back(q.query);
+    }
+    pending_queries.clear();
+    for(GLuint &query : free_queries) {
+      gl::TimerQuery::clear(query);
+    }
+    free_queries.clear();
+  }
+
+  void log_summary() const {
+    if(!enabled) {
+      return;
+    }
+    for(int p = 0; p < NO_PHASES; ++p) {
+      const Histogram &hist = histograms[p];
+      if(!hist.size()) {
+        continue;
+      }
+      Logger::Info("%-10s mean %.3f ms, p95 %.3f ms, max %.3f ms\n", phase_names[p], hist.mean(), hist.percentile(.95), hist.max());
+    }
+  }
+
+  // chrome://tracing / perfetto compatible json
+  void dump_trace() const {
+    if(trace_path.empty()) {
+      return;
+    }
+    FILE *fp = fopen(trace_path.c_str(), "w");
+    if(fp == nullptr) {
+      Logger::Warning("unable to write trace '%s'\n", trace_path.c_str());
+      return;
+    }
+    fprintf(fp, "{\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"cpu\"}},\n");
+    fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"gpu\"}}");
+    for(const Event &e : events) {
+      fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}", phase_names[e.p], e.ts, e.dur, e.tid);
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    Logger::Info("wrote %lu trace events to '%s'\n", events.size(), trace_path.c_str());
+  }
+};
+
+struct ScopedTimer {
+  const phase p;
+  clock::time_point t0;
+
+  explicit ScopedTimer(phase p):
+    p(p)
+  {
+    if(Profiler::get().enabled) {
+      t0 = clock::now();
+    }
+  }
+
+  ~ScopedTimer() {
+    Profiler &profiler = Profiler::get();
+    if(profiler.enabled) {
+      profiler.record(p, t0, clock::now());
+    }
+  }
+};
+
+struct ScopedGPUTimer {
+  explicit ScopedGPUTimer(phase p) {
+    Profiler::get().gpu_begin(p);
+  }
+
+  ~ScopedGPUTimer() {
+    Profiler::get().gpu_end();
+  }
+};
+
+} // namespace prof
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+#include <Window.hpp>
+#include <InterfaceApp.hpp>
+#include <Profiler.hpp>
+#include <Scheduler.hpp>
+
+// nuklear window with per-phase timings drawn on top of the automaton
+struct ProfilerOverlay {
+  struct nk_glfw nkglfw = {0};
+  struct nk_context *ctx = nullptr;
+  const sys::Path root_path;
+  // lines of simulation state under the title: the detected period and the cells per state
+  std::string status = "";
+  std::string population = "";
+  // the timing window is only drawn with --stats
+  bool show_timing = true;
+  // rewind controls, drawn while the history is recorded. the widgets only
+  // leave requests behind, the app acts on them before the next step
+  struct HistoryControls {
+    bool enabled = false;
+    bool paused = false;
+    size_t first = 0, last = 0, current = 0;
+    size_t no_frames = 0, bytes = 0;
+    bool toggle_pause = false;
+    int step = 0;
+    bool seek = false;
+    size_t seek_to = 0;
+  } history;
+
+  explicit ProfilerOverlay(const std::string &dir):
+    root_path(dir)
+  {}
+
+  void init(Window &w) {
+    ctx = nk_glfw3_init(&nkglfw, w.window, NK_GLFW3_INSTALL_CALLBACKS);
+    InterfaceApp::load_font(nkglfw, ctx, root_path, 14);
+    set_style(ctx, THEME_DARK);
+  }
+
+  void draw_phase(prof::phase p) {
+    const prof::Histogram &hist = prof::Profiler::get().histogram(p);
+    if(!hist.size()) {
+      return;
+    }
+    char s[256];
+    snprintf(s, sizeof(s), "%-10s %7.3f ms  mean %7.3f  p95 %7.3f  max %7.3f",
+             prof::phase_names[p], hist.last(), hist.mean(), hist.percentile(.95), hist.max());
+    nk_layout_row_dynamic(ctx, 16, 1);
+    nk_label(ctx, s, NK_TEXT_LEFT);
+    int max_count = 1;
+    for(int b = 0; b < prof::Histogram::no_buckets; ++b) {
+      max_count = std::max(max_count, hist.counts[b]);
+    }
+    nk_layout_row_dynamic(ctx, 24, 1);
+    if(nk_chart_begin(ctx, NK_CHART_COLUMN, prof::Histogram::no_buckets, 0, max_count)) {
+      for(int b = 0; b < prof::Histogram::no_buckets; ++b) {
+        nk_chart_push(ctx, hist.counts[b]);
+      }
+      nk_chart_end(ctx);
+    }
+  }
+
+  // the last loop of the tile scheduler, if the engine uses it
+  void draw_scheduler() {
+    const sys::Scheduler *scheduler = sys::Scheduler::find();
+    if(scheduler == nullptr) {
+      return;
+    }
+    const sys::Scheduler::Stats &stats = scheduler->stats;
+    if(stats.no_tasks == 0) {
+      return;
+    }
+    char s[256];
+    snprintf(s, sizeof(s), "scheduler  %d threads  occupancy %3.0f%%  %lu tasks  %lu steals",
+             stats.no_threads, stats.occupancy * 100, stats.no_tasks, stats.no_steals);
+    nk_layout_row_dynamic(ctx, 16, 1);
+    nk_label(ctx, s, NK_TEXT_LEFT);
+  }
+
+  void draw_history(Window &w) {
+    HistoryControls &hc = history;
+    if(nk_begin(ctx, "History", nk_rect(10, w.height() - 130, 460, 120),
+          NK_WINDOW_BORDER|NK_WINDOW_MOVABLE|NK_WINDOW_SCALABLE|
+          NK_WINDOW_MINIMIZABLE|NK_WINDOW_TITLE))
+    {
+      char s[256];
+      snprintf(s, sizeof(s), "generation %lu of %lu..%lu  %lu frames  %.1f MiB",
+               hc.current, hc.first, hc.last, hc.no_frames, hc.bytes / double(1 << 20));
+      nk_layout_row_dynamic(ctx, 16, 1);
+      nk_label(ctx, s, NK_TEXT_LEFT);
+      nk_layout_row_dynamic(ctx, 20, 3);
+      if(nk_button_label(ctx, "<")) {
+        hc.step = -1;
+      }
+      if(nk_button_label(ctx, hc.paused ? "play" : "pause")) {
+        hc.toggle_pause = true;
+      }
+      if(nk_button_label(ctx, ">")) {
+        hc.step = 1;
+      }
+      if(hc.last > hc.first) {
+        int pos = int(std::min(hc.current, hc.last) - hc.first);
+        nk_layout_row_dynamic(ctx, 20, 1);
+        if(nk_slider_int(ctx, 0, &pos, int(hc.last - hc.first), 1) && hc.first + pos != hc.current) {
+          hc.seek = true;
+          hc.seek_to = hc.first + pos;
+        }
+      }
+    }
+    nk_end(ctx);
+  }
+
+  void draw(Window &w) {
+    nk_glfw3_new_frame(&nkglfw);
+    if(history.enabled) {
+      draw_history(w);
+    }
+    if(!show_timing) {
+      nk_glfw3_render(&nkglfw, NK_ANTI_ALIASING_ON, MAX_VERTEX_BUFFER, MAX_ELEMENT_BUFFER);
+      return;
+    }
+    if(nk_begin(ctx, "Frame timing", nk_rect(10, 10, 460, 440),
+          NK_WINDOW_BORDER|NK_WINDOW_MOVABLE|NK_WINDOW_SCALABLE|
+          NK_WINDOW_MINIMIZABLE|NK_WINDOW_TITLE))
+    {
+      nk_layout_row_dynamic(ctx, 16, 1);
+      nk_label(ctx, "histogram buckets double from 1/32 ms", NK_TEXT_LEFT);
+      for(const std::string *line : {&status, &population}) {
+        if(!line->empty()) {
+          nk_layout_row_dynamic(ctx, 16, 1);
+          nk_label(ctx, line->c_str(), NK_TEXT_LEFT);
+        }
+      }
+      draw_scheduler();
+      for(int p = 0; p < prof::NO_PHASES; ++p) {
+        draw_phase(prof::phase(p));
+      }
+    }
+    nk_end(ctx);
+    nk_glfw3_render(&nkglfw, NK_ANTI_ALIASING_ON, MAX_VERTEX_BUFFER, MAX_ELEMENT_BUFFER);
+  }
+
+  void clear() {
+    nk_glfw3_shutdown(&nkglfw);
+  }
+};
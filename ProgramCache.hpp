@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <File.hpp>
+
+namespace gl {
+
+// on-disk cache of linked program binaries. entries are named after a hash of
+// the preprocessed sources and the driver identity, and carry both in a header
+// so that a stale or colliding file is never handed to glProgramBinary
+struct ProgramCache {
+  static constexpr char magic[8] = {'A','U','T','P','R','O','G','1'};
+
+  static uint64_t hash(const std::string &s, uint64_t h=0xcbf29ce484222325ULL) {
+    for(unsigned char c : s) {
+      h = (h ^ c) * 0x100000001b3ULL;
+    }
+    return h;
+  }
+
+  static bool is_supported() {
+    GLint no_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &no_formats); GLERROR
+    return no_formats > 0;
+  }
+
+  static std::string get_path(uint64_t key) {
+    char name[64];
+    snprintf(name, sizeof(name), "program-%016llx.bin", (unsigned long long)key);
+    return std::string(sys::Path(sys::get_cache_directory()) / sys::Path(std::string(name)));
+  }
+
+  static bool load(const std::string &path, const std::string &identity, uint64_t key, GLenum &format, std::vector<char> &data) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if(fp == nullptr) {
+      return false;
+    }
+    char m[sizeof(magic)];
+    uint64_t stored_key = 0;
+    uint32_t identity_len = 0, stored_format = 0, size = 0;
+    bool ok = fread(m, sizeof(m), 1, fp) == 1 && std::equal(m, m + sizeof(m), magic)
+      && fread(&stored_key, sizeof(stored_key), 1, fp) == 1 && stored_key == key
+      && fread(&identity_len, sizeof(identity_len), 1, fp) == 1 && identity_len == identity.length();
+    if(ok) {
+      std::string stored_identity(identity_len, '\0');
+      ok = fread(stored_identity.data(), 1, identity_len, fp) == identity_len && stored_identity == identity
+        && fread(&stored_format, sizeof(stored_format), 1, fp) == 1
+        && fread(&size, sizeof(size), 1, fp) == 1 && size > 0;
+    }
+    if(ok) {
+      data.resize(size);
+      ok = fread(data.data(), 1, size, fp) == size;
+    }
+    fclose(fp);
+    format = stored_format;
+    return ok;
+  }
+
+  static void store(const std::string &path, const std::string &identity, uint64_t key, GLenum format, const void *data, uint32_t size) {
+    // written aside and renamed, so that concurrent instances never read a partial file
+    const std::string tmp_path = path + ".tmp";
+    FILE *fp = fopen(tmp_path.c_str(), "wb");
+    if(fp == nullptr) {
+      Logger::Warning("unable to write program cache '%s'\n", tmp_path.c_str());
+      return;
+    }
+    const uint32_t identity_len = identity.length(), stored_format = format;
+    bool ok = fwrite(magic, sizeof(magic), 1, fp) == 1
+      && fwrite(&key, sizeof(key), 1, fp) == 1
+      && fwrite(&identity_len, sizeof(identity_len), 1, fp) == 1
+      && fwrite(identity.data(), 1, identity_len, fp) == identity_len
+      && fwrite(&stored_format, sizeof(stored_format), 1, fp) == 1
+      && fwrite(&size, sizeof(size), 1, fp) == 1
+      && fwrite(data, 1, size, fp) == size;
+    ok = (fclose(fp) == 0) && ok;
+    if(!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+      Logger::Warning("unable to write program cache '%s'\n", path.c_str());
+      remove(tmp_path.c_str());
+    }
+  }
+};
+
+} // namespace gl
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+
+namespace gl {
+
+template <GLenum QueryType>
+struct Query {
+  static void init(GLuint &query) {
+    glGenQueries(1, &query); GLERROR
+  }
+
+  static void begin(GLuint query) {
+    glBeginQuery(QueryType, query); GLERROR
+  }
+
+  static void end() {
+    glEndQuery(QueryType); GLERROR
+  }
+
+  // non-blocking: results usually arrive a frame or two later
+  static bool is_available(GLuint query) {
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available); GLERROR
+    return available == GL_TRUE;
+  }
+
+  static GLuint64 get_result(GLuint query) {
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result); GLERROR
+    return result;
+  }
+
+  static void clear(GLuint &query) {
+    glDeleteQueries(1, &query); GLERROR
+    query = 0;
+  }
+};
+
+using TimerQuery = Query<GL_TIME_ELAPSED>;
+
+} // namespace gl
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// counter-based random numbers: every value is a pure function of
+// (seed, generation, y, x), so initializers can run on any number of threads
+// and the host reproduces exactly what shaders/soup.comp generates on the gpu.
+// keep the two in sync.
+namespace rng {
+
+// integer finalizer, same constants as hash() in soup.comp
+constexpr uint32_t hash(uint32_t x) {
+  x = ((x >> 16) ^ x) * 0x45d9f3bU;
+  x = ((x >> 16) ^ x) * 0x45d9f3bU;
+  x = (x >> 16) ^ x;
+  return x;
+}
+
+constexpr uint32_t get(uint32_t seed, uint32_t generation, int y, int x) {
+  return hash(hash(hash(hash(seed) ^ generation) ^ uint32_t(y)) ^ uint32_t(x));
+}
+
+// uniform in [0, 1)
+constexpr float get_float(uint32_t seed, uint32_t generation, int y, int x) {
+  return float(get(seed, generation, y, x) >> 8) * (1.f / float(1 << 24));
+}
+
+// process-wide seed of the initial soups, set once from the command line or the clock
+inline uint32_t seed = 0;
+
+inline void set_seed(uint32_t s) {
+  seed = s;
+}
+
+inline uint32_t get_seed() {
+  return seed;
+}
+
+inline uint8_t random(int y, int x, int no_states) {
+  return get(seed, 0, y, x) % uint32_t(no_states);
+}
+
+} // namespace rng
@@ -1,14 +1,31 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <climits>
+
 #include <Logger.hpp>
 #include <Debug.hpp>
+#include <Profiler.hpp>
 
 #include <ShaderProgram.hpp>
 #include <ShaderUniform.hpp>
 #include <Texture.hpp>
+#include <StorageBuffer.hpp>
+#include <Fence.hpp>
+#include <WorkGroupTuner.hpp>
+#include <Downsampler.hpp>
+#include <LtlUpdater.hpp>
+#include <VolumeUpdater.hpp>
+#include <BlockUpdater.hpp>
+#include <TableUpdater.hpp>
 #include <Window.hpp>
 
 #include <Automaton.hpp>
+#include <Convolution.hpp>
+#include <Numa.hpp>
+#include <Scheduler.hpp>
+#include <Period.hpp>
 #include <RLEDecoder.hpp>
 #include <PlainDecoder.hpp>
 #include <Life106Decoder.hpp>
@@ -39,20 +56,47 @@ struct TexturedGridRenderer {
   using ShaderProgram = decltype(prog);
 
   int colorscheme = 0;
+  // box filter for negative zoom, when compute shaders are available
+  bool gpu_downsample = false;
+  Downsampler downsampler;
+
+  // generations stepped since init_textures, and the zobrist hash of the grid
+  // as of the last generation the detector has seen
+  size_t generation = 0;
+  uint64_t grid_hash = 0;
+  period::Detector detector;
+  // cells per state as of histogram_generation, kept up to date while track_histogram is set
+  bool track_histogram = false;
+  std::vector<uint64_t> histogram;
+  size_t histogram_generation = 0;
+
+  // cells in any state but 0, as of histogram_generation
+  uint64_t live_cells() const {
+    uint64_t n = 0;
+    for(size_t s = 1; s < histogram.size(); ++s) {
+      n += histogram[s];
+    }
+    return n;
+  }
+  // generations a single update_state may advance; renderers that cannot block
+  // several generations together step one at a time
+  int generations_per_update = 1;
 
   virtual storage_mode get_storage_mode() = 0;
 
-  explicit TexturedGridRenderer(int no_states, const std::string &dir):
+  // frag: the shader that colours the grid texture, of integer states by default
+  explicit TexturedGridRenderer(int no_states, const std::string &dir, const std::string &frag="aut4.frag"s):
     no_states(no_states),
     w(0), h(0),
     bufVertex(), attrVertex("vertex"s, bufVertex), vao(attrVertex),
     prog({
       std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("aut4.vert"s)),
-      std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("aut4.frag"s))
+      std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path(frag))
     }),
     uSampler("grid"s),
     uNstates("no_states"s),
-    uColorscheme("colorscheme"s)
+    uColorscheme("colorscheme"s),
+    downsampler(dir)
   {}
 
   void init_renderer(Window &w, int factor) {
@@ -70,6 +114,7 @@ struct TexturedGridRenderer {
     // init shader program
     ShaderProgram::init(prog, vao);
     prog.assign_uniforms(uSampler, uNstates, uColorscheme);
+    gpu_downsample = w.gl_support_compute_shaders;
     set_grid_size(w.width(), w.height(), factor);
     init_textures();
   }
@@ -78,8 +123,38 @@ struct TexturedGridRenderer {
   virtual void init_textures(const char *filename=nullptr) = 0;
   virtual void update_state() = 0;
   virtual GLuint get_current_texture_id() = 0;
+  // copy the current generation (w*h cells, one byte per cell) to the host
+  virtual void read_frame(std::vector<uint8_t> &frame) = 0;
+  // waits for any histogram still in flight
+  virtual void flush_histogram() {}
+  // keys the window did not take for itself
+  virtual void on_key(int key) {}
+  // of the whole grid, which may be more than the w * h cells displayed
+  virtual size_t get_no_cells() const {
+    return size_t(w) * h;
+  }
+  // the generation of the cells read_frame returns
+  virtual size_t get_frame_generation() const {
+    return generation;
+  }
+  // replaces the grid with a frame of an earlier (or later) generation, e.g. from
+  // history; returns false if the storage cannot be rewound
+  virtual bool write_frame(const std::vector<uint8_t> &frame, size_t generation_) {
+    return false;
+  }
+
+  // after write_frame: the detector starts over from the frame it was given
+  void restart_detector(size_t generation_, const uint8_t *frame) {
+    generation = generation_;
+    if(detector.enabled()) {
+      grid_hash = period::hash_grid(frame, size_t(w) * h);
+      detector.reset(detector.max_period);
+      detector.push(generation, grid_hash);
+    }
+  }
 
   void render(int global_texture_index) {
+    prof::ScopedTimer timer(prof::RENDER);
     // display
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); GLERROR
     // use program
@@ -104,6 +179,7 @@ struct TexturedGridRenderer {
     vao.clear();
     ShaderProgram::clear(prog);
     ShaderProgram::unassign_uniforms(uSampler, uNstates, uColorscheme);
+    downsampler.clear();
   }
 };
 
@@ -164,38 +240,329 @@ struct Renderer<AUT, storage_mode::HOSTBUFFER, AccessMode> : public TexturedGrid
     if constexpr(doublebuffer) {
       buf2.init(w, h);
     }
-    for(int i=0;i<w*h;++i) {
-      buf1.buffer[i]=0;
-      if constexpr(doublebuffer) {
-        buf2.buffer[i]=0;
-      }
-    }
+    sys::log_placement("buf1", buf1.data(), buf1.buffer.size());
     if(filename == nullptr) {
-      #pragma omp parallel for
-      for(int i = 0; i < w * h; ++i) {
-        buf1.buffer[i] = aut.init_state(i / buf1.w, i % buf1.w);
+      #pragma omp parallel for schedule(static)
+      for(int y = 0; y < h; ++y) {
+        for(int x = 0; x < w; ++x) {
+          buf1.buffer[y * w + x] = aut.init_state(y, x);
+        }
       }
     } else {
       RLEDecoder<StorageT>::read(filename, buf1);
       /* Life106Decoder<StorageT>::read(filename, buf1); */
     }
+    generation = 0;
+    if(detector.enabled()) {
+      grid_hash = period::hash_grid(buf1.data(), w * h);
+      detector.push(generation, grid_hash);
+    }
+    if(track_histogram) {
+      count_states();
+    }
     gl::Texture<GL_TEXTURE_2D>::init(tex);
+    if(extrabuf && gpu_downsample) {
+      // the whole grid is uploaded into tex and filtered down on the gpu
+      gl::Texture<GL_TEXTURE_2D>::bind(tex);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr); GLERROR
+      gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      gl::Texture<GL_TEXTURE_2D>::unbind();
+      downsampler.init(tw, th, glm::ivec2(w / tw, h / th), get_scale_states());
+    }
     reinit_texture();
   }
 
   void update_state() override {
+    update_buffers();
+    if(track_histogram) {
+      count_states();
+    }
+    reinit_texture();
+  }
+
+  void count_states() {
+    const StorageT *srcbuf = !current_buf ? &buf1 : &buf2;
+    histogram.assign(aut.no_states, 0);
+    #pragma omp parallel
+    {
+      std::vector<uint64_t> counts(aut.no_states, 0);
+      #pragma omp for schedule(static) nowait
+      for(int i = 0; i < w * h; ++i) {
+        ++counts[srcbuf->buffer[i]];
+      }
+      #pragma omp critical
+      for(int s = 0; s < aut.no_states; ++s) {
+        histogram[s] += counts[s];
+      }
+    }
+    histogram_generation = generation;
+  }
+
+  // zobrist delta of the cells [from, to); unchanged cells cost a compare
+  static uint64_t hash_delta(const uint8_t *src, const uint8_t *dst, int from, int to) {
+    uint64_t delta = 0;
+    for(int i = from; i < to; ++i) {
+      if(src[i] != dst[i]) {
+        delta ^= period::key(i, src[i]) ^ period::key(i, dst[i]);
+      }
+    }
+    return delta;
+  }
+
+  // temporal blocking: the board is cut into tiles that are copied to per-worker
+  // scratch with a halo of one cell per generation and stepped there, so that a
+  // sweep of several generations reads and writes the board once. the halo is
+  // recomputed by neighbouring tiles, and the owned cells come out exactly as
+  // generation by generation
+  static constexpr int block_h = 256, block_w = 256;
+  std::vector<uint8_t> scratch;
+
+  // scratch column or row of a halo cell, or -1 outside a bounded board
+  static int wrap(int i, int n) {
+    if constexpr(AccessMode == access_mode::looped) {
+      return ((i % n) + n) % n;
+    }
+    return (i < 0 || i >= n) ? -1 : i;
+  }
+
+  void update_block(const StorageT &src, StorageT &dst, int y0, int x0, int bh, int bw, int T,
+                    uint8_t *a, uint8_t *b, uint64_t *deltas, bool track_hash)
+  {
+    const int sw = bw + 2 * T, sh = bh + 2 * T;
+    const int gx0 = x0 - T;
+    for(int r = 0; r < sh; ++r) {
+      uint8_t *row = &a[r * sw];
+      const int gy = wrap(y0 - T + r, h);
+      if(gy < 0) {
+        std::fill_n(row, sw, uint8_t(AUT::outside_state));
+        continue;
+      }
+      const uint8_t *srow = &src.buffer[size_t(gy) * w];
+      if(gx0 >= 0 && gx0 + sw <= w) {
+        std::copy(srow + gx0, srow + gx0 + sw, row);
+        continue;
+      }
+      for(int c = 0; c < sw; ++c) {
+        const int gx = wrap(gx0 + c, w);
+        row[c] = (gx < 0) ? uint8_t(AUT::outside_state) : srow[gx];
+      }
+    }
+    // cells off a bounded board are never written, so both buffers keep them
+    std::copy(a, a + sw * sh, b);
+    int c0 = 0, c1 = sw;
+    if constexpr(AccessMode == access_mode::bounded) {
+      c0 = std::max(0, -gx0), c1 = std::min(sw, w - gx0);
+    }
+    for(int t = 1; t <= T; ++t) {
+      for(int r = t; r < sh - t; ++r) {
+        if(wrap(y0 - T + r, h) < 0) {
+          continue;
+        }
+        aut.next_row(&a[(r - 1) * sw], &a[r * sw], &a[(r + 1) * sw], &b[r * sw], std::max(t, c0), std::min(sw - t, c1));
+      }
+      if(track_hash) {
+        for(int r = T; r < T + bh; ++r) {
+          const uint8_t *pa = &a[r * sw + T], *pb = &b[r * sw + T];
+          const int i0 = (y0 + r - T) * w + x0;
+          for(int c = 0; c < bw; ++c) {
+            if(pa[c] != pb[c]) {
+              deltas[t - 1] ^= period::key(i0 + c, pa[c]) ^ period::key(i0 + c, pb[c]);
+            }
+          }
+        }
+      }
+      std::swap(a, b);
+    }
+    for(int r = T; r < T + bh; ++r) {
+      std::copy(&a[r * sw + T], &a[r * sw + T + bw], &dst.buffer[size_t(y0 + r - T) * w + x0]);
+    }
+  }
+
+  void update_blocked(int T) {
+    prof::ScopedTimer timer(prof::UPDATE);
+    StorageT *srcbuf = &buf1, *dstbuf = &buf2;
+    if(current_buf) {
+      std::swap(srcbuf, dstbuf);
+    }
+    const bool track_hash = detector.enabled();
+    sys::Scheduler &scheduler = sys::Scheduler::get();
+    const int no_workers = scheduler.no_threads();
+    const size_t scratch_size = (block_h + 2 * T) * (block_w + 2 * T);
+    scratch.resize(no_workers * 2 * scratch_size);
+    // per worker, rounded up to a cache line
+    const int stride = (T + 7) / 8 * 8;
+    std::vector<uint64_t> deltas(no_workers * stride, 0);
+    const int no_by = (h + block_h - 1) / block_h, no_bx = (w + block_w - 1) / block_w;
+    scheduler.run(size_t(no_by) * no_bx, 1, [&](size_t i, int worker) mutable -> void {
+      const int y0 = int(i / no_bx) * block_h, x0 = int(i % no_bx) * block_w;
+      uint8_t *a = &scratch[worker * 2 * scratch_size];
+      update_block(*srcbuf, *dstbuf, y0, x0, std::min(block_h, h - y0), std::min(block_w, w - x0), T,
+                   a, a + scratch_size, &deltas[worker * stride], track_hash);
+    });
+    for(int k = 1; k < no_workers; ++k) {
+      for(int t = 0; t < T; ++t) {
+        deltas[t] ^= deltas[k * stride + t];
+      }
+    }
+    current_buf = current_buf ? 0 : 1;
+    for(int t = 0; t < T; ++t) {
+      ++generation;
+      if(track_hash) {
+        grid_hash ^= deltas[t];
+        detector.push(generation, grid_hash);
+      }
+    }
+  }
+
+  // range-r neighbourhoods: each row's live cells are summed over a sliding window
+  // of 2r + 1 columns, and the box counts are a running sum of those row sums down
+  // the columns, so that a cell costs the same for any range. every band of rows
+  // keeps the row sums of its last 2r + 2 rows in a ring
+  std::vector<std::vector<uint32_t>> band_sums;
+
+  // live cells of board row r (wrapped or outside) within x - range .. x + range
+  void sum_row(const StorageT &src, int r, int range, uint32_t *sums, std::vector<uint8_t> &live) const {
+    const int gy = wrap(r, h);
+    if(gy < 0) {
+      std::fill_n(sums, w, 0);
+      return;
+    }
+    const int LIVE = aut.no_states - 1;
+    const uint8_t *row = &src.buffer[size_t(gy) * w];
+    live.resize(w + 2 * range);
+    for(int c = 0; c < w + 2 * range; ++c) {
+      const int gx = (c >= range && c < w + range) ? c - range : wrap(c - range, w);
+      live[c] = (gx >= 0) && row[gx] == LIVE;
+    }
+    uint32_t sum = 0;
+    for(int c = 0; c < 2 * range + 1; ++c) {
+      sum += live[c];
+    }
+    sums[0] = sum;
+    for(int x = 1; x < w; ++x) {
+      sum += live[x + 2 * range];
+      sum -= live[x - 1];
+      sums[x] = sum;
+    }
+  }
+
+  void update_summed() {
+    prof::ScopedTimer timer(prof::UPDATE);
+    StorageT *srcbuf = &buf1, *dstbuf = &buf2;
+    if(current_buf) {
+      std::swap(srcbuf, dstbuf);
+    }
+    const bool track_hash = detector.enabled();
+    const int range = aut.get_range();
+    const int LIVE = aut.no_states - 1;
+    const bool middle = aut.counts_middle();
+    const int ring = 2 * range + 2;
+    // contiguous bands, as in the static schedule of first_touch
+    const int no_bands = std::max(1, std::min(sys::get_max_threads(), h));
+    band_sums.resize(no_bands);
+    uint64_t delta = 0;
+    #pragma omp parallel for schedule(static, 1) reduction(^:delta)
+    for(int band = 0; band < no_bands; ++band) {
+      const int y0 = int(int64_t(h) * band / no_bands), y1 = int(int64_t(h) * (band + 1) / no_bands);
+      std::vector<uint32_t> &sums = band_sums[band];
+      sums.resize(size_t(ring + 1) * w);
+      uint32_t *counts = &sums[size_t(ring) * w];
+      std::vector<uint8_t> live;
+      auto &&ring_row = [&](int r) mutable -> uint32_t * {
+        return &sums[size_t(((r % ring) + ring) % ring) * w];
+      };
+      std::fill_n(counts, w, 0);
+      for(int r = y0 - range; r <= y0 + range; ++r) {
+        uint32_t *rs = ring_row(r);
+        sum_row(*srcbuf, r, range, rs, live);
+        for(int x = 0; x < w; ++x) {
+          counts[x] += rs[x];
+        }
+      }
+      for(int y = y0; y < y1; ++y) {
+        if(y > y0) {
+          // rows y + range and y - range - 1 are 2r + 1 apart, so they fall in different slots
+          uint32_t *in = ring_row(y + range);
+          const uint32_t *out = ring_row(y - range - 1);
+          sum_row(*srcbuf, y + range, range, in, live);
+          for(int x = 0; x < w; ++x) {
+            counts[x] += in[x] - out[x];
+          }
+        }
+        const uint8_t *src = &srcbuf->buffer[size_t(y) * w];
+        uint8_t *dst = &dstbuf->buffer[size_t(y) * w];
+        for(int x = 0; x < w; ++x) {
+          dst[x] = aut.transition(src[x], int(counts[x]) - (!middle && src[x] == LIVE));
+        }
+        if(track_hash) {
+          delta ^= hash_delta(srcbuf->data(), dstbuf->data(), y * w, (y + 1) * w);
+        }
+      }
+    }
+    current_buf = current_buf ? 0 : 1;
+    ++generation;
+    if(track_hash) {
+      grid_hash ^= delta;
+      detector.push(generation, grid_hash);
+    }
+  }
+
+  void update_buffers() {
+    if constexpr(doublebuffer && has_range_kernel<AUT>) {
+      update_summed();
+      return;
+    }
+    if constexpr(doublebuffer && has_row_kernel<AUT>) {
+      if(generations_per_update > 1) {
+        update_blocked(generations_per_update);
+        return;
+      }
+    }
+    prof::ScopedTimer timer(prof::UPDATE);
+    const bool track_hash = detector.enabled();
+    uint64_t delta = 0;
     if constexpr(doublebuffer) {
       StorageT *srcbuf = &buf1, *dstbuf = &buf2;
       if(current_buf) {
         std::swap(srcbuf, dstbuf);
       }
       static_assert(AUT::update_mode == ::update_mode::ALL, "ambiguous update mode");
-      if constexpr(AUT::update_mode == ::update_mode::ALL) {
-        #pragma omp parallel for
-        for(int i = 0; i < w*h; ++i) {
-          dstbuf->buffer[i] = aut.next_state(make_grid<4>([=](int y, int x) mutable -> typename StorageT::value_type {
+      if constexpr(AUT::update_mode == ::update_mode::ALL && has_row_kernel<AUT>) {
+        // border cells go through the access mode, the interior through the row kernel
+        auto &&update_cell = [&](int y, int x) mutable -> void {
+          dstbuf->buffer[y * w + x] = aut.next_state(make_grid<4>([=](int y, int x) mutable -> typename StorageT::value_type {
             return AccessT::access(*srcbuf, y, x);
-          }, w, h), i / w, i % w);
+          }, w, h), y, x);
+        };
+        #pragma omp parallel for schedule(static) reduction(^:delta)
+        for(int y = 0; y < h; ++y) {
+          const uint8_t *src = srcbuf->data();
+          if(y == 0 || y == h - 1 || w < 3) {
+            for(int x = 0; x < w; ++x) {
+              update_cell(y, x);
+            }
+          } else {
+            aut.next_row(&src[(y - 1) * w], &src[y * w], &src[(y + 1) * w], &dstbuf->data()[y * w], 1, w - 1);
+            update_cell(y, 0);
+            update_cell(y, w - 1);
+          }
+          if(track_hash) {
+            delta ^= hash_delta(src, dstbuf->data(), y * w, (y + 1) * w);
+          }
+        }
+      } else if constexpr(AUT::update_mode == ::update_mode::ALL) {
+        // by rows in the same schedule as first_touch, so that threads update their own pages
+        #pragma omp parallel for schedule(static) reduction(^:delta)
+        for(int y = 0; y < h; ++y) {
+          for(int i = y * w; i < (y + 1) * w; ++i) {
+            dstbuf->buffer[i] = aut.next_state(make_grid<4>([=](int y, int x) mutable -> typename StorageT::value_type {
+              return AccessT::access(*srcbuf, y, x);
+            }, w, h), y, i - y * w);
+            if(track_hash && srcbuf->buffer[i] != dstbuf->buffer[i]) {
+              delta ^= period::key(i, srcbuf->buffer[i]) ^ period::key(i, dstbuf->buffer[i]);
+            }
+          }
         }
       }
     } else {
@@ -207,6 +574,9 @@ struct Renderer<AUT, storage_mode::HOSTBUFFER, AccessMode> : public TexturedGrid
           auto [index, val] = aut.next_state(make_grid<4>([=](int y, int x) mutable -> typename StorageT::value_type {
             return AccessT::access(*srcbuf, y, x);
           }, w, h));
+          if(track_hash && dstbuf->buffer[index] != val) {
+            delta ^= period::key(index, dstbuf->buffer[index]) ^ period::key(index, val);
+          }
           dstbuf->buffer[index] = val;
         }
       }
@@ -214,16 +584,34 @@ struct Renderer<AUT, storage_mode::HOSTBUFFER, AccessMode> : public TexturedGrid
     if constexpr(doublebuffer) {
       current_buf = current_buf ? 0 : 1;
     }
-    reinit_texture();
+    ++generation;
+    if(track_hash) {
+      grid_hash ^= delta;
+      detector.push(generation, grid_hash);
+    }
+  }
+
+  // how many summed states map onto one displayed state
+  float get_scale_states() const {
+    const int area = (w / tw) * (h / th);
+    return fmax(1, float(area * (aut.no_states - 1) + 1) / no_states);
   }
 
   void reinit_texture() {
+    prof::ScopedTimer timer(prof::UPLOAD);
     const StorageT *srcbuf = !current_buf ? &buf1 : &buf2;
+    if(extrabuf && downsampler.is_active()) {
+      gl::Texture<GL_TEXTURE_2D>::bind(tex);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1); GLERROR
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED_INTEGER, GL_UNSIGNED_BYTE, srcbuf->data()); GLERROR
+      gl::Texture<GL_TEXTURE_2D>::unbind();
+      downsampler.run(tex);
+      return;
+    }
     if(extrabuf) {
       int per_x = w / tw;
       int per_y = h / th;
-      const int area = per_x * per_y;
-      const float scale_states = fmax(1, float(area * (aut.no_states - 1) + 1) / no_states);
+      const float scale_states = get_scale_states();
       #pragma omp parallel for
       for(int i = 0; i < tw*th; ++i) {
         uint16_t sum = 0;
@@ -248,7 +636,26 @@ struct Renderer<AUT, storage_mode::HOSTBUFFER, AccessMode> : public TexturedGrid
   }
 
   GLuint get_current_texture_id() override {
-    return tex;
+    return downsampler.is_active() ? downsampler.get_texture() : tex;
+  }
+
+  void read_frame(std::vector<uint8_t> &frame) override {
+    const StorageT *srcbuf = !current_buf ? &buf1 : &buf2;
+    frame.assign(srcbuf->buffer.begin(), srcbuf->buffer.end());
+  }
+
+  bool write_frame(const std::vector<uint8_t> &frame, size_t generation_) override {
+    StorageT *dstbuf = !current_buf ? &buf1 : &buf2;
+    if(frame.size() != dstbuf->buffer.size()) {
+      return false;
+    }
+    std::copy(frame.begin(), frame.end(), dstbuf->buffer.begin());
+    restart_detector(generation_, frame.data());
+    if(track_histogram) {
+      count_states();
+    }
+    reinit_texture();
+    return true;
   }
 
   void clear() override {
@@ -263,9 +670,11 @@ struct Renderer<AUT, storage_mode::HOSTBUFFER, AccessMode> : public TexturedGrid
   }
 };
 
-template <access_mode AccessMode>
-struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGridRenderer {
-  using AUT = ca::BSC;
+// any outer-totalistic rule exposing get_rule(): ca::BSC and ca::StaticBSC of
+// any neighbourhood within the 3x3 box, and larger than life, which is stepped by LtlUpdater instead of bsc.comp;
+// rule tables are stepped by TableUpdater
+template <typename AUT, access_mode AccessMode>
+struct Renderer<AUT, storage_mode::TEXTURES, AccessMode> : public TexturedGridRenderer {
   using parent_t = TexturedGridRenderer;
   using StorageT = RenderStorage<storage_mode::HOSTBUFFER>;
 
@@ -275,6 +684,8 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
 
   int8_t current_tex = 0;
   GLuint tex1 = 0, tex2 = 0;
+  // display size for negative zoom
+  int tw = 0, th = 0;
   glm::ivec2 wg_per_cell = glm::ivec2(1, 1);
   bool largetexture = false;
 
@@ -286,9 +697,28 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
   gl::Uniform<gl::UniformType::IVEC2> uSize, uWgPerCell;
   gl::Uniform<gl::UniformType::UINTEGER> uAccessMode;
   gl::ShaderProgram<gl::ComputeShader> computeUpdate;
-  static constexpr int local_size = 8;
+  LtlUpdater ltl;
+  TableUpdater table;
+  WorkGroupConfig wg_config;
   const int max_wg_invocations;
   glm::ivec2 wg_size = glm::ivec2(0, 0);
+  // every dispatch xors the zobrist delta of its generation into one of these.
+  // they are read back hash_lag generations later, once the fence placed after
+  // the dispatch is signalled, so the readback never stalls the pipeline
+  static constexpr int hash_lag = 3;
+  std::array<GLuint, hash_lag + 1> hash_bufs = {};
+  std::array<GLsync, hash_lag + 1> hash_fences = {};
+  size_t hash_generation = 0;
+  // the display lags one generation behind the last texture written
+  size_t frame_generation = 0;
+  // per-state counts, reduced on the gpu and read back a generation later behind a fence
+  gl::Uniform<gl::UniformType::SAMPLER2D> uHistSrcTex;
+  gl::Uniform<gl::UniformType::UINTEGER> uHistNStates;
+  gl::Uniform<gl::UniformType::IVEC2> uHistSize, uHistWgPerCell;
+  gl::ShaderProgram<gl::ComputeShader> computeHistogram;
+  std::array<GLuint, 2> histogram_bufs = {};
+  std::array<GLsync, 2> histogram_fences = {};
+  std::array<size_t, 2> histogram_gens = {};
 
   using ShaderProgramCompute = decltype(computeUpdate);
 
@@ -306,7 +736,12 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
     uSize("size"s), uWgPerCell("wg_per_cell"),
     uAccessMode("access_mode"s),
     computeUpdate({std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("bsc.comp"s))}),
-    max_wg_invocations(ShaderProgramCompute::get_max_wg_invocations())
+    ltl(dir),
+    table(dir),
+    max_wg_invocations(ShaderProgramCompute::get_max_wg_invocations()),
+    uHistSrcTex("srcTex"s), uHistNStates("n_states"s),
+    uHistSize("size"s), uHistWgPerCell("wg_per_cell"s),
+    computeHistogram({std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("histogram.comp"s))})
   {}
 
   void set_grid_size(int w_, int h_, int zoom) override {
@@ -319,23 +754,116 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
     }
     Logger::Info("[w %d, h %d]\n", w, h);
     largetexture = (zoom < 0);
+    tw = w_, th = h_;
     if(zoom < 0) {
       parent_t::colorscheme = 1;
+      no_states = std::min<int>(256, zoom * zoom * (aut.no_states - 1) + 1);
     }
     set_work_group_sizes();
   }
 
   void set_work_group_sizes() {
-    const glm::ivec2 max_wg_size = ShaderProgramCompute::get_max_wgsize();
-    glm::ivec2 max_invocations = max_wg_size * local_size;
-    wg_per_cell = (glm::ivec2(w, h) + max_invocations - 1) / max_invocations + 1;
-//    Logger::Info("[max_invocations/w = %d/%d = %.2f wg_per_cell_x %d]\n", max_invocations, w, float(max_invocations) / float(w), wg_per_cell.x);
-//    Logger::Info("[max_invocations/h = %d/%d = %.2f wg_per_cell_y %d]\n", max_invocations, w, float(max_invocations) / float(h), wg_per_cell.y);
+    const int local_size = wg_config.local_size;
+    // the number of work groups per dimension is limited, so large grids need more cells per invocation
+    const glm::ivec2 max_wg_count = ShaderProgramCompute::get_max_wgcount();
+    const glm::ivec2 max_invocations = max_wg_count * local_size;
+    const glm::ivec2 min_per_cell = (glm::ivec2(w, h) + max_invocations - 1) / max_invocations;
+    wg_per_cell = glm::max(wg_config.cells_per_invocation, min_per_cell);
     glm::ivec2 per_cell = wg_per_cell * local_size;
     wg_size = (glm::ivec2(w, h) + per_cell - 1) / per_cell;
     Logger::Info("[wg %dx%dx%d %dx%dx%d]\n", wg_size.x, local_size, wg_per_cell.x, wg_size.y, local_size, wg_per_cell.y);
   }
 
+  // times every candidate configuration on the freshly allocated textures, tex1 -> tex2,
+  // so that tex1 keeps whatever was loaded into it
+  GLuint get_hash_buffer(size_t gen) const {
+    return hash_bufs[gen % hash_bufs.size()];
+  }
+
+  GLsync &get_hash_fence(size_t gen) {
+    return hash_fences[gen % hash_fences.size()];
+  }
+
+  // placed after the dispatch that writes the delta of gen
+  void fence_hash(size_t gen) {
+    gl::Fence::clear(get_hash_fence(gen));
+    gl::Fence::init(get_hash_fence(gen));
+  }
+
+  // folds the deltas of finished generations into grid_hash, oldest first, and
+  // stops at the first one whose fence is not signalled yet. with wait set, it
+  // blocks for the oldest one instead, whose buffer is about to be reused
+  void poll_hash(bool wait=false) {
+    while(hash_generation + hash_lag <= generation) {
+      GLsync &fence = get_hash_fence(hash_generation);
+      if(fence != nullptr && !gl::Fence::is_signaled(fence, wait)) {
+        break;
+      }
+      gl::Fence::clear(fence);
+      wait = false;
+      GLuint delta[2] = {0, 0};
+      gl::StorageBuffer::read(get_hash_buffer(hash_generation), delta, 2);
+      grid_hash ^= (uint64_t(delta[1]) << 32) | delta[0];
+      detector.push(hash_generation, grid_hash);
+      ++hash_generation;
+    }
+  }
+
+  // the neighbourhood is compiled into bsc.comp, so that its loop unrolls to the cells it reads
+  std::string update_defines() const {
+    std::string defines = wg_config.defines();
+    if constexpr(!has_range_kernel<AUT> && !has_rule_table<AUT>) {
+      defines += "#define STENCIL " + std::to_string(aut.get_rule().stencil) + "u\n";
+    }
+    return defines;
+  }
+
+  void autotune_work_groups() {
+    // the candidates are timed on bsc.comp; ltl.comp and table.comp have their own fixed layouts
+    if constexpr(has_range_kernel<AUT> || has_rule_table<AUT>) {
+      set_work_group_sizes();
+      return;
+    }
+    const std::string key = WorkGroupTuner::make_key(ShaderProgramCompute::get_gl_identity(), w, h);
+    if(WorkGroupTuner::load(key, wg_config)) {
+      Logger::Info("[wg tune] cached local %d cells %dx%d\n", wg_config.local_size, wg_config.cells_per_invocation.x, wg_config.cells_per_invocation.y);
+      set_work_group_sizes();
+      return;
+    }
+    const auto configs = WorkGroupTuner::candidates(glm::ivec2(w, h), max_wg_invocations, ShaderProgramCompute::get_max_wgcount());
+    if(configs.empty()) {
+      set_work_group_sizes();
+      return;
+    }
+    wg_config = WorkGroupTuner::tune(configs,
+      [&](const WorkGroupConfig &config) mutable -> void {
+        wg_config = config;
+        set_work_group_sizes();
+        computeUpdate.set_defines(update_defines());
+        ShaderProgramCompute::compile_program(computeUpdate);
+        computeUpdate.assign_uniforms(
+          uSrcTex, uDstTex,
+          uBs, uSs, uC,
+          uSize, uWgPerCell,
+          uAccessMode
+        );
+      },
+      [&]() mutable -> void {
+        dispatch_update(tex1, tex2, get_hash_buffer(0));
+      },
+      [&]() mutable -> void {
+        ShaderProgramCompute::clear(computeUpdate);
+        ShaderProgramCompute::unassign_uniforms(
+          uSrcTex, uDstTex,
+          uBs, uSs, uC,
+          uSize, uWgPerCell,
+          uAccessMode
+        );
+      });
+    WorkGroupTuner::store(key, wg_config);
+    set_work_group_sizes();
+  }
+
   #define COMPUTE_INIT_SOUP
   void init_textures(const char *filename=nullptr) override {
     for(GLuint *tex_ptr : {&tex1, &tex2}) {
@@ -350,6 +878,7 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
 //          buf.buffer[i] = aut.init_state(i/w, i%w);
 //        }
         RLEDecoder<RenderStorage<storage_mode::HOSTBUFFER>>::read(filename, buf);
+        grid_hash = period::hash_grid(buf.data(), w * h);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, buf.buffer.data()); GLERROR
       } else {
         glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr); GLERROR
@@ -360,6 +889,12 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
       gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
       gl::Texture<GL_TEXTURE_2D>::unbind();
     }
+    for(GLuint &ssbo : hash_bufs) {
+      gl::StorageBuffer::init(ssbo, 2 * sizeof(GLuint));
+    }
+    autotune_work_groups();
+    computeInitSoup.set_defines(wg_config.defines());
+    computeUpdate.set_defines(update_defines());
     //#ifdef COMPUTE_INIT_SOUP
     if(filename == nullptr) {
       ShaderProgramCompute::compile_program(computeInitSoup);
@@ -374,24 +909,108 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
         uSize, uWgPerCell, uSeed
       );
     }
+    // the soup shader hashes generation 0 on the gpu, a loaded pattern was hashed above
+    generation = 0;
+    hash_generation = 0;
+    frame_generation = 0;
+    if(filename != nullptr) {
+      detector.push(0, grid_hash);
+      hash_generation = 1;
+    } else {
+      grid_hash = 0;
+    }
     //#endif
-    ShaderProgramCompute::compile_program(computeUpdate);
-    computeUpdate.assign_uniforms(
-      uSrcTex, uDstTex,
-      uBs, uSs, uC,
-      uSize, uWgPerCell,
-      uAccessMode
-    );
+    if constexpr(has_range_kernel<AUT>) {
+      ltl.init(w, h, aut.get_range());
+    } else if constexpr(has_rule_table<AUT>) {
+      table.init(w, h, aut.get_table());
+    } else {
+      ShaderProgramCompute::compile_program(computeUpdate);
+      computeUpdate.assign_uniforms(
+        uSrcTex, uDstTex,
+        uBs, uSs, uC,
+        uSize, uWgPerCell,
+        uAccessMode
+      );
+    }
+    if(largetexture) {
+      const float scale_states = fmax(1, float((w / tw) * (h / th) * (aut.no_states - 1) + 1) / no_states);
+      downsampler.init(tw, th, glm::ivec2(w / tw, h / th), scale_states);
+      downsampler.run(get_grid_texture_id());
+    }
+    if(track_histogram) {
+      computeHistogram.set_defines(wg_config.defines());
+      ShaderProgramCompute::compile_program(computeHistogram);
+      computeHistogram.assign_uniforms(uHistSrcTex, uHistNStates, uHistSize, uHistWgPerCell);
+      for(GLuint &ssbo : histogram_bufs) {
+        gl::StorageBuffer::init(ssbo, aut.no_states * sizeof(GLuint));
+      }
+      dispatch_histogram(tex1);
+    }
     ShaderProgramCompute::print_compute_capabilities();
   }
 
+  void dispatch_histogram(GLuint srctex) {
+    const int slot = generation % histogram_bufs.size();
+    // the slot still holds generation - 2 if it could not be read in time
+    if(histogram_fences[slot] != nullptr) {
+      read_histogram(slot, true);
+    }
+    gl::StorageBuffer::zero(histogram_bufs[slot]);
+    ShaderProgramCompute::use(computeHistogram);
+    uHistSrcTex.set_data(0);
+    uHistNStates.set_data(aut.no_states);
+    glm::ivec2 val_size(w, h);
+    uHistSize.set_data(val_size);
+    uHistWgPerCell.set_data(wg_per_cell);
+    glBindImageTexture(0, srctex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8UI); GLERROR
+    gl::StorageBuffer::bind_base(histogram_bufs[slot], 1);
+    ShaderProgramCompute::dispatch(wg_size.x, wg_size.y, 1);
+    ShaderProgramCompute::barrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    ShaderProgramCompute::unuse();
+    gl::Fence::init(histogram_fences[slot]);
+    histogram_gens[slot] = generation;
+  }
+
+  // returns false if the counts are not there yet and wait is not set
+  bool read_histogram(int slot, bool wait=false) {
+    if(!gl::Fence::is_signaled(histogram_fences[slot], wait)) {
+      return false;
+    }
+    gl::Fence::clear(histogram_fences[slot]);
+    std::vector<GLuint> counts(aut.no_states);
+    gl::StorageBuffer::read(histogram_bufs[slot], counts.data(), counts.size());
+    // an older slot may land after a newer one was forced out
+    if(histogram_gens[slot] >= histogram_generation || histogram.empty()) {
+      histogram.assign(counts.begin(), counts.end());
+      histogram_generation = histogram_gens[slot];
+    }
+    return true;
+  }
+
+  void poll_histogram() {
+    const int slot = (generation + 1) % histogram_bufs.size();
+    if(histogram_fences[slot] != nullptr) {
+      read_histogram(slot);
+    }
+  }
+
+  void flush_histogram() override {
+    for(size_t gen = generation + 1; gen <= generation + histogram_bufs.size(); ++gen) {
+      const int slot = gen % histogram_bufs.size();
+      if(histogram_fences[slot] != nullptr) {
+        read_histogram(slot, true);
+      }
+    }
+  }
+
   void set_data_compute_init_soup() {
     uInitTex.set_data(0);
     uNStates.set_data(aut.no_states);
     glm::ivec2 val_size(w, h);
     uSize.set_data(val_size);
     uWgPerCell.set_data(wg_per_cell);
-    uSeed.set_data(rand());
+    uSeed.set_data(rng::get_seed());
   }
 
   void init_state_soup() {
@@ -399,18 +1018,20 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
     set_data_compute_init_soup();
     GLuint inittex = tex1;
     glBindImageTexture(0, inittex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI); GLERROR
+    gl::StorageBuffer::zero(get_hash_buffer(0));
+    gl::StorageBuffer::bind_base(get_hash_buffer(0), 0);
     ShaderProgramCompute::dispatch(wg_size.x, wg_size.y, 1);
-    ShaderProgramCompute::barrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    ShaderProgramCompute::barrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
     ShaderProgramCompute::unuse();
+    fence_hash(0);
   }
 
   void set_data_compute_update() {
     uSrcTex.set_data(0);
     uDstTex.set_data(1);
-    int bs = int(aut.bs_bitmask.to_ulong());;
-    uBs.set_data(bs);
-    int ss = int(aut.ss_bitmask.to_ulong());;
-    uSs.set_data(ss);
+    const ca::RuleSpec rule = aut.get_rule();
+    uBs.set_data(rule.birth);
+    uSs.set_data(rule.survival);
     uC.set_data(aut.no_states);
     glm::ivec2 val_size(w, h);
     uSize.set_data(val_size);
@@ -418,38 +1039,1625 @@ struct Renderer<ca::BSC, storage_mode::TEXTURES, AccessMode> : public TexturedGr
     uAccessMode.set_data(AccessMode);
   }
 
-  void update_state() override {
-    ShaderProgramCompute::use(computeUpdate);
-    set_data_compute_update();
-    GLuint srctex = current_tex?tex2:tex1,
-           dsttex = current_tex?tex1:tex2;
-    glBindImageTexture(0, srctex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8UI); GLERROR
-    glBindImageTexture(1, dsttex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI); GLERROR
-    ShaderProgramCompute::dispatch(wg_size.x, wg_size.y, 1);
-    ShaderProgramCompute::barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
-    //computeUpdate.barrier(GL_ALL_BARRIER_BITS); GLERROR
-    //glFinish(); GLERROR
-    ShaderProgramCompute::unuse();
+  void dispatch_update(GLuint srctex, GLuint dsttex, GLuint hashbuf) {
+    if constexpr(has_range_kernel<AUT>) {
+      ltl.run(srctex, dsttex, hashbuf, aut.get_ltl(), AccessMode);
+    } else if constexpr(has_rule_table<AUT>) {
+      table.run(srctex, dsttex, hashbuf, AccessMode);
+    } else {
+      ShaderProgramCompute::use(computeUpdate);
+      set_data_compute_update();
+      glBindImageTexture(0, srctex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8UI); GLERROR
+      glBindImageTexture(1, dsttex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI); GLERROR
+      gl::StorageBuffer::bind_base(hashbuf, 0);
+      ShaderProgramCompute::dispatch(wg_size.x, wg_size.y, 1);
+      ShaderProgramCompute::barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+      //computeUpdate.barrier(GL_ALL_BARRIER_BITS); GLERROR
+      //glFinish(); GLERROR
+      ShaderProgramCompute::unuse();
+    }
+  }
+
+  // the texture stepped from is displayed next, the one written is stepped from after
+  void step_textures() {
+    // a delta that is still unread when its buffer comes round again has to be waited for
+    if(detector.enabled() && hash_generation + hash_bufs.size() <= generation + 1) {
+      poll_hash(true);
+    }
+    gl::StorageBuffer::zero(get_hash_buffer(generation + 1));
+    dispatch_update(current_tex?tex2:tex1, current_tex?tex1:tex2, get_hash_buffer(generation + 1));
+    if(detector.enabled()) {
+      fence_hash(generation + 1);
+    }
     current_tex = current_tex ? 0 : 1;
+    frame_generation = generation++;
+  }
+
+  void update_state() override {
+    {
+      prof::ScopedTimer timer(prof::UPDATE);
+      prof::ScopedGPUTimer gpu_timer(prof::GPU_UPDATE);
+      step_textures();
+    }
+    if(detector.enabled()) {
+      poll_hash();
+    }
+    if(track_histogram) {
+      poll_histogram();
+      // the texture just written, the display lags one generation behind it
+      dispatch_histogram(current_tex ? tex2 : tex1);
+    }
+    prof::ScopedTimer timer(prof::UPLOAD);
+    if(largetexture) {
+      downsampler.run(get_grid_texture_id());
+      return;
+    }
     gl::Texture<GL_TEXTURE_2D>::bind(get_current_texture_id());
     glGenerateMipmap(GL_TEXTURE_2D); GLERROR
     gl::Texture<GL_TEXTURE_2D>::unbind();
   }
 
-  GLuint get_current_texture_id() override {
+  GLuint get_grid_texture_id() const {
     return current_tex ? tex1 : tex2;
   }
 
+  GLuint get_current_texture_id() override {
+    return downsampler.is_active() ? downsampler.get_texture() : get_grid_texture_id();
+  }
+
+  void read_frame(std::vector<uint8_t> &frame) override {
+    frame.resize(w * h);
+    gl::Texture<GL_TEXTURE_2D>::bind(get_grid_texture_id());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); GLERROR
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, frame.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+  }
+
+  size_t get_frame_generation() const override {
+    return frame_generation;
+  }
+
+  // the frame goes into the texture stepped from next, and is stepped once right
+  // away: as after update_state, the frame is displayed while the texture one
+  // generation ahead of it is stepped from, so the next step shows its successor
+  bool write_frame(const std::vector<uint8_t> &frame, size_t generation_) override {
+    if(frame.size() != size_t(w) * h) {
+      return false;
+    }
+    gl::Texture<GL_TEXTURE_2D>::bind(current_tex ? tex2 : tex1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); GLERROR
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED_INTEGER, GL_UNSIGNED_BYTE, frame.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    restart_detector(generation_, frame.data());
+    // deltas of the generations after this one are dropped, the next dispatch zeroes its buffer
+    hash_generation = generation + 1;
+    step_textures();
+    if(track_histogram) {
+      for(GLsync &fence : histogram_fences) {
+        if(fence != nullptr) {
+          gl::Fence::clear(fence);
+        }
+      }
+      histogram.clear();
+      dispatch_histogram(current_tex ? tex2 : tex1);
+    }
+    if(largetexture) {
+      downsampler.run(get_grid_texture_id());
+    } else {
+      gl::Texture<GL_TEXTURE_2D>::bind(get_current_texture_id());
+      glGenerateMipmap(GL_TEXTURE_2D); GLERROR
+      gl::Texture<GL_TEXTURE_2D>::unbind();
+    }
+    return true;
+  }
+
   void clear() override {
     gl::Texture<GL_TEXTURE_2D>::clear(tex1);
     gl::Texture<GL_TEXTURE_2D>::clear(tex2);
-    ShaderProgramCompute::clear(computeUpdate);
-    ShaderProgramCompute::unassign_uniforms(
-      uSrcTex, uDstTex,
-      uBs, uSs, uC,
-      uSize, uWgPerCell,
-      uAccessMode
-    );
+    for(GLuint &ssbo : hash_bufs) {
+      gl::StorageBuffer::clear(ssbo);
+    }
+    for(GLsync &fence : hash_fences) {
+      gl::Fence::clear(fence);
+    }
+    if(track_histogram) {
+      for(int slot = 0; slot < int(histogram_bufs.size()); ++slot) {
+        gl::Fence::clear(histogram_fences[slot]);
+        gl::StorageBuffer::clear(histogram_bufs[slot]);
+      }
+      ShaderProgramCompute::clear(computeHistogram);
+      ShaderProgramCompute::unassign_uniforms(uHistSrcTex, uHistNStates, uHistSize, uHistWgPerCell);
+    }
+    if constexpr(has_range_kernel<AUT>) {
+      ltl.clear();
+    } else if constexpr(has_rule_table<AUT>) {
+      table.clear();
+    } else {
+      ShaderProgramCompute::clear(computeUpdate);
+      ShaderProgramCompute::unassign_uniforms(
+        uSrcTex, uDstTex,
+        uBs, uSs, uC,
+        uSize, uWgPerCell,
+        uAccessMode
+      );
+    }
+    parent_t::clear();
+  }
+};
+
+// unbounded plane of tiles; only the viewport [0, w) x [0, h) is rasterized and uploaded.
+// for two-dimensional rules of radius 1 that keep empty space empty
+template <typename AUT, access_mode AccessMode>
+struct Renderer<AUT, storage_mode::SPARSE, AccessMode> : public TexturedGridRenderer {
+  using parent_t = TexturedGridRenderer;
+  using StorageT = Storage<4, storage_mode::SPARSE, uint8_t>;
+  using ViewT = RenderStorage<storage_mode::HOSTBUFFER>;
+  using Tile = typename StorageT::Tile;
+  static constexpr int tile_size = StorageT::tile_size;
+  // a tile with a border of one cell from its neighbours
+  static constexpr int pad_size = tile_size + 2;
+
+  AUT &aut;
+  using parent_t::w;
+  using parent_t::h;
+
+  int tw, th;
+  GLuint tex = 0;
+  StorageT grid;
+  ViewT view;
+  // the cell of the plane at the bottom left of the viewport; the arrows pan,
+  // home returns to the origin and F keeps the live tiles in the middle
+  int view_y = 0, view_x = 0;
+  bool follow = false;
+  // the cell indices of the plane collide, so a hash match is only a candidate:
+  // the tiles are copied at the match, and the period is reported once they come
+  // back exactly that many generations later. the rule is deterministic, so from
+  // then on the plane repeats for good
+  struct PeriodCheck {
+    std::vector<std::pair<uint64_t, Tile>> tiles;
+    size_t generation = 0;
+    int period = 0;
+    bool confirmed = false;
+  } period_check;
+  std::vector<uint64_t> candidates;
+  std::vector<Tile *> results;
+  // per-worker scratch of the update
+  std::vector<uint8_t> pads, rows;
+
+  static_assert(AUT::update_mode == ::update_mode::ALL, "sparse storage steps every cell");
+
+  storage_mode get_storage_mode() override {
+    return storage_mode::SPARSE;
+  }
+
+  explicit Renderer(AUT &_aut, const std::string &dir):
+    parent_t(_aut.no_states, dir),
+    aut(_aut),
+    tw(0), th(0)
+  {}
+
+  void set_grid_size(int w_, int h_, int zoom) override {
+    if(zoom == 0 || (zoom < 0 && !gpu_downsample)) {
+      zoom = 1;
+    }
+    if(zoom > 0) {
+      w_ /= zoom, h_ /= zoom;
+      tw = w_, th = h_;
+    } else {
+      tw = w_, th = h_;
+      w_ *= -zoom, h_ *= -zoom;
+      parent_t::colorscheme = 1;
+      no_states = std::min<int>(256, zoom * zoom * (aut.no_states - 1) + 1);
+    }
+    w = w_, h = h_;
+    Logger::Info("[sparse view %d %d] [%d %d]\n", w, h, tw, th);
+  }
+
+  // cells anywhere on the plane get a zobrist index, which may collide: see PeriodCheck
+  static uint32_t cell_index(int y, int x) {
+    return rng::hash(uint32_t(y)) ^ uint32_t(x);
+  }
+
+  void init_textures(const char *filename=nullptr) override {
+    view.init(w, h);
+    if(filename == nullptr) {
+      for(int y = 0; y < h; ++y) {
+        for(int x = 0; x < w; ++x) {
+          grid.set(y, x, aut.init_state(y, x));
+        }
+      }
+    } else {
+      RLEDecoder<ViewT>::read(filename, view);
+      for(int i = 0; i < w * h; ++i) {
+        grid.set(i / w, i % w, view.buffer[i]);
+      }
+    }
+    generation = 0;
+    if(detector.enabled()) {
+      grid_hash = 0;
+      for(const auto &[k, tile] : grid.tiles) {
+        grid_hash ^= hash_tile(StorageT::key_y(k), StorageT::key_x(k), nullptr, tile);
+      }
+      period_check = PeriodCheck();
+      detector.push(generation, grid_hash);
+      check_period();
+    }
+    if(track_histogram) {
+      count_states();
+    }
+    gl::Texture<GL_TEXTURE_2D>::init(tex);
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    if(w != tw || h != th) {
+      const float scale_states = fmax(1, float((w / tw) * (h / th) * (aut.no_states - 1) + 1) / no_states);
+      downsampler.init(tw, th, glm::ivec2(w / tw, h / th), scale_states);
+    }
+    reinit_texture();
+  }
+
+  void update_state() override {
+    update_tiles();
+    if(track_histogram) {
+      count_states();
+    }
+    reinit_texture();
+  }
+
+  // zobrist delta between two versions of a tile, either of which may be missing
+  static uint64_t hash_tile(int ty, int tx, const Tile *src, const Tile *dst) {
+    uint64_t delta = 0;
+    for(int i = 0; i < tile_size * tile_size; ++i) {
+      const uint8_t a = src ? src->cells[i] : 0, b = dst ? dst->cells[i] : 0;
+      if(a != b) {
+        const uint32_t index = cell_index(ty * tile_size + i / tile_size, tx * tile_size + i % tile_size);
+        delta ^= period::key(index, a) ^ period::key(index, b);
+      }
+    }
+    return delta;
+  }
+
+  // copies the tile and the facing borders of its neighbours; false if all of it is empty
+  bool gather(int ty, int tx, uint8_t *pad) const {
+    bool any = false;
+    for(int dy = -1; dy <= 1; ++dy) {
+      for(int dx = -1; dx <= 1; ++dx) {
+        const Tile *tile = grid.find(ty + dy, tx + dx);
+        // the part of the neighbour that lands in the pad, in its own coordinates
+        const int y0 = (dy < 0) ? tile_size - 1 : 0, y1 = (dy > 0) ? 1 : tile_size;
+        const int x0 = (dx < 0) ? tile_size - 1 : 0, x1 = (dx > 0) ? 1 : tile_size;
+        for(int y = y0; y < y1; ++y) {
+          uint8_t *dst = &pad[(y + 1 + dy * tile_size) * pad_size + (x0 + 1 + dx * tile_size)];
+          if(tile == nullptr) {
+            std::fill_n(dst, x1 - x0, 0);
+            continue;
+          }
+          const uint8_t *src = &tile->cells[y * tile_size + x0];
+          std::copy(src, src + (x1 - x0), dst);
+          any = any || std::any_of(src, src + (x1 - x0), [](uint8_t c) -> bool { return c != 0; });
+        }
+      }
+    }
+    return any;
+  }
+
+  // steps every tile and its neighbours. the live tiles are spread unevenly, so
+  // candidates go through the work-stealing scheduler; each worker takes result
+  // tiles from its own pool and gives the empty ones straight back
+  void update_tiles() {
+    prof::ScopedTimer timer(prof::UPDATE);
+    candidates.clear();
+    for(const auto &[k, tile] : grid.tiles) {
+      const int ty = StorageT::key_y(k), tx = StorageT::key_x(k);
+      for(int dy = -1; dy <= 1; ++dy) {
+        for(int dx = -1; dx <= 1; ++dx) {
+          candidates.push_back(StorageT::key(ty + dy, tx + dx));
+        }
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    results.assign(candidates.size(), nullptr);
+    const bool track_hash = detector.enabled();
+    sys::Scheduler &scheduler = sys::Scheduler::get();
+    const int no_workers = scheduler.no_threads();
+    pads.resize(no_workers * pad_size * pad_size);
+    rows.resize(no_workers * pad_size);
+    // a cache line per worker
+    std::vector<uint64_t> deltas(no_workers * 8, 0);
+    scheduler.run(candidates.size(), 4, [&](size_t i, int worker) mutable -> void {
+      uint8_t *pad = &pads[worker * pad_size * pad_size];
+      uint8_t *row = &rows[worker * pad_size];
+      const int ty = StorageT::key_y(candidates[i]), tx = StorageT::key_x(candidates[i]);
+      if(!gather(ty, tx, pad)) {
+        return;
+      }
+      Tile &dst = *grid.allocate(false, worker);
+      for(int y = 0; y < tile_size; ++y) {
+        uint8_t *out = &dst.cells[y * tile_size];
+        if constexpr(has_row_kernel<AUT>) {
+          aut.next_row(&pad[y * pad_size], &pad[(y + 1) * pad_size], &pad[(y + 2) * pad_size], row, 1, tile_size + 1);
+          std::copy(&row[1], &row[tile_size + 1], out);
+        } else {
+          const uint8_t *src = pad;
+          auto &&padgrid = make_grid<4>([=](int y, int x) mutable -> uint8_t {
+            return src[(y + 1) * pad_size + (x + 1)];
+          }, tile_size, tile_size);
+          for(int x = 0; x < tile_size; ++x) {
+            out[x] = aut.next_state(padgrid, y, x);
+          }
+        }
+      }
+      const bool nonempty = std::any_of(dst.cells, dst.cells + tile_size * tile_size, [](uint8_t c) -> bool { return c != 0; });
+      if(track_hash) {
+        deltas[worker * 8] ^= hash_tile(ty, tx, grid.find(ty, tx), nonempty ? &dst : nullptr);
+      }
+      if(nonempty) {
+        results[i] = &dst;
+      } else {
+        grid.release(&dst, worker);
+      }
+    });
+    uint64_t delta = 0;
+    for(const uint64_t d : deltas) {
+      delta ^= d;
+    }
+    for(auto &[k, tile] : grid.tiles) {
+      grid.release(tile);
+    }
+    grid.pools.rebalance();
+    grid.tiles.clear();
+    for(size_t i = 0; i < candidates.size(); ++i) {
+      if(results[i] != nullptr) {
+        grid.tiles.emplace(candidates[i], results[i]);
+      }
+    }
+    ++generation;
+    if(track_hash) {
+      grid_hash ^= delta;
+      detector.push(generation, grid_hash);
+      check_period();
+    }
+  }
+
+  // sorted by key
+  void copy_tiles(std::vector<std::pair<uint64_t, Tile>> &copy) const {
+    copy.clear();
+    copy.reserve(grid.tiles.size());
+    for(const auto &[k, tile] : grid.tiles) {
+      copy.emplace_back(k, *tile);
+    }
+    std::sort(copy.begin(), copy.end(), [](const auto &a, const auto &b) -> bool { return a.first < b.first; });
+  }
+
+  bool same_tiles(const std::vector<std::pair<uint64_t, Tile>> &copy) const {
+    if(copy.size() != grid.tiles.size()) {
+      return false;
+    }
+    for(const auto &[k, tile] : copy) {
+      const auto found = grid.tiles.find(k);
+      if(found == grid.tiles.end() || !std::equal(tile.cells, tile.cells + tile_size * tile_size, found->second->cells)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // after every push: the detector reports a period only once the tiles confirm it
+  void check_period() {
+    PeriodCheck &check = period_check;
+    if(check.confirmed) {
+      detector.period = check.period, detector.since = check.generation;
+      return;
+    }
+    const int found = detector.period;
+    detector.period = 0;
+    if(check.period != 0 && generation == check.generation + check.period) {
+      if(same_tiles(check.tiles)) {
+        check.confirmed = true;
+        check.tiles.clear();
+        detector.period = check.period, detector.since = check.generation;
+        return;
+      }
+      Logger::Debug("[sparse] hash collision: period %d at generation %lu\n", check.period, check.generation);
+      check.period = 0;
+    }
+    if(check.period == 0 && found != 0) {
+      copy_tiles(check.tiles);
+      check.generation = generation, check.period = found;
+    }
+  }
+
+  // dead cells are only counted inside allocated tiles, the plane itself has no size
+  void count_states() {
+    histogram.assign(aut.no_states, 0);
+    for(const auto &[k, tile] : grid.tiles) {
+      for(int i = 0; i < tile_size * tile_size; ++i) {
+        ++histogram[tile->cells[i]];
+      }
+    }
+    histogram_generation = generation;
+  }
+
+  void on_key(int key) override {
+    const int step_y = std::max(h / 4, 1), step_x = std::max(w / 4, 1);
+    switch(key) {
+      case GLFW_KEY_UP: view_y += step_y; break;
+      case GLFW_KEY_DOWN: view_y -= step_y; break;
+      case GLFW_KEY_RIGHT: view_x += step_x; break;
+      case GLFW_KEY_LEFT: view_x -= step_x; break;
+      case GLFW_KEY_HOME: view_y = view_x = 0; break;
+      case GLFW_KEY_F: follow = !follow; break;
+      default: return;
+    }
+    // panning by hand stops following
+    if(key != GLFW_KEY_F) {
+      follow = false;
+    }
+    reinit_texture();
+  }
+
+  // centres the viewport on the bounding box of the live tiles
+  void follow_tiles() {
+    if(grid.tiles.empty()) {
+      return;
+    }
+    int y0 = INT_MAX, y1 = INT_MIN, x0 = INT_MAX, x1 = INT_MIN;
+    for(const auto &[k, tile] : grid.tiles) {
+      const int ty = StorageT::key_y(k), tx = StorageT::key_x(k);
+      y0 = std::min(y0, ty), y1 = std::max(y1, ty);
+      x0 = std::min(x0, tx), x1 = std::max(x1, tx);
+    }
+    view_y = int((int64_t(y0) + y1 + 1) * tile_size / 2) - h / 2;
+    view_x = int((int64_t(x0) + x1 + 1) * tile_size / 2) - w / 2;
+  }
+
+  void rasterize() {
+    if(follow) {
+      follow_tiles();
+    }
+    #pragma omp parallel for
+    for(int y = 0; y < h; ++y) {
+      uint8_t *dst = &view.buffer[y * w];
+      const int gy = view_y + y;
+      for(int x0 = 0; x0 < w;) {
+        // the rest of the row within the tile under x0
+        const int gx = view_x + x0;
+        const int x1 = std::min(w, x0 + tile_size - (gx & StorageT::tile_mask));
+        const Tile *tile = grid.find(gy >> StorageT::tile_bits, gx >> StorageT::tile_bits);
+        if(tile == nullptr) {
+          std::fill(dst + x0, dst + x1, 0);
+        } else {
+          const uint8_t *src = &tile->cells[(gy & StorageT::tile_mask) * tile_size + (gx & StorageT::tile_mask)];
+          std::copy(src, src + (x1 - x0), dst + x0);
+        }
+        x0 = x1;
+      }
+    }
+  }
+
+  void reinit_texture() {
+    prof::ScopedTimer timer(prof::UPLOAD);
+    rasterize();
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); GLERROR
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED_INTEGER, GL_UNSIGNED_BYTE, view.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    if(downsampler.is_active()) {
+      downsampler.run(tex);
+    }
+  }
+
+  GLuint get_current_texture_id() override {
+    return downsampler.is_active() ? downsampler.get_texture() : tex;
+  }
+
+  // the viewport only
+  void read_frame(std::vector<uint8_t> &frame) override {
+    frame.assign(view.buffer.begin(), view.buffer.end());
+  }
+
+  void clear() override {
+    gl::Texture<GL_TEXTURE_2D>::clear(tex);
+    grid.clear();
+    results.clear();
+    view.clear();
+    parent_t::clear();
+  }
+};
+
+// states in [0, 1] as floats, stepped from the sums of convolver over the kernels
+// of the rule. the display samples a float texture, so that negative zoom is
+// filtered by mipmaps; frames, hashes and counts see the states quantized
+template <typename AUT, access_mode AccessMode>
+struct Renderer<AUT, storage_mode::CONTINUOUS, AccessMode> : public TexturedGridRenderer {
+  using parent_t = TexturedGridRenderer;
+  using StorageT = Storage<4, storage_mode::HOSTBUFFER, float>;
+  static constexpr int max_kernels = 4;
+
+  AUT &aut;
+  using parent_t::w;
+  using parent_t::h;
+
+  GLuint tex = 0;
+  int8_t current_buf = 0;
+  StorageT buf1, buf2;
+  // one per kernel
+  std::vector<StorageT> sums;
+  conv::Convolver convolver;
+  // the quantized states of the current generation
+  std::vector<uint8_t> levels;
+
+  static_assert(AUT::update_mode == ::update_mode::ALL, "continuous storage steps every cell");
+
+  storage_mode get_storage_mode() override {
+    return storage_mode::CONTINUOUS;
+  }
+
+  explicit Renderer(AUT &_aut, const std::string &dir):
+    parent_t(_aut.no_states, dir, "continuous.frag"s),
+    aut(_aut)
+  {}
+
+  void set_grid_size(int w_, int h_, int zoom) override {
+    if(zoom > 0) {
+      w_ /= zoom, h_ /= zoom;
+    } else if(zoom < 0) {
+      w_ *= -zoom, h_ *= -zoom;
+    }
+    w = w_, h = h_;
+    Logger::Info("[continuous %d %d]\n", w, h);
+  }
+
+  static uint8_t quantize(float state) {
+    return uint8_t(std::lround(state * (AUT::no_states - 1)));
+  }
+
+  void init_textures(const char *filename=nullptr) override {
+    if(filename != nullptr) {
+      Logger::Warning("patterns cannot be loaded into continuous states, starting from a soup\n");
+    }
+    buf1.init(w, h);
+    buf2.init(w, h);
+    const std::vector<continuous::Kernel> kernels = aut.kernels();
+    ASSERT(kernels.size() <= max_kernels);
+    sums.resize(kernels.size());
+    for(StorageT &sum : sums) {
+      sum.init(w, h);
+    }
+    convolver.init(w, h, AccessMode == access_mode::looped, kernels);
+    levels.resize(size_t(w) * h);
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < h; ++y) {
+      for(int x = 0; x < w; ++x) {
+        buf1.buffer[y * w + x] = aut.init_state(y, x);
+        levels[y * w + x] = quantize(buf1.buffer[y * w + x]);
+      }
+    }
+    current_buf = 0;
+    generation = 0;
+    if(detector.enabled()) {
+      grid_hash = period::hash_grid(levels.data(), w * h);
+      detector.push(generation, grid_hash);
+    }
+    if(track_histogram) {
+      count_states();
+    }
+    gl::Texture<GL_TEXTURE_2D>::init(tex);
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, w, h, 0, GL_RED, GL_FLOAT, nullptr); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    reinit_texture();
+  }
+
+  void update_state() override {
+    for(int i = 0; i < generations_per_update; ++i) {
+      update_buffers();
+    }
+    if(track_histogram) {
+      count_states();
+    }
+    reinit_texture();
+  }
+
+  void update_buffers() {
+    StorageT *srcbuf = &buf1, *dstbuf = &buf2;
+    if(current_buf) {
+      std::swap(srcbuf, dstbuf);
+    }
+    {
+      prof::ScopedTimer timer(prof::CONVOLVE);
+      std::vector<float *> outs;
+      for(StorageT &sum : sums) {
+        outs.push_back(sum.data());
+      }
+      convolver.run(srcbuf->data(), outs);
+    }
+    prof::ScopedTimer timer(prof::UPDATE);
+    const bool track_hash = detector.enabled();
+    const int no_kernels = int(sums.size());
+    uint64_t delta = 0;
+    #pragma omp parallel for schedule(static) reduction(^:delta)
+    for(int y = 0; y < h; ++y) {
+      float cell_sums[max_kernels];
+      for(int i = y * w; i < (y + 1) * w; ++i) {
+        for(int k = 0; k < no_kernels; ++k) {
+          cell_sums[k] = sums[k].buffer[i];
+        }
+        dstbuf->buffer[i] = aut.next(srcbuf->buffer[i], cell_sums);
+        const uint8_t level = quantize(dstbuf->buffer[i]);
+        if(track_hash && level != levels[i]) {
+          delta ^= period::key(i, levels[i]) ^ period::key(i, level);
+        }
+        levels[i] = level;
+      }
+    }
+    current_buf = current_buf ? 0 : 1;
+    ++generation;
+    if(track_hash) {
+      grid_hash ^= delta;
+      detector.push(generation, grid_hash);
+    }
+  }
+
+  // a bin per quantized level
+  void count_states() {
+    histogram.assign(AUT::no_states, 0);
+    #pragma omp parallel
+    {
+      std::vector<uint64_t> counts(AUT::no_states, 0);
+      #pragma omp for schedule(static) nowait
+      for(int i = 0; i < w * h; ++i) {
+        ++counts[levels[i]];
+      }
+      #pragma omp critical
+      for(int s = 0; s < AUT::no_states; ++s) {
+        histogram[s] += counts[s];
+      }
+    }
+    histogram_generation = generation;
+  }
+
+  void reinit_texture() {
+    prof::ScopedTimer timer(prof::UPLOAD);
+    const StorageT *srcbuf = !current_buf ? &buf1 : &buf2;
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4); GLERROR
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED, GL_FLOAT, srcbuf->data()); GLERROR
+    glGenerateMipmap(GL_TEXTURE_2D); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+  }
+
+  GLuint get_current_texture_id() override {
+    return tex;
+  }
+
+  void read_frame(std::vector<uint8_t> &frame) override {
+    frame.assign(levels.begin(), levels.end());
+  }
+
+  void clear() override {
+    gl::Texture<GL_TEXTURE_2D>::clear(tex);
+    buf1.clear();
+    buf2.clear();
+    sums.clear();
+    levels.clear();
+    parent_t::clear();
+  }
+};
+
+// three-dimensional outer-totalistic rules on a volume of size cells, looped or
+// bounded along all three axes. two states are packed 64 cells to a word (see
+// Volume.hpp) and stepped on the gpu by VolumeUpdater when compute shaders are
+// there; more states take a byte per cell on the host. the window shows the
+// plane at slice, or the nearest cell along z that is not dead, brighter when
+// nearer: V switches between the two, up and down move the slice
+template <typename AUT, access_mode AccessMode>
+struct Renderer<AUT, storage_mode::VOLUME, AccessMode> : public TexturedGridRenderer {
+  using parent_t = TexturedGridRenderer;
+  using PackedT = Storage<3, storage_mode::HOSTBUFFER, bool>;
+  using BytesT = Storage<3, storage_mode::HOSTBUFFER, uint8_t>;
+  using word_type = PackedT::word_type;
+  static constexpr int word_bits = PackedT::word_bits;
+
+  AUT &aut;
+  using parent_t::w;
+  using parent_t::h;
+
+  // set before init_renderer
+  glm::ivec3 size = glm::ivec3(256, 256, 256);
+  bool use_gpu = false;
+
+  int d = 0;
+  const bool packed;
+  bool on_gpu = false;
+  int8_t current_buf = 0;
+  PackedT packed1, packed2;
+  BytesT bytes1, bytes2;
+  // per thread, the sums over the 3x3 columns of a row with a word or cell either
+  // side: 4 planes of words, or counts; then the 5 planes of the box sums
+  std::vector<std::vector<word_type>> scratch_planes;
+  std::vector<std::vector<uint8_t>> scratch_counts;
+  // a row of dead cells, for the rows off a bounded volume
+  std::vector<word_type> zero_words;
+  std::vector<uint8_t> zero_cells;
+  uint64_t population = 0;
+  VolumeUpdater gpu;
+
+  enum view_mode : int {
+    PROJECTION, SLICE
+  };
+  int view = PROJECTION;
+  int slice = 0;
+  std::vector<uint8_t> view_cells;
+  GLuint tex = 0;
+  // throughput, logged every report_every generations
+  static constexpr size_t report_every = 256;
+  prof::clock::time_point report_time;
+  size_t report_generation = 0;
+
+  static_assert(AUT::update_mode == ::update_mode::ALL, "volumes step every cell");
+
+  storage_mode get_storage_mode() override {
+    return storage_mode::VOLUME;
+  }
+
+  explicit Renderer(AUT &_aut, const std::string &dir):
+    parent_t(_aut.no_states, dir),
+    aut(_aut),
+    packed(_aut.no_states == 2),
+    gpu(dir)
+  {}
+
+  // the window does not decide the size of a volume
+  void set_grid_size(int w_, int h_, int zoom) override {
+    w = size.x, h = size.y, d = size.z;
+    if(packed) {
+      w = (w + word_bits - 1) / word_bits * word_bits;
+    }
+    slice = d / 2;
+    on_gpu = packed && use_gpu;
+    Logger::Info("[volume %d %d %d, %s]\n", w, h, d, on_gpu ? "gpu" : (packed ? "host, packed" : "host"));
+  }
+
+  size_t get_no_cells() const override {
+    return size_t(w) * h * d;
+  }
+
+  static int wrap(int i, int n) {
+    if constexpr(AccessMode == access_mode::looped) {
+      return (i < 0) ? i + n : ((i >= n) ? i - n : i);
+    }
+    return (i < 0 || i >= n) ? -1 : i;
+  }
+
+  // must match shade() in volume.comp
+  uint8_t shade(int z) const {
+    return uint8_t(255 - (z * 254) / std::max(d - 1, 1));
+  }
+
+  // both 32-bit halves of a word, as volume.comp hashes them
+  static uint64_t word_key(size_t index, word_type word) {
+    return period::key(uint32_t(2 * index), uint32_t(word)) ^ period::key(uint32_t(2 * index + 1), uint32_t(word >> 32));
+  }
+
+  // the soup fills the middle half of each side, so that patterns have room to grow
+  bool in_soup(int z, int y, int x) const {
+    return z >= d / 4 && z < d - d / 4 && y >= h / 4 && y < h - h / 4 && x >= w / 4 && x < w - w / 4;
+  }
+
+  void init_textures(const char *filename=nullptr) override {
+    if(filename != nullptr) {
+      Logger::Warning("patterns cannot be loaded into volumes, starting from a soup\n");
+    }
+    const int no_threads = sys::get_max_threads();
+    grid_hash = 0, population = 0;
+    if(packed) {
+      packed1.init(w, h, d);
+      if(!on_gpu) {
+        packed2.init(w, h, d);
+        const int nw = packed1.nw;
+        scratch_planes.assign(no_threads, std::vector<word_type>(4 * (nw + 2) + 5 * nw));
+        zero_words.assign(nw, 0);
+      }
+      uint64_t hash = 0, live = 0;
+      #pragma omp parallel for schedule(static) reduction(^:hash) reduction(+:live)
+      for(int r = 0; r < d * h; ++r) {
+        const int z = r / h, y = r % h;
+        word_type *row = packed1.row(z, y);
+        for(int x = 0; x < w; ++x) {
+          if(in_soup(z, y, x) && aut.init_state(z, y, x) != aut.DEAD) {
+            row[x / word_bits] |= word_type(1) << (x % word_bits);
+          }
+        }
+        for(int i = 0; i < packed1.nw; ++i) {
+          hash ^= word_key(size_t(r) * packed1.nw + i, row[i]);
+          live += std::popcount(row[i]);
+        }
+      }
+      grid_hash = hash, population = live;
+    } else {
+      bytes1.init(w, h, d);
+      bytes2.init(w, h, d);
+      scratch_counts.assign(no_threads, std::vector<uint8_t>(w + 2));
+      zero_cells.assign(w, 0);
+      uint64_t hash = 0;
+      #pragma omp parallel for schedule(static) reduction(^:hash)
+      for(int r = 0; r < d * h; ++r) {
+        const int z = r / h, y = r % h;
+        uint8_t *row = bytes1.row(z, y);
+        for(int x = 0; x < w; ++x) {
+          row[x] = in_soup(z, y, x) ? aut.init_state(z, y, x) : aut.DEAD;
+          hash ^= period::key(uint32_t(size_t(r) * w + x), row[x]);
+        }
+      }
+      grid_hash = hash;
+    }
+    current_buf = 0;
+    generation = 0;
+    if(detector.enabled()) {
+      detector.push(generation, grid_hash);
+    }
+    if(track_histogram) {
+      count_states();
+    }
+    view_cells.assign(size_t(w) * h, 0);
+    gl::Texture<GL_TEXTURE_2D>::init(tex);
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    if(on_gpu) {
+      // the host copy is only needed to start from
+      gpu.init(glm::ivec3(w, h, d), packed1.data());
+      packed1.clear();
+      packed1.buffer.shrink_to_fit();
+    }
+    report_time = prof::clock::now();
+    report_generation = 0;
+    display();
+  }
+
+  void update_state() override {
+    for(int i = 0; i < generations_per_update; ++i) {
+      prof::ScopedTimer timer(prof::UPDATE);
+      if(on_gpu) {
+        update_gpu();
+      } else if(packed) {
+        update_packed();
+      } else {
+        update_bytes();
+      }
+      ++generation;
+      if(detector.enabled()) {
+        detector.push(generation, grid_hash);
+      }
+    }
+    if(track_histogram) {
+      count_states();
+    }
+    if(generation - report_generation >= report_every) {
+      report();
+    }
+    display();
+  }
+
+  // stepped cells per second of wall time, display included
+  void report() {
+    const prof::clock::time_point now = prof::clock::now();
+    const double seconds = std::chrono::duration<double>(now - report_time).count();
+    if(generation > report_generation && seconds > 0) {
+      const double mcells = double(get_no_cells()) * (generation - report_generation) / seconds * 1e-6;
+      Logger::Info("[volume] generations %lu..%lu: %.1f Mcell/s\n", report_generation, generation, mcells);
+    }
+    report_time = now;
+    report_generation = generation;
+  }
+
+  // the hash and the population come back from the gpu synchronously, and only
+  // when something needs them
+  void update_gpu() {
+    prof::ScopedGPUTimer gpu_timer(prof::GPU_UPDATE);
+    gpu.run(aut.spec, int(AccessMode));
+    if(detector.enabled() || track_histogram) {
+      const VolumeUpdater::Stats stats = gpu.read_stats();
+      grid_hash ^= (uint64_t(stats.hash_hi) << 32) | stats.hash_lo;
+      population = stats.population;
+    }
+  }
+
+  // a row of the box sums at a time: the column sums of every word, then their
+  // sums across, then the rule, one count at a time. each pass is a plain loop
+  // over the words of the row, so that it vectorizes
+  void update_packed() {
+    const PackedT &src = !current_buf ? packed1 : packed2;
+    PackedT &dst = !current_buf ? packed2 : packed1;
+    const int nw = src.nw, stride = nw + 2;
+    const uint32_t birth = aut.spec.birth, survival = aut.spec.survival << 1;
+    const bool track_hash = detector.enabled();
+    uint64_t delta = 0, live = 0;
+    #pragma omp parallel for schedule(static) reduction(^:delta) reduction(+:live)
+    for(int r = 0; r < d * h; ++r) {
+      const int z = r / h, y = r % h;
+      word_type *columns = scratch_planes[sys::get_thread_num()].data();
+      word_type *sums = columns + 4 * stride;
+      const word_type *rows[9];
+      for(int dz = -1; dz <= 1; ++dz) {
+        for(int dy = -1; dy <= 1; ++dy) {
+          const int zz = wrap(z + dz, d), yy = wrap(y + dy, h);
+          rows[(dz + 1) * 3 + dy + 1] = (zz < 0 || yy < 0) ? zero_words.data() : src.row(zz, yy);
+        }
+      }
+      #pragma omp simd
+      for(int i = 0; i < nw; ++i) {
+        word_type a[9], p[4];
+        for(int k = 0; k < 9; ++k) {
+          a[k] = rows[k][i];
+        }
+        volume::column_sum(a, p);
+        for(int b = 0; b < 4; ++b) {
+          columns[b * stride + 1 + i] = p[b];
+        }
+      }
+      constexpr bool looped = (AccessMode == access_mode::looped);
+      for(int b = 0; b < 4; ++b) {
+        word_type *plane = &columns[b * stride];
+        plane[0] = looped ? plane[nw] : 0;
+        plane[nw + 1] = looped ? plane[1] : 0;
+      }
+      #pragma omp simd
+      for(int i = 0; i < nw; ++i) {
+        word_type prev[4], cur[4], next[4], s[5];
+        for(int b = 0; b < 4; ++b) {
+          prev[b] = columns[b * stride + i];
+          cur[b] = columns[b * stride + i + 1];
+          next[b] = columns[b * stride + i + 2];
+        }
+        volume::box_sum(prev, cur, next, s);
+        for(int b = 0; b < 5; ++b) {
+          sums[b * nw + i] = s[b];
+        }
+      }
+      const word_type *self = src.row(z, y);
+      word_type *out = dst.row(z, y);
+      std::fill_n(out, nw, word_type(0));
+      // the cell is in its own sum, hence the shifted survival
+      for(uint32_t m = birth | survival; m != 0; m &= m - 1) {
+        const int count = std::countr_zero(m);
+        const word_type born = ((birth >> count) & 1) ? ~word_type(0) : 0, kept = ((survival >> count) & 1) ? ~word_type(0) : 0;
+        #pragma omp simd
+        for(int i = 0; i < nw; ++i) {
+          word_type eq = ~word_type(0);
+          for(int b = 0; b < 5; ++b) {
+            eq &= ((count >> b) & 1) ? sums[b * nw + i] : ~sums[b * nw + i];
+          }
+          out[i] |= eq & ((born & ~self[i]) | (kept & self[i]));
+        }
+      }
+      for(int i = 0; i < nw; ++i) {
+        live += std::popcount(out[i]);
+        if(track_hash && out[i] != self[i]) {
+          const size_t index = size_t(r) * nw + i;
+          delta ^= word_key(index, self[i]) ^ word_key(index, out[i]);
+        }
+      }
+    }
+    current_buf = current_buf ? 0 : 1;
+    grid_hash ^= delta;
+    population = live;
+  }
+
+  // the live cells of the 3x3 columns of a row, then their sums across
+  void update_bytes() {
+    const BytesT &src = !current_buf ? bytes1 : bytes2;
+    BytesT &dst = !current_buf ? bytes2 : bytes1;
+    const uint8_t live = aut.LIVE;
+    const bool track_hash = detector.enabled();
+    uint64_t delta = 0;
+    #pragma omp parallel for schedule(static) reduction(^:delta)
+    for(int r = 0; r < d * h; ++r) {
+      const int z = r / h, y = r % h;
+      uint8_t *columns = scratch_counts[sys::get_thread_num()].data();
+      const uint8_t *rows[9];
+      for(int dz = -1; dz <= 1; ++dz) {
+        for(int dy = -1; dy <= 1; ++dy) {
+          const int zz = wrap(z + dz, d), yy = wrap(y + dy, h);
+          rows[(dz + 1) * 3 + dy + 1] = (zz < 0 || yy < 0) ? zero_cells.data() : src.row(zz, yy);
+        }
+      }
+      #pragma omp simd
+      for(int x = 0; x < w; ++x) {
+        uint8_t count = 0;
+        for(int k = 0; k < 9; ++k) {
+          count += (rows[k][x] == live);
+        }
+        columns[x + 1] = count;
+      }
+      constexpr bool looped = (AccessMode == access_mode::looped);
+      columns[0] = looped ? columns[w] : 0;
+      columns[w + 1] = looped ? columns[1] : 0;
+      const uint8_t *self = src.row(z, y);
+      uint8_t *out = dst.row(z, y);
+      for(int x = 0; x < w; ++x) {
+        const int count = columns[x] + columns[x + 1] + columns[x + 2] - (self[x] == live);
+        out[x] = aut.transition(self[x], count);
+      }
+      if(track_hash) {
+        for(int x = 0; x < w; ++x) {
+          if(out[x] != self[x]) {
+            const uint32_t index = uint32_t(size_t(r) * w + x);
+            delta ^= period::key(index, self[x]) ^ period::key(index, out[x]);
+          }
+        }
+      }
+    }
+    current_buf = current_buf ? 0 : 1;
+    grid_hash ^= delta;
+  }
+
+  // two states are counted as they are stepped
+  void count_states() {
+    if(packed) {
+      histogram.assign({get_no_cells() - population, population});
+      histogram_generation = generation;
+      return;
+    }
+    const BytesT &src = !current_buf ? bytes1 : bytes2;
+    histogram.assign(aut.no_states, 0);
+    #pragma omp parallel
+    {
+      std::vector<uint64_t> counts(aut.no_states, 0);
+      #pragma omp for schedule(static) nowait
+      for(int r = 0; r < d * h; ++r) {
+        const uint8_t *row = src.buffer.data() + size_t(r) * w;
+        for(int x = 0; x < w; ++x) {
+          ++counts[row[x]];
+        }
+      }
+      #pragma omp critical
+      for(int s = 0; s < aut.no_states; ++s) {
+        histogram[s] += counts[s];
+      }
+    }
+    histogram_generation = generation;
+  }
+
+  void on_key(int key) override {
+    switch(key) {
+      case GLFW_KEY_V: view = (view == PROJECTION) ? SLICE : PROJECTION; break;
+      case GLFW_KEY_UP: slice = std::min(slice + 1, d - 1); break;
+      case GLFW_KEY_DOWN: slice = std::max(slice - 1, 0); break;
+      default: return;
+    }
+    if(key != GLFW_KEY_V) {
+      view = SLICE;
+    }
+    display();
+  }
+
+  void project_packed() {
+    const PackedT &src = !current_buf ? packed1 : packed2;
+    const int nw = src.nw;
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < h; ++y) {
+      uint8_t *cells = &view_cells[size_t(y) * w];
+      for(int i = 0; i < nw; ++i) {
+        if(view == SLICE) {
+          const word_type word = src.row(slice, y)[i];
+          for(int b = 0; b < word_bits; ++b) {
+            cells[i * word_bits + b] = (word >> b) & 1;
+          }
+          continue;
+        }
+        std::fill_n(&cells[i * word_bits], word_bits, uint8_t(0));
+        word_type left = ~word_type(0);
+        for(int z = 0; z < d && left != 0; ++z) {
+          word_type found = src.row(z, y)[i] & left;
+          left &= ~found;
+          for(; found != 0; found &= found - 1) {
+            cells[i * word_bits + std::countr_zero(found)] = shade(z);
+          }
+        }
+      }
+    }
+  }
+
+  void project_bytes() {
+    const BytesT &src = !current_buf ? bytes1 : bytes2;
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < h; ++y) {
+      uint8_t *cells = &view_cells[size_t(y) * w];
+      if(view == SLICE) {
+        std::copy_n(src.row(slice, y), w, cells);
+        continue;
+      }
+      std::fill_n(cells, w, uint8_t(0));
+      int left = w;
+      for(int z = 0; z < d && left > 0; ++z) {
+        const uint8_t *row = src.row(z, y);
+        for(int x = 0; x < w; ++x) {
+          if(cells[x] == 0 && row[x] != 0) {
+            cells[x] = shade(z);
+            --left;
+          }
+        }
+      }
+    }
+  }
+
+  void display() {
+    prof::ScopedTimer timer(prof::UPLOAD);
+    no_states = (view == SLICE) ? aut.no_states : 256;
+    if(on_gpu) {
+      gpu.draw(tex, view, slice);
+      return;
+    }
+    if(packed) {
+      project_packed();
+    } else {
+      project_bytes();
+    }
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); GLERROR
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED_INTEGER, GL_UNSIGNED_BYTE, view_cells.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+  }
+
+  GLuint get_current_texture_id() override {
+    return tex;
+  }
+
+  // what the window shows
+  void read_frame(std::vector<uint8_t> &frame) override {
+    if(!on_gpu) {
+      frame.assign(view_cells.begin(), view_cells.end());
+      return;
+    }
+    frame.resize(size_t(w) * h);
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); GLERROR
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, frame.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+  }
+
+  void clear() override {
+    if(generation > report_generation) {
+      report();
+    }
+    gl::Texture<GL_TEXTURE_2D>::clear(tex);
+    gpu.clear();
+    packed1.clear();
+    packed2.clear();
+    bytes1.clear();
+    bytes2.clear();
+    scratch_planes.clear();
+    scratch_counts.clear();
+    view_cells.clear();
+    parent_t::clear();
+  }
+};
+
+// margolus block rules (see Margolus.hpp) on a looped or bounded grid of even
+// size. blocks are disjoint, so every engine replaces them in place: two states
+// are bit-sliced 64 cells to a word on the host, more take a byte per cell and
+// index the table of the phase directly, and BlockUpdater steps any rule on the
+// gpu when compute shaders are there. on a bounded grid, the cells along the
+// edges that the offset partition leaves out of whole blocks keep their states
+template <typename AUT, access_mode AccessMode>
+struct Renderer<AUT, storage_mode::BLOCKS, AccessMode> : public TexturedGridRenderer {
+  using parent_t = TexturedGridRenderer;
+  using StorageT = RenderStorage<storage_mode::HOSTBUFFER>;
+  using PackedT = Storage<4, storage_mode::HOSTBUFFER, bool>;
+  using word_type = PackedT::word_type;
+  static constexpr int word_bits = PackedT::word_bits;
+
+  AUT &aut;
+  using parent_t::w;
+  using parent_t::h;
+
+  // set before init_renderer
+  bool use_gpu = false;
+
+  // display size for negative zoom
+  int tw = 0, th = 0;
+  bool on_gpu = false;
+  bool packed = false;
+  // the cells, or what the window shows of the packed ones
+  StorageT cells;
+  PackedT bits;
+  // per thread, a pair of rows shifted by a cell for the offset partition
+  std::vector<std::vector<word_type>> scratch;
+  BlockUpdater gpu;
+  GLuint tex = 0;
+
+  static_assert(AUT::update_mode == ::update_mode::ALL, "blocks replace every cell");
+
+  storage_mode get_storage_mode() override {
+    return storage_mode::BLOCKS;
+  }
+
+  explicit Renderer(AUT &_aut, const std::string &dir):
+    parent_t(_aut.no_states, dir),
+    aut(_aut),
+    gpu(dir)
+  {}
+
+  void set_grid_size(int w_, int h_, int zoom) override {
+    if(zoom < 0 && !gpu_downsample) {
+      Logger::Warning("negative zoom needs compute shaders, using zoom 1\n");
+      zoom = 1;
+    }
+    if(zoom == 0) {
+      zoom = 1;
+    }
+    on_gpu = use_gpu;
+    packed = !on_gpu && aut.no_states == 2;
+    tw = (zoom > 0) ? w_ / zoom : w_, th = (zoom > 0) ? h_ / zoom : h_;
+    // the width of a packed grid is whole words, and blocks need even sizes
+    const int align = (packed && tw >= word_bits) ? word_bits : 2;
+    tw = std::max(tw / align * align, 2), th = std::max(th / 2 * 2, 2);
+    packed = packed && align == word_bits;
+    w = tw * std::max(-zoom, 1), h = th * std::max(-zoom, 1);
+    if(zoom < 0) {
+      parent_t::colorscheme = 1;
+      no_states = std::min<int>(256, zoom * zoom * (aut.no_states - 1) + 1);
+    }
+    Logger::Info("[blocks %d %d, %s] [%d %d]\n", w, h, on_gpu ? "gpu" : (packed ? "host, packed" : "host"), tw, th);
+  }
+
+  // the packed engine hashes whole words, both 32-bit halves as the volumes do
+  static uint64_t word_key(size_t index, word_type word) {
+    return period::key(uint32_t(2 * index), uint32_t(word)) ^ period::key(uint32_t(2 * index + 1), uint32_t(word >> 32));
+  }
+
+  void pack() {
+    const int nw = bits.nw;
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < h; ++y) {
+      const uint8_t *src = &cells.buffer[size_t(y) * w];
+      word_type *dst = bits.row(y);
+      for(int i = 0; i < nw; ++i) {
+        word_type word = 0;
+        for(int b = 0; b < word_bits; ++b) {
+          word |= word_type(src[i * word_bits + b] != 0) << b;
+        }
+        dst[i] = word;
+      }
+    }
+  }
+
+  void unpack() {
+    const int nw = bits.nw;
+    #pragma omp parallel for schedule(static)
+    for(int y = 0; y < h; ++y) {
+      const word_type *src = bits.row(y);
+      uint8_t *dst = &cells.buffer[size_t(y) * w];
+      for(int i = 0; i < nw; ++i) {
+        for(int b = 0; b < word_bits; ++b) {
+          dst[i * word_bits + b] = (src[i] >> b) & 1;
+        }
+      }
+    }
+  }
+
+  // after the cells have been replaced from the host
+  void restart(size_t generation_) {
+    if(!packed) {
+      restart_detector(generation_, cells.data());
+    } else {
+      pack();
+      generation = generation_;
+      if(detector.enabled()) {
+        uint64_t hash = 0;
+        #pragma omp parallel for schedule(static) reduction(^:hash)
+        for(size_t i = 0; i < bits.buffer.size(); ++i) {
+          hash ^= word_key(i, bits.buffer[i]);
+        }
+        grid_hash = hash;
+        detector.reset(detector.max_period);
+        detector.push(generation, grid_hash);
+      }
+    }
+    if(track_histogram) {
+      // the gpu only reports the changes
+      count_cells();
+    }
+  }
+
+  void init_textures(const char *filename=nullptr) override {
+    cells.init(w, h);
+    if(packed) {
+      bits.init(w, h);
+      scratch.assign(sys::get_max_threads(), std::vector<word_type>(2 * bits.nw));
+    }
+    if(filename == nullptr) {
+      #pragma omp parallel for schedule(static)
+      for(int y = 0; y < h; ++y) {
+        for(int x = 0; x < w; ++x) {
+          cells.buffer[size_t(y) * w + x] = aut.init_state(y, x);
+        }
+      }
+    } else {
+      RLEDecoder<StorageT>::read(filename, cells);
+    }
+    Logger::Info("[blocks %s] %s\n", aut.get_block().str().c_str(), aut.get_block().is_reversible() ? "reversible" : "irreversible");
+    ASSERT(margolus::grain_falls());
+    restart(0);
+    gl::Texture<GL_TEXTURE_2D>::init(tex);
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); GLERROR
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, w, h, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    if(w != tw || h != th) {
+      const float scale_states = fmax(1, float((w / tw) * (h / th) * (aut.no_states - 1) + 1) / no_states);
+      downsampler.init(tw, th, glm::ivec2(w / tw, h / th), scale_states);
+    }
+    if(on_gpu) {
+      gpu.init(w, h, aut.get_block());
+      // the host copy is only needed to start from
+      cells.clear();
+      cells.buffer.shrink_to_fit();
+    }
+    display();
+  }
+
+  void update_state() override {
+    for(int i = 0; i < generations_per_update; ++i) {
+      prof::ScopedTimer timer(prof::UPDATE);
+      if(on_gpu) {
+        update_gpu();
+      } else if(packed) {
+        update_packed();
+      } else {
+        update_bytes();
+      }
+      ++generation;
+      if(detector.enabled()) {
+        detector.push(generation, grid_hash);
+      }
+    }
+    if(track_histogram) {
+      count_states();
+    }
+    display();
+  }
+
+  // the hash and the counts come back from the gpu synchronously, and only when
+  // something needs them
+  void update_gpu() {
+    prof::ScopedGPUTimer gpu_timer(prof::GPU_UPDATE);
+    gpu.run(tex, generation, int(AccessMode));
+    if(detector.enabled() || track_histogram) {
+      const BlockUpdater::Stats stats = gpu.read_stats();
+      grid_hash ^= (uint64_t(stats.hash_hi) << 32) | stats.hash_lo;
+      for(int s = 0; s < int(histogram.size()); ++s) {
+        histogram[s] += uint64_t(int64_t(int32_t(stats.counts[s])));
+      }
+    }
+  }
+
+  // a pair of rows at a time: their words hold 32 whole blocks each on even
+  // generations. on odd ones, the rows are shifted down a cell first, so that
+  // they do again, and shifted back after
+  void update_packed() {
+    const margolus::Sliced sliced(aut.table(generation));
+    const int phase = generation & 1, nw = bits.nw;
+    constexpr bool bounded = (AccessMode == access_mode::bounded);
+    // on a bounded grid, the wrapped block at the end of a shifted row stays
+    constexpr word_type last_block = word_type(3) << (word_bits - 2);
+    const bool track_hash = detector.enabled();
+    uint64_t delta = 0;
+    #pragma omp parallel for schedule(static) reduction(^:delta)
+    for(int j = 0; j < h / 2; ++j) {
+      const int y0 = 2 * j + phase, y1 = (y0 + 1) % h;
+      if(bounded && y0 + 1 >= h) {
+        continue;
+      }
+      // the top of the block is drawn above its origin, see margolus::block_row
+      const int yt = margolus::block_row(0) ? y1 : y0, yb = margolus::block_row(2) ? y1 : y0;
+      word_type *top = bits.row(yt), *bottom = bits.row(yb);
+      if(!phase) {
+        for(int i = 0; i < nw; ++i) {
+          word_type t = top[i], b = bottom[i];
+          sliced.apply(t, b);
+          if(track_hash) {
+            delta ^= word_key(size_t(yt) * nw + i, top[i]) ^ word_key(size_t(yt) * nw + i, t);
+            delta ^= word_key(size_t(yb) * nw + i, bottom[i]) ^ word_key(size_t(yb) * nw + i, b);
+          }
+          top[i] = t, bottom[i] = b;
+        }
+        continue;
+      }
+      word_type *st = scratch[sys::get_thread_num()].data(), *sb = st + nw;
+      for(int i = 0; i < nw; ++i) {
+        const int next = (i + 1 == nw) ? 0 : i + 1;
+        st[i] = (top[i] >> 1) | (top[next] << (word_bits - 1));
+        sb[i] = (bottom[i] >> 1) | (bottom[next] << (word_bits - 1));
+      }
+      const word_type kept_top = st[nw - 1] & last_block, kept_bottom = sb[nw - 1] & last_block;
+      for(int i = 0; i < nw; ++i) {
+        sliced.apply(st[i], sb[i]);
+      }
+      if(bounded) {
+        st[nw - 1] = (st[nw - 1] & ~last_block) | kept_top;
+        sb[nw - 1] = (sb[nw - 1] & ~last_block) | kept_bottom;
+      }
+      for(int i = 0; i < nw; ++i) {
+        const int prev = (i == 0) ? nw - 1 : i - 1;
+        const word_type t = (st[i] << 1) | (st[prev] >> (word_bits - 1));
+        const word_type b = (sb[i] << 1) | (sb[prev] >> (word_bits - 1));
+        if(track_hash) {
+          delta ^= word_key(size_t(yt) * nw + i, top[i]) ^ word_key(size_t(yt) * nw + i, t);
+          delta ^= word_key(size_t(yb) * nw + i, bottom[i]) ^ word_key(size_t(yb) * nw + i, b);
+        }
+        top[i] = t, bottom[i] = b;
+      }
+    }
+    grid_hash ^= delta;
+  }
+
+  void update_bytes() {
+    const std::vector<uint8_t> &table = aut.table(generation);
+    const int phase = generation & 1, bits_per_cell = aut.bits_per_cell(), mask = (1 << bits_per_cell) - 1;
+    constexpr bool bounded = (AccessMode == access_mode::bounded);
+    const bool track_hash = detector.enabled();
+    uint64_t delta = 0;
+    #pragma omp parallel for schedule(static) reduction(^:delta)
+    for(int j = 0; j < h / 2; ++j) {
+      const int y0 = 2 * j + phase, y1 = (y0 + 1) % h;
+      if(bounded && y0 + 1 >= h) {
+        continue;
+      }
+      for(int i = 0; i < w / 2; ++i) {
+        const int x0 = 2 * i + phase, x1 = (x0 + 1) % w;
+        if(bounded && x0 + 1 >= w) {
+          continue;
+        }
+        // top left, top right, bottom left, bottom right, as drawn (see margolus::block_row)
+        size_t block[4];
+        for(int k = 0; k < 4; ++k) {
+          block[k] = size_t(margolus::block_row(k) ? y1 : y0) * w + ((k & 1) ? x1 : x0);
+        }
+        int index = 0;
+        for(int k = 0; k < 4; ++k) {
+          index |= cells.buffer[block[k]] << (bits_per_cell * k);
+        }
+        const int next = table[index];
+        if(next == index) {
+          continue;
+        }
+        for(int k = 0; k < 4; ++k) {
+          const uint8_t state = cells.buffer[block[k]], updated = (next >> (bits_per_cell * k)) & mask;
+          if(track_hash && state != updated) {
+            delta ^= period::key(uint32_t(block[k]), state) ^ period::key(uint32_t(block[k]), updated);
+          }
+          cells.buffer[block[k]] = updated;
+        }
+      }
+    }
+    grid_hash ^= delta;
+  }
+
+  // from the host cells: at the start, and whenever they are replaced
+  void count_cells() {
+    histogram.assign(aut.no_states, 0);
+    if(packed) {
+      uint64_t live = 0;
+      #pragma omp parallel for schedule(static) reduction(+:live)
+      for(size_t i = 0; i < bits.buffer.size(); ++i) {
+        live += std::popcount(bits.buffer[i]);
+      }
+      histogram.assign({get_no_cells() - live, live});
+      histogram_generation = generation;
+      return;
+    }
+    #pragma omp parallel
+    {
+      std::vector<uint64_t> counts(aut.no_states, 0);
+      #pragma omp for schedule(static) nowait
+      for(int y = 0; y < h; ++y) {
+        const uint8_t *row = &cells.buffer[size_t(y) * w];
+        for(int x = 0; x < w; ++x) {
+          ++counts[row[x]];
+        }
+      }
+      #pragma omp critical
+      for(int s = 0; s < aut.no_states; ++s) {
+        histogram[s] += counts[s];
+      }
+    }
+    histogram_generation = generation;
+  }
+
+  // the gpu has kept the counts up to date as it went
+  void count_states() {
+    if(on_gpu) {
+      histogram_generation = generation;
+      return;
+    }
+    count_cells();
+  }
+
+  void display() {
+    prof::ScopedTimer timer(prof::UPLOAD);
+    if(!on_gpu) {
+      if(packed) {
+        unpack();
+      }
+      gl::Texture<GL_TEXTURE_2D>::bind(tex);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1); GLERROR
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED_INTEGER, GL_UNSIGNED_BYTE, cells.data()); GLERROR
+      gl::Texture<GL_TEXTURE_2D>::unbind();
+    }
+    if(downsampler.is_active()) {
+      downsampler.run(tex);
+    }
+  }
+
+  GLuint get_current_texture_id() override {
+    return downsampler.is_active() ? downsampler.get_texture() : tex;
+  }
+
+  void read_frame(std::vector<uint8_t> &frame) override {
+    if(!on_gpu) {
+      frame.assign(cells.buffer.begin(), cells.buffer.end());
+      return;
+    }
+    frame.resize(size_t(w) * h);
+    gl::Texture<GL_TEXTURE_2D>::bind(tex);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1); GLERROR
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, frame.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+  }
+
+  // the phase follows the generation, so a frame steps on from where it was
+  bool write_frame(const std::vector<uint8_t> &frame, size_t generation_) override {
+    if(frame.size() != size_t(w) * h) {
+      return false;
+    }
+    if(on_gpu) {
+      gl::Texture<GL_TEXTURE_2D>::bind(tex);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1); GLERROR
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED_INTEGER, GL_UNSIGNED_BYTE, frame.data()); GLERROR
+      gl::Texture<GL_TEXTURE_2D>::unbind();
+      restart_detector(generation_, frame.data());
+      if(track_histogram) {
+        // counted from the frame, as the host has no cells
+        histogram.assign(aut.no_states, 0);
+        for(uint8_t c : frame) {
+          ++histogram[c];
+        }
+        histogram_generation = generation;
+      }
+    } else {
+      std::copy(frame.begin(), frame.end(), cells.buffer.begin());
+      restart(generation_);
+    }
+    display();
+    return true;
+  }
+
+  void clear() override {
+    gl::Texture<GL_TEXTURE_2D>::clear(tex);
+    gpu.clear();
+    cells.clear();
+    bits.clear();
+    scratch.clear();
     parent_t::clear();
   }
 };
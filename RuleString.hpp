@@ -0,0 +1,530 @@
+#pragma once
+
+#include <bit>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+
+namespace ca {
+
+// outer-totalistic rule with generations-style decay:
+// bit i of birth/survival is set when i live neighbours cause birth/survival
+struct RuleSpec {
+  uint16_t birth = 0, survival = 0;
+  int no_states = 2;
+  // the neighbours within the 3x3 box, bit 3 (dy + 1) + (dx + 1) for the cell at (dy, dx)
+  uint16_t stencil = moore;
+
+  static constexpr int max_states = 256;
+  static constexpr uint16_t moore = 0b111101111;
+  static constexpr uint16_t von_neumann = 0b010101010;
+  // golly's hexagonal grid on a square one: the rows are sheared, so that the
+  // neighbours are the moore ones but north-east and south-west
+  static constexpr uint16_t hexagonal = 0b110101011;
+
+  int max_count() const {
+    return std::popcount(stencil);
+  }
+
+  // canonical B/S notation, e.g. "B3/S23", "B2/S/C3" or, on a hexagonal grid, "B2/S34H".
+  // other stencils than these three have no notation
+  std::string str() const {
+    std::string s = "B";
+    for(int i = 0; i <= 8; ++i) {
+      if(birth & (1 << i))s += char('0' + i);
+    }
+    s += "/S";
+    for(int i = 0; i <= 8; ++i) {
+      if(survival & (1 << i))s += char('0' + i);
+    }
+    if(no_states != 2) {
+      s += "/C" + std::to_string(no_states);
+    }
+    if(stencil == hexagonal) {
+      s += "H";
+    } else if(stencil == von_neumann) {
+      s += "V";
+    }
+    return s;
+  }
+
+  bool operator==(const RuleSpec &other) const {
+    return birth == other.birth && survival == other.survival && no_states == other.no_states
+      && stencil == other.stencil;
+  }
+};
+
+// accepts B/S notation in either order with an optional /Cn or /Gn suffix
+// (B3/S23, S23/B3, B2/S/C3) and Golly's survival/birth/states notation (23/3, 23/3/3),
+// either ending in H for the hexagonal or V for the von neumann neighbourhood.
+// on failure, returns false and describes the problem in error
+inline bool parse_rulestring(const std::string &rulestring, RuleSpec &rule, std::string &error) {
+  RuleSpec r;
+  std::string body = rulestring;
+  while(!body.empty() && isspace((unsigned char)body.back())) {
+    body.pop_back();
+  }
+  if(!body.empty() && toupper((unsigned char)body.back()) == 'H') {
+    r.stencil = RuleSpec::hexagonal;
+    body.pop_back();
+  } else if(!body.empty() && toupper((unsigned char)body.back()) == 'V') {
+    r.stencil = RuleSpec::von_neumann;
+    body.pop_back();
+  }
+  std::vector<std::string> parts(1);
+  for(char c : body) {
+    if(isspace((unsigned char)c)) {
+      continue;
+    } else if(c == '/') {
+      parts.emplace_back();
+    } else {
+      parts.back() += char(toupper((unsigned char)c));
+    }
+  }
+
+  auto &&parse_neighbours = [&](const std::string &digits, uint16_t &mask) mutable -> bool {
+    mask = 0;
+    for(char c : digits) {
+      if(c < '0' || c > '8') {
+        error = std::string("neighbour count '") + c + "' is not within 0..8";
+        return false;
+      }
+      mask |= uint16_t(1 << (c - '0'));
+    }
+    return true;
+  };
+  auto &&parse_states = [&](const std::string &digits, int &no_states) mutable -> bool {
+    if(digits.empty() || digits.length() > 3 || digits.find_first_not_of("0123456789") != std::string::npos) {
+      error = "invalid number of states '" + digits + "'";
+      return false;
+    }
+    no_states = std::stoi(digits);
+    if(no_states < 2 || no_states > RuleSpec::max_states) {
+      error = "number of states " + digits + " is not within 2.." + std::to_string(RuleSpec::max_states);
+      return false;
+    }
+    return true;
+  };
+
+  const bool lettered = body.find_first_of("BbSs") != std::string::npos;
+  if(lettered) {
+    bool has_birth = false, has_survival = false, has_states = false;
+    for(const std::string &part : parts) {
+      const char tag = part.empty() ? '\0' : part[0];
+      if(tag == 'B' && !has_birth) {
+        has_birth = parse_neighbours(part.substr(1), r.birth);
+        if(!has_birth)return false;
+      } else if(tag == 'S' && !has_survival) {
+        has_survival = parse_neighbours(part.substr(1), r.survival);
+        if(!has_survival)return false;
+      } else if((tag == 'C' || tag == 'G') && !has_states) {
+        has_states = parse_states(part.substr(1), r.no_states);
+        if(!has_states)return false;
+      } else if(isdigit((unsigned char)tag) && has_birth && has_survival && !has_states) {
+        has_states = parse_states(part, r.no_states);
+        if(!has_states)return false;
+      } else {
+        error = "unexpected '" + part + "' in '" + rulestring + "'";
+        return false;
+      }
+    }
+    if(!has_birth || !has_survival) {
+      error = "'" + rulestring + "' needs both B and S parts";
+      return false;
+    }
+  } else {
+    if(parts.size() != 2 && parts.size() != 3) {
+      error = "'" + rulestring + "' is neither B/S nor S/B/C notation";
+      return false;
+    }
+    if(!parse_neighbours(parts[0], r.survival) || !parse_neighbours(parts[1], r.birth)) {
+      return false;
+    }
+    if(parts.size() == 3 && !parse_states(parts[2], r.no_states)) {
+      return false;
+    }
+  }
+  const int max_count = r.max_count();
+  if(((r.birth | r.survival) >> (max_count + 1)) != 0) {
+    error = "neighbour counts of '" + rulestring + "' are not within 0.." + std::to_string(max_count);
+    return false;
+  }
+  rule = r;
+  return true;
+}
+
+// larger than life: outer-totalistic over the (2 range + 1)^2 box around a cell,
+// with birth and survival given as ranges of live counts. middle counts the cell
+// itself; more than 2 states decay like generations rules
+struct LtlSpec {
+  int range = 1;
+  int no_states = 2;
+  bool middle = false;
+  int bmin = 3, bmax = 3, smin = 2, smax = 3;
+
+  static constexpr int max_range = 500;
+
+  // golly notation, e.g. "R5,C0,M1,S34..58,B34..45,NM"
+  std::string str() const {
+    return "R" + std::to_string(range) + ",C" + std::to_string(no_states == 2 ? 0 : no_states)
+      + ",M" + std::to_string(int(middle))
+      + ",S" + std::to_string(smin) + ".." + std::to_string(smax)
+      + ",B" + std::to_string(bmin) + ".." + std::to_string(bmax) + ",NM";
+  }
+
+  bool operator==(const LtlSpec &other) const {
+    return range == other.range && no_states == other.no_states && middle == other.middle
+      && bmin == other.bmin && bmax == other.bmax && smin == other.smin && smax == other.smax;
+  }
+};
+
+// golly's larger than life notation: Rr,Cc,Mm,Smin..max,Bmin..max,NM in this order,
+// where C0 and C2 mean two states and a single count n stands for n..n.
+// on failure, returns false and describes the problem in error
+inline bool parse_ltl_rulestring(const std::string &rulestring, LtlSpec &rule, std::string &error) {
+  std::vector<std::string> parts(1);
+  for(char c : rulestring) {
+    if(isspace((unsigned char)c)) {
+      continue;
+    } else if(c == ',') {
+      parts.emplace_back();
+    } else {
+      parts.back() += char(toupper((unsigned char)c));
+    }
+  }
+  if(parts.size() != 6) {
+    error = "'" + rulestring + "' is not of the form Rr,Cc,Mm,Sa..b,Bc..d,NM";
+    return false;
+  }
+
+  auto &&parse_int = [&](const std::string &digits, int &value) mutable -> bool {
+    if(digits.empty() || digits.length() > 6 || digits.find_first_not_of("0123456789") != std::string::npos) {
+      error = "invalid number '" + digits + "' in '" + rulestring + "'";
+      return false;
+    }
+    value = std::stoi(digits);
+    return true;
+  };
+  auto &&parse_counts = [&](const std::string &part, int &lo, int &hi) mutable -> bool {
+    const size_t dots = part.find("..");
+    if(dots == std::string::npos) {
+      return parse_int(part, lo) && parse_int(part, hi);
+    }
+    return parse_int(part.substr(0, dots), lo) && parse_int(part.substr(dots + 2), hi);
+  };
+
+  LtlSpec r;
+  int middle = 0;
+  for(int i = 0; i < 5; ++i) {
+    const char tag = parts[i].empty() ? '\0' : parts[i][0];
+    if(tag != "RCMSB"[i]) {
+      error = std::string("expected '") + "RCMSB"[i] + "' in '" + parts[i] + "'";
+      return false;
+    }
+  }
+  if(!parse_int(parts[0].substr(1), r.range) || !parse_int(parts[1].substr(1), r.no_states)
+     || !parse_int(parts[2].substr(1), middle)
+     || !parse_counts(parts[3].substr(1), r.smin, r.smax) || !parse_counts(parts[4].substr(1), r.bmin, r.bmax))
+  {
+    return false;
+  }
+  if(parts[5] != "NM") {
+    error = "neighbourhood '" + parts[5] + "' is not supported, only NM (moore)";
+    return false;
+  }
+  if(r.range < 1 || r.range > LtlSpec::max_range) {
+    error = "range " + std::to_string(r.range) + " is not within 1.." + std::to_string(LtlSpec::max_range);
+    return false;
+  }
+  if(r.no_states == 0) {
+    r.no_states = 2;
+  }
+  if(r.no_states < 2 || r.no_states > RuleSpec::max_states) {
+    error = "number of states " + std::to_string(r.no_states) + " is not within 2.." + std::to_string(RuleSpec::max_states);
+    return false;
+  }
+  if(middle != 0 && middle != 1) {
+    error = "M must be 0 or 1";
+    return false;
+  }
+  r.middle = middle;
+  rule = r;
+  return true;
+}
+
+// three-dimensional outer-totalistic rule over the 26 neighbours of a cell in
+// its 3x3x3 box: bit i of birth/survival is set when i live neighbours cause
+// birth/survival. more than 2 states decay like generations rules
+struct VolumeSpec {
+  uint32_t birth = 0, survival = 0;
+  int no_states = 2;
+
+  static constexpr int max_count = 26;
+
+  // softology's survival/birth/states/neighbourhood notation, e.g. "4-5/5/2/M"
+  std::string str() const {
+    auto &&counts = [](uint32_t mask) -> std::string {
+      std::string s;
+      for(int lo = 0; lo <= max_count; ++lo) {
+        if(!((mask >> lo) & 1)) {
+          continue;
+        }
+        int hi = lo;
+        while(hi < max_count && ((mask >> (hi + 1)) & 1)) {
+          ++hi;
+        }
+        s += (s.empty() ? "" : ",") + std::to_string(lo) + ((hi > lo) ? "-" + std::to_string(hi) : "");
+        lo = hi;
+      }
+      return s;
+    };
+    return counts(survival) + "/" + counts(birth) + "/" + std::to_string(no_states) + "/M";
+  }
+
+  bool operator==(const VolumeSpec &other) const {
+    return birth == other.birth && survival == other.survival && no_states == other.no_states;
+  }
+};
+
+// softology's S/B/C/M notation, counts separated by commas with a-b for ranges
+// (4-5/5/2/M, 13-26/13-14,17-19/2/M), and carter bays' four digits
+// E_l E_u F_l F_u (4555: survival on 4..5, birth on 5..5, 2 states).
+// M is the moore neighbourhood; N (von neumann) is not supported.
+// on failure, returns false and describes the problem in error
+inline bool parse_volume_rulestring(const std::string &rulestring, VolumeSpec &rule, std::string &error) {
+  std::vector<std::string> parts(1);
+  for(char c : rulestring) {
+    if(isspace((unsigned char)c)) {
+      continue;
+    } else if(c == '/') {
+      parts.emplace_back();
+    } else {
+      parts.back() += char(toupper((unsigned char)c));
+    }
+  }
+
+  VolumeSpec r;
+  if(parts.size() == 1 && parts[0].length() == 4 && parts[0].find_first_not_of("0123456789") == std::string::npos) {
+    const int el = parts[0][0] - '0', eu = parts[0][1] - '0', fl = parts[0][2] - '0', fu = parts[0][3] - '0';
+    if(el > eu || fl > fu) {
+      error = "'" + rulestring + "' is not of the form E_l E_u F_l F_u with E_l <= E_u and F_l <= F_u";
+      return false;
+    }
+    for(int i = el; i <= eu; ++i) {
+      r.survival |= uint32_t(1) << i;
+    }
+    for(int i = fl; i <= fu; ++i) {
+      r.birth |= uint32_t(1) << i;
+    }
+    rule = r;
+    return true;
+  }
+  if(parts.size() != 4) {
+    error = "'" + rulestring + "' is not of the form S/B/C/M";
+    return false;
+  }
+
+  auto &&parse_int = [&](const std::string &digits, int &value) mutable -> bool {
+    if(digits.empty() || digits.length() > 3 || digits.find_first_not_of("0123456789") != std::string::npos) {
+      error = "invalid number '" + digits + "' in '" + rulestring + "'";
+      return false;
+    }
+    value = std::stoi(digits);
+    return true;
+  };
+  auto &&parse_counts = [&](const std::string &part, uint32_t &mask) mutable -> bool {
+    mask = 0;
+    if(part.empty()) {
+      return true;
+    }
+    size_t start = 0;
+    while(start <= part.length()) {
+      const size_t comma = std::min(part.find(',', start), part.length());
+      const std::string item = part.substr(start, comma - start);
+      const size_t dash = item.find('-');
+      int lo = 0, hi = 0;
+      if(dash == std::string::npos) {
+        if(!parse_int(item, lo))return false;
+        hi = lo;
+      } else if(!parse_int(item.substr(0, dash), lo) || !parse_int(item.substr(dash + 1), hi)) {
+        return false;
+      }
+      if(lo > hi || hi > VolumeSpec::max_count) {
+        error = "neighbour counts '" + item + "' are not within 0.." + std::to_string(VolumeSpec::max_count);
+        return false;
+      }
+      for(int i = lo; i <= hi; ++i) {
+        mask |= uint32_t(1) << i;
+      }
+      start = comma + 1;
+    }
+    return true;
+  };
+
+  if(!parse_counts(parts[0], r.survival) || !parse_counts(parts[1], r.birth) || !parse_int(parts[2], r.no_states)) {
+    return false;
+  }
+  if(r.no_states < 2 || r.no_states > RuleSpec::max_states) {
+    error = "number of states " + std::to_string(r.no_states) + " is not within 2.." + std::to_string(RuleSpec::max_states);
+    return false;
+  }
+  if(parts[3] != "M") {
+    error = "neighbourhood '" + parts[3] + "' is not supported, only M (moore)";
+    return false;
+  }
+  rule = r;
+  return true;
+}
+
+// margolus block rule: the grid is cut into 2x2 blocks, offset by one cell along
+// both axes on odd generations, and every block is replaced through a table
+// indexed by its cells, top left, top right, bottom left, bottom right as drawn
+// (see margolus::block_row), at bits_per_cell bits each from the lowest. odd
+// generations may use a table of their own
+struct BlockSpec {
+  int no_states = 2;
+  std::vector<uint8_t> even, odd;
+
+  static constexpr int max_states = 4;
+
+  static int bits_per_cell(int no_states) {
+    return (no_states <= 2) ? 1 : 2;
+  }
+
+  size_t table_size() const {
+    return size_t(1) << (4 * bits_per_cell(no_states));
+  }
+
+  // whether every cell of the block is a state, with 3 states not all are
+  bool is_block(int index) const {
+    const int bits = bits_per_cell(no_states);
+    for(int i = 0; i < 4; ++i) {
+      if(((index >> (bits * i)) & ((1 << bits) - 1)) >= no_states) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // both tables permute the blocks, so every generation can be undone
+  bool is_reversible() const {
+    for(const std::vector<uint8_t> *table : {&even, &odd}) {
+      std::vector<bool> seen(table->size(), false);
+      for(size_t i = 0; i < table->size(); ++i) {
+        if(!is_block(int(i))) {
+          continue;
+        } else if(seen[(*table)[i]]) {
+          return false;
+        }
+        seen[(*table)[i]] = true;
+      }
+    }
+    return true;
+  }
+
+  // mcell's notation, e.g. "MS,D0;8;4;3;2;5;9;7;1;6;10;11;12;13;14;15", with a
+  // state count for more than two states and the odd table after the even one
+  std::string str() const {
+    std::string s = "MS";
+    if(no_states > 2) {
+      s += ",C" + std::to_string(no_states);
+    }
+    s += ",D";
+    for(size_t i = 0; i < even.size(); ++i) {
+      s += (i ? ";" : "") + std::to_string(even[i]);
+    }
+    if(odd != even) {
+      for(uint8_t next : odd) {
+        s += ";" + std::to_string(next);
+      }
+    }
+    return s;
+  }
+
+  bool operator==(const BlockSpec &other) const {
+    return no_states == other.no_states && even == other.even && odd == other.odd;
+  }
+};
+
+// MS[,Cn],Dt0;t1;... with one table entry per block, or two tables' worth for
+// rules that alternate. on failure, returns false and describes the problem in error
+inline bool parse_block_rulestring(const std::string &rulestring, BlockSpec &rule, std::string &error) {
+  std::vector<std::string> parts(1);
+  for(char c : rulestring) {
+    if(isspace((unsigned char)c)) {
+      continue;
+    } else if(c == ',') {
+      parts.emplace_back();
+    } else {
+      parts.back() += char(toupper((unsigned char)c));
+    }
+  }
+  if(parts.size() < 2 || parts.size() > 3 || parts.front() != "MS" || parts.back().empty() || parts.back()[0] != 'D') {
+    error = "'" + rulestring + "' is not of the form MS,Dt0;t1;...";
+    return false;
+  }
+
+  auto &&parse_int = [&](const std::string &digits, int &value) mutable -> bool {
+    if(digits.empty() || digits.length() > 3 || digits.find_first_not_of("0123456789") != std::string::npos) {
+      error = "invalid number '" + digits + "' in '" + rulestring + "'";
+      return false;
+    }
+    value = std::stoi(digits);
+    return true;
+  };
+
+  BlockSpec r;
+  if(parts.size() == 3) {
+    if(parts[1].empty() || parts[1][0] != 'C' || !parse_int(parts[1].substr(1), r.no_states)) {
+      error = "expected the number of states in '" + parts[1] + "'";
+      return false;
+    }
+    if(r.no_states < 2 || r.no_states > BlockSpec::max_states) {
+      error = "number of states " + std::to_string(r.no_states) + " is not within 2.." + std::to_string(BlockSpec::max_states);
+      return false;
+    }
+  }
+  std::vector<uint8_t> entries;
+  const std::string &table = parts.back();
+  size_t start = 1;
+  while(start <= table.length()) {
+    const size_t semicolon = std::min(table.find(';', start), table.length());
+    int next = 0;
+    if(!parse_int(table.substr(start, semicolon - start), next)) {
+      return false;
+    }
+    if(size_t(next) >= r.table_size() || !r.is_block(next)) {
+      error = "block " + std::to_string(next) + " has cells that are not within 0.." + std::to_string(r.no_states - 1);
+      return false;
+    }
+    entries.push_back(uint8_t(next));
+    start = semicolon + 1;
+  }
+  if(entries.size() != r.table_size() && entries.size() != 2 * r.table_size()) {
+    error = "'" + rulestring + "' has " + std::to_string(entries.size()) + " entries, not "
+      + std::to_string(r.table_size()) + " or " + std::to_string(2 * r.table_size());
+    return false;
+  }
+  r.even.assign(entries.begin(), entries.begin() + r.table_size());
+  r.odd.assign(entries.end() - r.table_size(), entries.end());
+  rule = r;
+  return true;
+}
+
+// the rulestring of a registry entry, which is built in and so always parses
+template <typename Spec>
+inline Spec parse_registry_rule(const char *name, const char *rulestring, bool (*parse)(const std::string &, Spec &, std::string &)) {
+  Spec rule;
+  std::string error;
+  if(!parse(rulestring, rule, error)) {
+    TERMINATE("invalid rule %s '%s': %s\n", name, rulestring, error.c_str());
+  }
+  return rule;
+}
+
+} // namespace ca
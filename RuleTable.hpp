@@ -0,0 +1,706 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+#include <Random.hpp>
+
+// golly's rule tables, the @TABLE section of a .rule file: transitions from a
+// cell and its neighbours to the next state of the cell. the first transition
+// that matches wins, and a cell no transition matches keeps its state.
+// a table is compiled into a decision diagram that reads one cell per level,
+// with a node per distinct rest of the table, and when the neighbourhoods are
+// few enough it is flattened into a lookup table of all of them. see
+// Renderer<..., TEXTURES, ...> and shaders/table.comp for the gpu.
+// https://golly.sourceforge.io/Help/formats.html#rule
+namespace ruletable {
+
+enum neighbourhood : int {
+  MOORE, VON_NEUMANN, HEXAGONAL, NO_NEIGHBOURHOODS
+};
+
+constexpr const char *neighbourhood_names[] = {
+  "Moore", "vonNeumann", "hexagonal"
+};
+
+// the cells of a transition as (dy, dx), in golly's order: the cell first, then
+// its neighbours clockwise from north. hexagonal is sheared as ca::RuleSpec has it
+inline const std::vector<std::array<int, 2>> &offsets(int nb) {
+  static const std::vector<std::array<int, 2>> layouts[NO_NEIGHBOURHOODS] = {
+    {{0, 0}, {-1, 0}, {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}},
+    {{0, 0}, {-1, 0}, {0, 1}, {1, 0}, {0, -1}},
+    {{0, 0}, {-1, 0}, {0, 1}, {1, 1}, {1, 0}, {0, -1}, {-1, -1}},
+  };
+  return layouts[nb];
+}
+
+inline int no_inputs(int nb) {
+  return int(offsets(nb).size());
+}
+
+// a transition lists its cells and then the next state. a token is a state if
+// it is not negative, and variable -1 - token otherwise
+struct Transition {
+  std::vector<int> tokens;
+  std::string symmetries;
+};
+
+struct Table {
+  std::string name;
+  int no_states = 0;
+  int nb = MOORE;
+  std::vector<std::vector<uint8_t>> variables;
+  std::vector<Transition> transitions;
+};
+
+namespace detail {
+
+inline std::string trim(const std::string &s) {
+  const size_t i = s.find_first_not_of(" \t\r"), j = s.find_last_not_of(" \t\r");
+  return (i == std::string::npos) ? std::string() : s.substr(i, j - i + 1);
+}
+
+inline std::string lower(std::string s) {
+  for(char &c : s) {
+    c = char(tolower((unsigned char)c));
+  }
+  return s;
+}
+
+inline bool parse_state(const std::string &s, int &state) {
+  if(s.empty() || s.length() > 3 || !std::all_of(s.begin(), s.end(), [](char c) -> bool { return isdigit((unsigned char)c); })) {
+    return false;
+  }
+  state = atoi(s.c_str());
+  return true;
+}
+
+// the order of the neighbours of each transition under a symmetry, as indices
+// into the neighbours (without the cell). rotateN turns the ring of neighbours
+// by a multiple of its length / N, reflect mirrors it about the north-south axis
+inline bool symmetry_group(const std::string &name, int no_neighbours, std::vector<std::vector<int>> &group, std::string &error) {
+  const std::string sym = lower(name);
+  const int r = no_neighbours;
+  int step = r;
+  bool reflect = false;
+  if(sym == "none") {
+  } else if(sym == "reflect_horizontal") {
+    reflect = true;
+  } else if(sym.compare(0, 6, "rotate") == 0) {
+    size_t i = 6;
+    int order = 0;
+    while(i < sym.length() && isdigit((unsigned char)sym[i])) {
+      order = order * 10 + (sym[i++] - '0');
+    }
+    reflect = (sym.substr(i) == "reflect");
+    if(order <= 0 || r % order != 0 || (i < sym.length() && !reflect)) {
+      error = "symmetries '" + name + "' do not fit " + std::to_string(r) + " neighbours";
+      return false;
+    }
+    step = r / order;
+  } else {
+    error = "unknown symmetries '" + name + "'";
+    return false;
+  }
+  group.clear();
+  for(int shift = 0; shift < r; shift += step) {
+    for(int mirror = 0; mirror <= int(reflect); ++mirror) {
+      std::vector<int> order(r);
+      for(int i = 0; i < r; ++i) {
+        const int j = mirror ? (r - i) % r : i;
+        order[i] = (j + shift) % r;
+      }
+      group.push_back(order);
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+inline bool parse_table(const std::string &text, Table &table, std::string &error) {
+  Table t;
+  std::map<std::string, int> names;
+  std::string symmetries = "none";
+  bool has_sections = false, in_table = false, has_table = false;
+  std::istringstream lines(text);
+  std::string line;
+  int lineno = 0;
+  auto &&fail = [&](const std::string &message) mutable -> bool {
+    error = "line " + std::to_string(lineno) + ": " + message;
+    return false;
+  };
+  // a plain .table file has no sections. comments may hold an '@' (such as
+  // an email address), so only the lines that start with one count
+  while(std::getline(lines, line) && !has_sections) {
+    line = detail::trim(line.substr(0, line.find('#')));
+    has_sections = !line.empty() && line[0] == '@';
+  }
+  in_table = !has_sections;
+  lines.clear();
+  lines.str(text);
+  while(std::getline(lines, line)) {
+    ++lineno;
+    line = detail::trim(line.substr(0, line.find('#')));
+    if(line.empty()) {
+      continue;
+    } else if(line[0] == '@') {
+      const std::string section = line.substr(0, line.find_first_of(" \t"));
+      in_table = (section == "@TABLE");
+      has_table = has_table || in_table;
+      if(section == "@RULE") {
+        t.name = detail::trim(line.substr(5));
+      }
+      continue;
+    } else if(!in_table) {
+      continue;
+    }
+    has_table = true;
+    const size_t colon = line.find(':');
+    if(colon != std::string::npos) {
+      const std::string key = detail::lower(detail::trim(line.substr(0, colon))), value = detail::trim(line.substr(colon + 1));
+      if(key == "n_states") {
+        if(!detail::parse_state(value, t.no_states) || t.no_states < 2 || t.no_states > 256) {
+          return fail("n_states must be within 2..256");
+        }
+      } else if(key == "neighborhood") {
+        t.nb = NO_NEIGHBOURHOODS;
+        for(int nb = 0; nb < NO_NEIGHBOURHOODS; ++nb) {
+          if(detail::lower(value) == detail::lower(neighbourhood_names[nb])) {
+            t.nb = nb;
+          }
+        }
+        if(t.nb == NO_NEIGHBOURHOODS) {
+          return fail("unsupported neighborhood '" + value + "'");
+        }
+      } else if(key == "symmetries") {
+        std::vector<std::vector<int>> group;
+        if(detail::lower(value) != "permute" && !detail::symmetry_group(value, no_inputs(t.nb) - 1, group, error)) {
+          return fail(error);
+        }
+        symmetries = value;
+      } else {
+        return fail("unknown key '" + key + "'");
+      }
+      continue;
+    }
+    if(t.no_states == 0) {
+      return fail("n_states must come first");
+    }
+    if(line.compare(0, 4, "var ") == 0) {
+      const size_t eq = line.find('='), open = line.find('{'), close = line.find('}');
+      if(eq == std::string::npos || open == std::string::npos || close == std::string::npos || open > close) {
+        return fail("expected var name={...}");
+      }
+      const std::string name = detail::trim(line.substr(4, eq - 4));
+      std::vector<uint8_t> states;
+      std::istringstream items(line.substr(open + 1, close - open - 1));
+      std::string item;
+      while(std::getline(items, item, ',')) {
+        item = detail::trim(item);
+        int state = 0;
+        if(detail::parse_state(item, state) && state < t.no_states) {
+          states.push_back(uint8_t(state));
+        } else if(names.count(item)) {
+          const std::vector<uint8_t> &other = t.variables[names[item]];
+          states.insert(states.end(), other.begin(), other.end());
+        } else {
+          return fail("'" + item + "' is neither a state nor a variable");
+        }
+      }
+      if(name.empty() || states.empty()) {
+        return fail("empty variable");
+      }
+      std::sort(states.begin(), states.end());
+      states.erase(std::unique(states.begin(), states.end()), states.end());
+      names[name] = int(t.variables.size());
+      t.variables.push_back(states);
+      continue;
+    }
+    // comma separated, or a character per cell when all states are digits
+    const int no_tokens = no_inputs(t.nb) + 1;
+    std::vector<std::string> items;
+    if(line.find(',') != std::string::npos) {
+      std::istringstream fields(line);
+      std::string item;
+      while(std::getline(fields, item, ',')) {
+        items.push_back(detail::trim(item));
+      }
+    } else if(t.no_states <= 10 && int(line.length()) == no_tokens) {
+      for(char c : line) {
+        items.push_back(std::string(1, c));
+      }
+    } else {
+      return fail("cannot read '" + line + "'");
+    }
+    if(int(items.size()) != no_tokens) {
+      return fail(std::to_string(items.size()) + " entries, not " + std::to_string(no_tokens));
+    }
+    Transition transition;
+    transition.symmetries = symmetries;
+    for(int i = 0; i < no_tokens; ++i) {
+      int state = 0;
+      if(detail::parse_state(items[i], state)) {
+        if(state >= t.no_states) {
+          return fail("state " + items[i] + " of " + std::to_string(t.no_states));
+        }
+        transition.tokens.push_back(state);
+      } else if(names.count(items[i])) {
+        transition.tokens.push_back(-1 - names[items[i]]);
+      } else {
+        return fail("unknown variable '" + items[i] + "'");
+      }
+    }
+    const int out = transition.tokens.back();
+    if(out < 0 && std::find(transition.tokens.begin(), transition.tokens.end() - 1, out) == transition.tokens.end() - 1) {
+      return fail("the next state is a variable that no cell binds");
+    }
+    t.transitions.push_back(transition);
+  }
+  if(!has_table || t.no_states == 0) {
+    error = "no @TABLE section";
+    return false;
+  }
+  table = t;
+  return true;
+}
+
+inline bool load_table(const std::string &path, Table &table, std::string &error) {
+  std::ifstream file(path);
+  if(!file) {
+    error = "unable to open '" + path + "'";
+    return false;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  if(!parse_table(text.str(), table, error)) {
+    return false;
+  }
+  if(table.name.empty()) {
+    table.name = path;
+  }
+  return true;
+}
+
+// levels 0..no_inputs - 1 read the cells in the order of offsets(nb). a node is
+// no_states entries of tree: the offsets of the nodes of the next level, or the
+// next states at the last one. identical nodes are shared, so the diagram is
+// as small as the order of the cells allows
+struct Compiled {
+  std::string name;
+  int no_states = 0;
+  int nb = MOORE;
+  int no_inputs = 0;
+  std::vector<uint32_t> tree;
+  uint32_t root = 0;
+  size_t no_nodes = 0;
+  // the next state of every neighbourhood at the sum of cell i * strides[i],
+  // when there are at most max_lut of them
+  static constexpr size_t max_lut = size_t(1) << 20;
+  std::vector<uint8_t> lut;
+  std::vector<uint32_t> strides;
+};
+
+namespace detail {
+
+struct Compiler {
+  const int n, k;
+  // the transitions with their symmetries spelled out, in the order they match
+  std::vector<std::vector<int>> rules;
+  // per rule and cell: the earlier cell bound to the same variable, or -1
+  std::vector<std::vector<int>> bind;
+  // per rule: the cells whose states a later cell or the next state refer to
+  std::vector<std::vector<int>> refs;
+  std::vector<std::bitset<256>> sets;
+  std::set<int> anonymous_ids;
+  std::vector<uint8_t> cells;
+  std::unordered_map<std::string, uint32_t> memo;
+  std::map<std::vector<uint32_t>, uint32_t> nodes;
+  Compiled &out;
+
+  Compiler(const Table &table, Compiled &out):
+    n(table.no_states), k(no_inputs(table.nb)), cells(k, 0), out(out)
+  {
+    for(const std::vector<uint8_t> &states : table.variables) {
+      std::bitset<256> set;
+      for(uint8_t s : states) {
+        set.set(s);
+      }
+      sets.push_back(set);
+    }
+  }
+
+  bool matches(int token, int state) const {
+    return (token >= 0) ? token == state : sets[-1 - token].test(state);
+  }
+
+  // a variable used once binds nothing, so it is replaced by the first variable
+  // of the same states, made anonymous. this keeps the permutations of
+  // 'permute' to those of distinct sets
+  std::vector<int> anonymize(const std::vector<int> &tokens, const Table &table, std::map<std::vector<uint8_t>, int> &anonymous) {
+    std::vector<int> result = tokens;
+    for(int i = 0; i < k; ++i) {
+      const int token = tokens[i];
+      if(token >= 0 || std::count(tokens.begin(), tokens.end(), token) > 1) {
+        continue;
+      }
+      const std::vector<uint8_t> &states = table.variables[-1 - token];
+      auto found = anonymous.find(states);
+      if(found == anonymous.end()) {
+        found = anonymous.emplace(states, int(sets.size())).first;
+        sets.push_back(sets[-1 - token]);
+        anonymous_ids.insert(found->second);
+      }
+      result[i] = -1 - found->second;
+    }
+    return result;
+  }
+
+  bool expand(const Table &table, std::string &error) {
+    std::map<std::vector<uint8_t>, int> anonymous;
+    for(const Transition &transition : table.transitions) {
+      const std::vector<int> tokens = anonymize(transition.tokens, table, anonymous);
+      std::set<std::vector<int>> seen;
+      auto &&add = [&](const std::vector<int> &rule) mutable -> void {
+        if(seen.insert(rule).second) {
+          rules.push_back(rule);
+        }
+      };
+      const int output = tokens.back();
+      // when the output is bound by a neighbour, the order in which the
+      // permutations are tried decides the value, and it is that of the orders
+      // of the neighbours, as for the other symmetries. otherwise any order of
+      // the distinct permutations of the tokens matches the same
+      const bool bound_by_neighbour = output < 0 && output != tokens[0]
+        && std::find(tokens.begin() + 1, tokens.end() - 1, output) != tokens.end() - 1;
+      if(lower(transition.symmetries) == "permute" && !bound_by_neighbour) {
+        std::vector<int> neighbours(tokens.begin() + 1, tokens.end() - 1);
+        std::sort(neighbours.begin(), neighbours.end());
+        do {
+          std::vector<int> rule = {tokens[0]};
+          rule.insert(rule.end(), neighbours.begin(), neighbours.end());
+          rule.push_back(output);
+          add(rule);
+        } while(std::next_permutation(neighbours.begin(), neighbours.end()));
+        continue;
+      } else if(lower(transition.symmetries) == "permute") {
+        std::vector<int> order(k - 1);
+        std::iota(order.begin(), order.end(), 0);
+        do {
+          std::vector<int> rule = tokens;
+          for(int i = 0; i < k - 1; ++i) {
+            rule[1 + i] = tokens[1 + order[i]];
+          }
+          add(rule);
+        } while(std::next_permutation(order.begin(), order.end()));
+        continue;
+      }
+      std::vector<std::vector<int>> group;
+      if(!symmetry_group(transition.symmetries, k - 1, group, error)) {
+        return false;
+      }
+      for(const std::vector<int> &order : group) {
+        std::vector<int> rule = tokens;
+        for(int i = 0; i < k - 1; ++i) {
+          rule[1 + i] = tokens[1 + order[i]];
+        }
+        add(rule);
+      }
+    }
+    for(const std::vector<int> &rule : rules) {
+      std::vector<int> b(k + 1, -1), r;
+      for(int i = 0; i <= k; ++i) {
+        if(rule[i] >= 0 || anonymous_ids.count(-1 - rule[i])) {
+          continue;
+        }
+        const int first = int(std::find(rule.begin(), rule.end(), rule[i]) - rule.begin());
+        if(first < i) {
+          b[i] = first;
+          if(std::find(r.begin(), r.end(), first) == r.end()) {
+            r.push_back(first);
+          }
+        }
+      }
+      bind.push_back(b);
+      refs.push_back(r);
+    }
+    return true;
+  }
+
+  uint32_t intern(int level, const std::vector<uint32_t> &children) {
+    std::vector<uint32_t> key = {uint32_t(level)};
+    key.insert(key.end(), children.begin(), children.end());
+    auto found = nodes.find(key);
+    if(found != nodes.end()) {
+      return found->second;
+    }
+    const uint32_t offset = uint32_t(out.tree.size());
+    out.tree.insert(out.tree.end(), children.begin(), children.end());
+    nodes.emplace(key, offset);
+    return offset;
+  }
+
+  // the node of level that the cells so far lead to, given the rules still matching
+  uint32_t build(int level, const std::vector<uint32_t> &candidates) {
+    if(level == k) {
+      if(candidates.empty()) {
+        return cells[0];
+      }
+      const std::vector<int> &rule = rules[candidates.front()];
+      return (rule[k] >= 0) ? uint32_t(rule[k]) : cells[bind[candidates.front()][k]];
+    }
+    // what the rest of the diagram depends on: the cell, for when nothing
+    // matches, and the states of the cells that the candidates bind
+    std::string key;
+    key.push_back(char(level));
+    if(level > 0) {
+      key.push_back(char(cells[0]));
+    }
+    for(uint32_t c : candidates) {
+      key.append(reinterpret_cast<const char *>(&c), sizeof(c));
+      for(int i : refs[c]) {
+        if(i < level) {
+          key.push_back(char(cells[i]));
+        }
+      }
+    }
+    auto found = memo.find(key);
+    if(found != memo.end()) {
+      return found->second;
+    }
+    std::vector<uint32_t> children(n), next;
+    for(int s = 0; s < n; ++s) {
+      cells[level] = uint8_t(s);
+      next.clear();
+      for(uint32_t c : candidates) {
+        const int b = bind[c][level];
+        if(matches(rules[c][level], s) && (b < 0 || cells[b] == s)) {
+          next.push_back(c);
+        }
+      }
+      children[s] = build(level + 1, next);
+    }
+    const uint32_t offset = intern(level, children);
+    memo.emplace(key, offset);
+    return offset;
+  }
+
+  void flatten(uint32_t node, int level, uint32_t index) {
+    for(int s = 0; s < n; ++s) {
+      const uint32_t child = out.tree[node + s], i = index + uint32_t(s) * out.strides[level];
+      if(level == k - 1) {
+        out.lut[i] = uint8_t(child);
+      } else {
+        flatten(child, level + 1, i);
+      }
+    }
+  }
+};
+
+} // namespace detail
+
+inline bool compile(const Table &table, Compiled &compiled, std::string &error) {
+  Compiled out;
+  out.name = table.name;
+  out.no_states = table.no_states;
+  out.nb = table.nb;
+  out.no_inputs = no_inputs(table.nb);
+  detail::Compiler compiler(table, out);
+  if(!compiler.expand(table, error)) {
+    return false;
+  }
+  std::vector<uint32_t> all(compiler.rules.size());
+  for(uint32_t i = 0; i < all.size(); ++i) {
+    all[i] = i;
+  }
+  out.root = compiler.build(0, all);
+  out.no_nodes = compiler.nodes.size();
+  size_t size = 1;
+  for(int i = 0; i < out.no_inputs && size <= Compiled::max_lut; ++i) {
+    size *= size_t(out.no_states);
+  }
+  if(size <= Compiled::max_lut) {
+    out.strides.assign(out.no_inputs, 1);
+    for(int i = out.no_inputs - 2; i >= 0; --i) {
+      out.strides[i] = out.strides[i + 1] * out.no_states;
+    }
+    out.lut.resize(size);
+    compiler.flatten(out.root, 0, 0);
+  }
+  compiled = std::move(out);
+  return true;
+}
+
+// a compiled table as an automaton. the host steps rows through the lookup table
+// when there is one, and walks the diagram otherwise. a cell in a state the table
+// does not have (from a pattern, or a frame of another rule) is read as the last
+// state, as the lookup table and the nodes only have no_states entries
+struct Rule {
+  using self_t = Rule;
+  static constexpr int outside_state = 0;
+  static constexpr int dim = 4;
+  static constexpr int update_mode = ::update_mode::ALL;
+
+  std::shared_ptr<const Compiled> compiled;
+  int no_states;
+
+  explicit Rule(const Compiled &table):
+    compiled(std::make_shared<const Compiled>(table)), no_states(table.no_states)
+  {}
+
+  const Compiled &get_table() const {
+    return *compiled;
+  }
+
+  uint8_t init_state(int y, int x) const {
+    return rng::random(y, x, no_states);
+  }
+
+  template <typename B>
+  uint8_t next_state(B &&prev, int y, int x) const {
+    const std::vector<std::array<int, 2>> &cells = offsets(compiled->nb);
+    const uint32_t *tree = compiled->tree.data();
+    const uint32_t top = uint32_t(no_states - 1);
+    uint32_t node = compiled->root;
+    for(const auto &[dy, dx] : cells) {
+      node = tree[node + std::min<uint32_t>(prev[y + dy][x + dx], top)];
+    }
+    return uint8_t(node);
+  }
+
+  // the cells of each neighbourhood as a compile-time list, so that the loops unroll
+  template <int NB>
+  void next_row_of(const uint8_t *__restrict up, const uint8_t *__restrict mid, const uint8_t *__restrict down,
+                   uint8_t *__restrict dst, int x0, int x1) const
+  {
+    constexpr int k = (NB == MOORE) ? 9 : ((NB == VON_NEUMANN) ? 5 : 7);
+    const std::vector<std::array<int, 2>> &cells = offsets(NB);
+    const uint8_t *rows[k];
+    int dxs[k];
+    for(int i = 0; i < k; ++i) {
+      rows[i] = (cells[i][0] < 0) ? up : ((cells[i][0] > 0) ? down : mid);
+      dxs[i] = cells[i][1];
+    }
+    const uint32_t top = uint32_t(no_states - 1);
+    if(!compiled->lut.empty()) {
+      const uint8_t *lut = compiled->lut.data();
+      uint32_t strides[k];
+      std::copy_n(compiled->strides.begin(), k, strides);
+      #pragma omp simd
+      for(int x = x0; x < x1; ++x) {
+        uint32_t index = 0;
+        for(int i = 0; i < k; ++i) {
+          index += std::min<uint32_t>(rows[i][x + dxs[i]], top) * strides[i];
+        }
+        dst[x] = lut[index];
+      }
+      return;
+    }
+    const uint32_t *tree = compiled->tree.data(), root = compiled->root;
+    for(int x = x0; x < x1; ++x) {
+      uint32_t node = root;
+      for(int i = 0; i < k; ++i) {
+        node = tree[node + std::min<uint32_t>(rows[i][x + dxs[i]], top)];
+      }
+      dst[x] = uint8_t(node);
+    }
+  }
+
+  // cells x0..x1-1 of a row, given the rows above and below; x0 - 1 and x1 must be readable
+  void next_row(const uint8_t *__restrict up, const uint8_t *__restrict mid, const uint8_t *__restrict down,
+                uint8_t *__restrict dst, int x0, int x1) const
+  {
+    switch(compiled->nb) {
+      case MOORE: next_row_of<MOORE>(up, mid, down, dst, x0, x1); break;
+      case VON_NEUMANN: next_row_of<VON_NEUMANN>(up, mid, down, dst, x0, x1); break;
+      case HEXAGONAL: next_row_of<HEXAGONAL>(up, mid, down, dst, x0, x1); break;
+    }
+  }
+};
+
+// golly's WireWorld.rule. a conductor next to one or two heads fires here, where
+// ca::Wireworld wants exactly two
+const char *const wireworld_table = R"(@RULE WireWorldTable
+@TABLE
+n_states:4
+neighborhood:Moore
+symmetries:permute
+var a={0,1,2,3}
+var b={0,1,2,3}
+var c={0,1,2,3}
+var d={0,1,2,3}
+var e={0,1,2,3}
+var f={0,1,2,3}
+var g={0,1,2,3}
+var h={0,1,2,3}
+var i={0,2,3}
+var j={0,2,3}
+var k={0,2,3}
+var l={0,2,3}
+var m={0,2,3}
+var n={0,2,3}
+var o={0,2,3}
+# a head becomes a tail, a tail a conductor
+1,a,b,c,d,e,f,g,h,2
+2,a,b,c,d,e,f,g,h,3
+# a conductor with one or two heads around becomes a head
+3,1,i,j,k,l,m,n,o,1
+3,1,1,i,j,k,l,m,n,1
+)";
+
+// the named tables, for --rule and --list-rules
+struct RuleEntry {
+  const char *name;
+  const char *text;
+};
+
+const std::vector<RuleEntry> registry = {
+  { "WireWorldTable", wireworld_table },
+};
+
+inline int find_rule(const std::string &name) {
+  for(size_t i = 0; i < registry.size(); ++i) {
+    if(detail::lower(registry[i].name) == detail::lower(detail::trim(name))) {
+      return int(i);
+    }
+  }
+  return -1;
+}
+
+// a registry name or the path of a .rule or .table file
+inline bool is_table(const std::string &name_or_path) {
+  const std::string s = detail::lower(detail::trim(name_or_path));
+  auto &&ends_with = [&](const std::string &ext) -> bool {
+    return s.length() > ext.length() && s.compare(s.length() - ext.length(), ext.length(), ext) == 0;
+  };
+  return find_rule(name_or_path) != -1 || ends_with(".rule") || ends_with(".table");
+}
+
+inline bool resolve_rule(const std::string &name_or_path, Compiled &compiled, std::string &error) {
+  Table table;
+  const int index = find_rule(name_or_path);
+  if(index != -1) {
+    if(!parse_table(registry[index].text, table, error)) {
+      return false;
+    }
+  } else if(!load_table(detail::trim(name_or_path), table, error)) {
+    return false;
+  }
+  return compile(table, compiled, error);
+}
+
+} // namespace ruletable
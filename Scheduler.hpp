@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+#include <Logger.hpp>
+#include <Threads.hpp>
+
+// work stealing for uneven loops, such as stepping only the live tiles:
+// every worker owns a deque of index ranges, takes work from its back and,
+// once empty, steals from the front of the others. the workers are the
+// threads of the openmp team, so they run on the cpus pin_threads gave them
+// (see Numa.hpp) and start on the rows they first touched; there is no second
+// pool to compete with the team for cores
+namespace sys {
+
+class Scheduler {
+  using range_t = std::pair<size_t, size_t>;
+  using task_t = std::function<void(size_t, int)>;
+  using clock = std::chrono::steady_clock;
+
+  struct alignas(64) Worker {
+    std::mutex lock;
+    std::deque<range_t> ranges;
+    // per loop, read by the caller once every worker has finished
+    size_t no_tasks = 0, no_steals = 0;
+    double busy = 0;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::atomic<size_t> no_pending{0};
+
+  static std::atomic<Scheduler *> &instance() {
+    static std::atomic<Scheduler *> scheduler{nullptr};
+    return scheduler;
+  }
+public:
+  // of the last loop: how busy the workers were between its start and its end
+  struct Stats {
+    int no_threads = 0;
+    size_t no_tasks = 0, no_steals = 0;
+    double occupancy = 0, ms = 0;
+  };
+  Stats stats;
+
+  static Scheduler &get() {
+    static Scheduler scheduler(get_max_threads());
+    instance().store(&scheduler, std::memory_order_release);
+    return scheduler;
+  }
+
+  // the scheduler if some loop has asked for it, for readers of its stats
+  static const Scheduler *find() {
+    return instance().load(std::memory_order_acquire);
+  }
+
+  explicit Scheduler(int no_threads) {
+    no_threads = std::max(no_threads, 1);
+    for(int i = 0; i < no_threads; ++i) {
+      workers.emplace_back(new Worker);
+    }
+    Logger::Info("[scheduler] %d workers\n", no_threads);
+  }
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  int no_threads() const {
+    return int(workers.size());
+  }
+
+  // calls f(i, worker) for every i in [0, n), in ranges of `grain` indices.
+  // worker k starts with the k-th contiguous share, the rows a static
+  // schedule gives thread k
+  template <typename F>
+  void run(size_t n, size_t grain, F &&f) {
+    if(n == 0) {
+      return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    const task_t fn = std::forward<F>(f);
+    const clock::time_point t0 = clock::now();
+    const int no_workers = int(workers.size());
+    size_t no_ranges = 0;
+    for(int k = 0; k < no_workers; ++k) {
+      Worker &wk = *workers[k];
+      wk.no_tasks = wk.no_steals = 0, wk.busy = 0;
+      const size_t begin = n * k / no_workers, end = n * (k + 1) / no_workers;
+      for(size_t i = begin; i < end; i += grain) {
+        wk.ranges.emplace_back(i, std::min(end, i + grain));
+        ++no_ranges;
+      }
+    }
+    no_pending = no_ranges;
+    // a smaller team than asked for steals the shares of the missing threads
+    #pragma omp parallel num_threads(no_workers)
+    work(get_thread_num(), fn);
+    const double wall = std::chrono::duration<double>(clock::now() - t0).count();
+    stats = Stats();
+    stats.no_threads = no_workers;
+    stats.ms = wall * 1e3;
+    double busy = 0;
+    for(const auto &wk : workers) {
+      stats.no_tasks += wk->no_tasks;
+      stats.no_steals += wk->no_steals;
+      busy += wk->busy;
+    }
+    stats.occupancy = (wall > 0) ? std::min(1., busy / (wall * no_workers)) : 1.;
+  }
+
+  ~Scheduler() {
+    Scheduler *self = this;
+    instance().compare_exchange_strong(self, nullptr);
+  }
+private:
+  bool pop(Worker &wk, range_t &r) {
+    std::lock_guard<std::mutex> guard(wk.lock);
+    if(wk.ranges.empty()) {
+      return false;
+    }
+    r = wk.ranges.back();
+    wk.ranges.pop_back();
+    return true;
+  }
+
+  bool steal(Worker &victim, range_t &r) {
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if(victim.ranges.empty()) {
+      return false;
+    }
+    r = victim.ranges.front();
+    victim.ranges.pop_front();
+    return true;
+  }
+
+  void work(int k, const task_t &fn) {
+    Worker &wk = *workers[k];
+    const int no_workers = int(workers.size());
+    range_t r;
+    while(no_pending.load(std::memory_order_acquire) > 0) {
+      bool found = pop(wk, r);
+      for(int d = 1; !found && d < no_workers; ++d) {
+        found = steal(*workers[(k + d) % no_workers], r);
+        wk.no_steals += found;
+      }
+      if(!found) {
+        // the last ranges are being worked on elsewhere
+        std::this_thread::yield();
+        continue;
+      }
+      const clock::time_point t0 = clock::now();
+      for(size_t i = r.first; i < r.second; ++i) {
+        fn(i, k);
+      }
+      wk.busy += std::chrono::duration<double>(clock::now() - t0).count();
+      ++wk.no_tasks;
+      no_pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  }
+};
+
+} // namespace sys
@@ -36,6 +36,8 @@ template <ShaderType ShaderT>
 struct Shader {
   sys::File file;
   GLuint shaderId = 0;
+  // inserted right after the #version line, e.g. "#define LOCAL_SIZE 16\n"
+  std::string defines = "";
   static constexpr ShaderType shader_type = ShaderT;
 
   explicit Shader(std::string filename):
@@ -58,9 +60,19 @@ struct Shader {
     return shaderId;
   }
 
+  std::string load_source() {
+    std::string source_code = file.load_text();
+    if(!defines.empty()) {
+      const size_t version_end = source_code.find('\n');
+      const size_t pos = (source_code.compare(0, 8, "#version") == 0 && version_end != std::string::npos) ? version_end + 1 : 0;
+      source_code.insert(pos, defines);
+    }
+    return source_code;
+  }
+
   void init() {
     shaderId = glCreateShader(gl::get_gl_shader_constant<ShaderT>()); GLERROR
-    std::string source_code = file.load_text();
+    std::string source_code = load_source();
     const char *source = source_code.c_str();
     glShaderSource(shaderId, 1, &source, nullptr); GLERROR
     glCompileShader(shaderId); GLERROR
@@ -12,6 +12,7 @@
 #include <Shader.hpp>
 #include <ShaderAttrib.hpp>
 #include <VertexArray.hpp>
+#include <ProgramCache.hpp>
 
 namespace gl {
 template <typename... ShaderTs>
@@ -21,6 +22,8 @@ class ShaderProgram {
   GLuint programId = 0;
   std::tuple<ShaderTs...> shaders;
   bool shaderOwnership;
+  // loaded through glProgramBinary, so there are no shaders attached
+  bool fromBinary = false;
 
   enum class ResourceType {
     UNIFORM,
@@ -91,7 +94,60 @@ public:
     program.compile_program();
   }
 
+  // key of the program binary cache: preprocessed sources of every stage and the driver
+  uint64_t get_cache_key(const std::string &identity) {
+    uint64_t key = ProgramCache::hash(identity);
+    Tuple::for_each(shaders, [&](auto &s) mutable -> void {
+      key = ProgramCache::hash(std::to_string(int(s.shader_type)) + "\n" + s.load_source(), key);
+    });
+    return key;
+  }
+
+  bool load_binary(const std::string &path, const std::string &identity, uint64_t key) {
+    GLenum format;
+    std::vector<char> data;
+    if(!ProgramCache::load(path, identity, key, format, data)) {
+      return false;
+    }
+    programId = glCreateProgram(); GLERROR
+    ASSERT(this->programId != 0);
+    glProgramBinary(programId, format, data.data(), data.size());
+    // a driver may reject a binary it produced itself, e.g. after an update; that is not an error
+    for(GLenum err = glGetError(); err != GL_NO_ERROR; err = glGetError())
+      ;
+    if(get<GL_LINK_STATUS>() != GL_TRUE) {
+      Logger::Info("program cache: '%s' rejected by the driver, recompiling\n", path.c_str());
+      glDeleteProgram(programId); GLERROR
+      programId = 0;
+      return false;
+    }
+    Logger::Debug("program cache: loaded '%s'\n", path.c_str());
+    fromBinary = true;
+    return true;
+  }
+
+  void store_binary(const std::string &path, const std::string &identity, uint64_t key) {
+    if(get<GL_LINK_STATUS>() != GL_TRUE || get<GL_PROGRAM_BINARY_LENGTH>() <= 0) {
+      return;
+    }
+    Binary binary(*this);
+    ProgramCache::store(path, identity, key, binary.format, binary.data, binary.size);
+  }
+
   void compile_program() {
+    const bool use_cache = shaderOwnership && ProgramCache::is_supported();
+    std::string identity, cache_path;
+    uint64_t cache_key = 0;
+    if(use_cache) {
+      identity = get_gl_identity();
+      cache_key = get_cache_key(identity);
+      cache_path = ProgramCache::get_path(cache_key);
+      if(load_binary(cache_path, identity, cache_key)) {
+        ASSERT(this->is_valid());
+        return;
+      }
+    }
+    fromBinary = false;
     Tuple::for_each(shaders, [&](auto &s) mutable -> void {
       Logger::Debug("init shader '%s'\n", s.file.name().c_str());
       if(shaderOwnership) {
@@ -105,6 +161,9 @@ public:
       Logger::Debug("attach shader '%s'\n", s.file.name().c_str());
       glAttachShader(programId, s.id()); GLERROR
     });
+    if(use_cache) {
+      glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); GLERROR
+    }
     Logger::Debug("link program\n");
     glLinkProgram(programId); GLERROR
     Tuple::for_each(shaders, [&](auto &s) mutable -> void {
@@ -114,6 +173,16 @@ public:
       }
     });
     ASSERT(this->is_valid());
+    if(use_cache) {
+      store_binary(cache_path, identity, cache_key);
+    }
+  }
+
+  // preprocessor definitions for all shaders of the program, applied on the next compilation
+  void set_defines(const std::string &defines) {
+    Tuple::for_each(shaders, [&](auto &s) mutable -> void {
+      s.defines = defines;
+    });
   }
 
   void bind_attrib(int index, const std::string &location) {
@@ -222,6 +291,22 @@ public:
     return wg_size;
   }
 
+  static glm::ivec3 get_max_wgcount() {
+    glm::ivec3 wg_count(0, 0, 0);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &wg_count.x); GLERROR
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 1, &wg_count.y); GLERROR
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 2, &wg_count.z); GLERROR
+    return wg_count;
+  }
+
+  // identifies the driver, for caches of anything measured or compiled on it
+  static std::string get_gl_identity() {
+    const char *vendor = (const char *)glGetString(GL_VENDOR); GLERROR
+    const char *renderer = (const char *)glGetString(GL_RENDERER); GLERROR
+    const char *version = (const char *)glGetString(GL_VERSION); GLERROR
+    return std::string(vendor ? vendor : "") + " | " + (renderer ? renderer : "") + " | " + (version ? version : "");
+  }
+
   static int get_max_wg_invocations() {
     int wg_invocations;
     glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &wg_invocations); GLERROR
@@ -252,10 +337,13 @@ public:
   }
 
   void clear() {
-    Tuple::for_each(shaders, [&](const auto &s) {
-      glDetachShader(programId, s.id()); GLERROR
-    });
+    if(!fromBinary) {
+      Tuple::for_each(shaders, [&](const auto &s) {
+        glDetachShader(programId, s.id()); GLERROR
+      });
+    }
     glDeleteProgram(programId); GLERROR
+    fromBinary = false;
   }
 
   bool is_valid() {
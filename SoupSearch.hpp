@@ -0,0 +1,494 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+
+#include <Logger.hpp>
+#include <Threads.hpp>
+#include <Automaton.hpp>
+#include <Random.hpp>
+#include <Period.hpp>
+
+// census of the objects random soups settle into, in the spirit of apgsearch:
+// every soup is a 16x16 random square on a bounded plane, run until its state
+// repeats; spaceships that reach the edge of the margin are classified and
+// taken out as they leave, the rest is split into clusters once the soup is periodic.
+namespace soup {
+
+// a cropped pattern, row-major
+struct Pattern {
+  int w = 0, h = 0;
+  std::vector<uint8_t> cells;
+
+  int population() const {
+    return int(std::count_if(cells.begin(), cells.end(), [](uint8_t c) -> bool { return c != 0; }));
+  }
+
+  uint64_t hash() const {
+    uint64_t x = 0xcbf29ce484222325ULL;
+    auto &&mix = [&](uint64_t v) mutable -> void {
+      x = (x ^ v) * 0x100000001b3ULL;
+    };
+    mix(w), mix(h);
+    for(uint8_t c : cells) {
+      mix(c);
+    }
+    return x;
+  }
+
+  // one of the 8 symmetries of the square
+  Pattern transform(int t) const {
+    const bool transpose = t & 4;
+    Pattern p;
+    p.w = transpose ? h : w;
+    p.h = transpose ? w : h;
+    p.cells.resize(cells.size());
+    for(int y = 0; y < h; ++y) {
+      for(int x = 0; x < w; ++x) {
+        const int xx = (t & 1) ? w - 1 - x : x;
+        const int yy = (t & 2) ? h - 1 - y : y;
+        if(transpose) {
+          p.cells[xx * p.w + yy] = cells[y * w + x];
+        } else {
+          p.cells[yy * p.w + xx] = cells[y * w + x];
+        }
+      }
+    }
+    return p;
+  }
+
+  // independent of position and orientation
+  uint64_t canonical_hash() const {
+    uint64_t best = ~0ULL;
+    for(int t = 0; t < 8; ++t) {
+      best = std::min(best, transform(t).hash());
+    }
+    return best;
+  }
+
+  bool operator==(const Pattern &other) const {
+    return w == other.w && h == other.h && cells == other.cells;
+  }
+};
+
+// square bounded grid with a dead border of one cell, so that every
+// neighbourhood read stays inside the buffer. only the bounding box of the
+// live cells (plus one cell of neighbourhood) is stepped, since soups spend
+// most of their life as a few small objects on an empty plane.
+template <typename AUT>
+struct Engine {
+  AUT aut;
+  int size = 0, stride = 0;
+  std::vector<uint8_t> cur, next;
+  // inclusive bounds of the live cells of cur and of whatever next still holds; empty when y1 < y0
+  int y0 = 0, y1 = -1, x0 = 0, x1 = -1;
+  int ny0 = 0, ny1 = -1, nx0 = 0, nx1 = -1;
+
+  Engine(const AUT &aut, int size):
+    aut(aut)
+  {
+    resize(size);
+  }
+
+  void resize(int s) {
+    size = s, stride = s + 2;
+    cur.assign(stride * stride, 0);
+    next.assign(stride * stride, 0);
+    y0 = ny0 = 0, y1 = ny1 = -1;
+    x0 = nx0 = 0, x1 = nx1 = -1;
+  }
+
+  void clear() {
+    std::fill(cur.begin(), cur.end(), 0);
+    std::fill(next.begin(), next.end(), 0);
+    y0 = ny0 = 0, y1 = ny1 = -1;
+    x0 = nx0 = 0, x1 = nx1 = -1;
+  }
+
+  bool empty() const {
+    return y1 < y0;
+  }
+
+  uint8_t at(int y, int x) const {
+    return cur[(y + 1) * stride + (x + 1)];
+  }
+
+  // clearing a cell leaves the bounds loose, which is harmless
+  void set(int y, int x, uint8_t c) {
+    cur[(y + 1) * stride + (x + 1)] = c;
+    if(c == 0) {
+      return;
+    }
+    if(empty()) {
+      y0 = y1 = y, x0 = x1 = x;
+      return;
+    }
+    y0 = std::min(y0, y), y1 = std::max(y1, y);
+    x0 = std::min(x0, x), x1 = std::max(x1, x);
+  }
+
+  void step() {
+    if(empty()) {
+      return;
+    }
+    const int by0 = std::max(0, y0 - 1), by1 = std::min(size - 1, y1 + 1);
+    const int bx0 = std::max(0, x0 - 1), bx1 = std::min(size - 1, x1 + 1);
+    // next holds the generation before cur, which may reach outside of the area about to be written
+    for(int y = ny0; y <= ny1; ++y) {
+      std::fill_n(&next[(y + 1) * stride + (nx0 + 1)], nx1 - nx0 + 1, 0);
+    }
+    int ty0 = size, ty1 = -1, tx0 = size, tx1 = -1;
+    for(int y = by0; y <= by1; ++y) {
+      uint8_t *dst = &next[(y + 1) * stride];
+      if constexpr(has_row_kernel<AUT>) {
+        aut.next_row(&cur[y * stride], &cur[(y + 1) * stride], &cur[(y + 2) * stride], dst, bx0 + 1, bx1 + 2);
+      } else {
+        const uint8_t *src = cur.data();
+        const int s = stride;
+        auto &&grid = make_grid<4>([=](int y, int x) mutable -> uint8_t {
+          return src[(y + 1) * s + (x + 1)];
+        }, size, size);
+        for(int x = bx0; x <= bx1; ++x) {
+          dst[x + 1] = aut.next_state(grid, y, x);
+        }
+      }
+      int lo = bx0, hi = bx1;
+      while(lo <= hi && !dst[lo + 1]) ++lo;
+      while(hi >= lo && !dst[hi + 1]) --hi;
+      if(lo <= hi) {
+        ty0 = std::min(ty0, y), ty1 = y;
+        tx0 = std::min(tx0, lo), tx1 = std::max(tx1, hi);
+      }
+    }
+    std::swap(cur, next);
+    ny0 = y0, ny1 = y1, nx0 = x0, nx1 = x1;
+    y0 = ty0, y1 = ty1, x0 = tx0, x1 = tx1;
+  }
+
+  // zobrist hash, independent of how loose the bounds are
+  uint64_t hash() const {
+    uint64_t h = 0;
+    for(int y = y0; y <= y1; ++y) {
+      for(int x = x0; x <= x1; ++x) {
+        h ^= period::key(y * size + x, at(y, x));
+      }
+    }
+    return h;
+  }
+
+  // cropped pattern of the live cells; (py, px) receives the top-left corner
+  Pattern crop(int &py, int &px) const {
+    int qy1 = -1, qx1 = -1;
+    py = size, px = size;
+    for(int y = y0; y <= y1; ++y) {
+      for(int x = x0; x <= x1; ++x) {
+        if(at(y, x)) {
+          py = std::min(py, y), qy1 = std::max(qy1, y);
+          px = std::min(px, x), qx1 = std::max(qx1, x);
+        }
+      }
+    }
+    Pattern p;
+    if(qy1 < 0) {
+      return p;
+    }
+    p.w = qx1 - px + 1, p.h = qy1 - py + 1;
+    p.cells.resize(p.w * p.h);
+    for(int y = 0; y < p.h; ++y) {
+      for(int x = 0; x < p.w; ++x) {
+        p.cells[y * p.w + x] = at(py + y, px + x);
+      }
+    }
+    return p;
+  }
+
+  // cells connected to (y, x) within chebyshev distance 2 are moved out into a
+  // pattern; (py, px) receives its top-left corner
+  Pattern extract_cluster(int y, int x, int &py, int &px, std::vector<int> &stack) {
+    std::vector<std::array<int, 3>> cluster;
+    stack.assign(1, y * size + x);
+    cluster.push_back({y, x, at(y, x)});
+    set(y, x, 0);
+    while(!stack.empty()) {
+      const int i = stack.back();
+      stack.pop_back();
+      const int cy = i / size, cx = i % size;
+      for(int iy = std::max(0, cy - 2); iy <= std::min(size - 1, cy + 2); ++iy) {
+        for(int ix = std::max(0, cx - 2); ix <= std::min(size - 1, cx + 2); ++ix) {
+          if(at(iy, ix)) {
+            cluster.push_back({iy, ix, at(iy, ix)});
+            set(iy, ix, 0);
+            stack.push_back(iy * size + ix);
+          }
+        }
+      }
+    }
+    int qy1 = 0, qx1 = 0;
+    py = size, px = size;
+    for(auto &[cy, cx, c] : cluster) {
+      py = std::min(py, cy), qy1 = std::max(qy1, cy);
+      px = std::min(px, cx), qx1 = std::max(qx1, cx);
+    }
+    Pattern p;
+    p.w = qx1 - px + 1, p.h = qy1 - py + 1;
+    p.cells.assign(p.w * p.h, 0);
+    for(auto &[cy, cx, c] : cluster) {
+      p.cells[(cy - py) * p.w + (cx - px)] = c;
+    }
+    return p;
+  }
+
+  void paste(const Pattern &p, int py, int px) {
+    for(int y = 0; y < p.h; ++y) {
+      for(int x = 0; x < p.w; ++x) {
+        if(p.cells[y * p.w + x]) {
+          set(py + y, px + x, p.cells[y * p.w + x]);
+        }
+      }
+    }
+  }
+};
+
+// per-thread counts, merged once at the end, so workers never contend
+struct Census {
+  std::unordered_map<std::string, uint64_t> counts;
+
+  void add(const std::string &code, uint64_t n=1) {
+    counts[code] += n;
+  }
+
+  void merge(const Census &other) {
+    for(const auto &[code, n] : other.counts) {
+      add(code, n);
+    }
+  }
+
+  std::vector<std::pair<std::string, uint64_t>> sorted() const {
+    std::vector<std::pair<std::string, uint64_t>> v(counts.begin(), counts.end());
+    std::sort(v.begin(), v.end(), [](const auto &a, const auto &b) -> bool {
+      return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+    });
+    return v;
+  }
+};
+
+struct Options {
+  size_t no_soups = 10000;
+  uint32_t seed = 0;
+  int soup_size = 16;
+  // empty space around the soup; objects reaching the outer band are classified and removed
+  int margin = 40;
+  int band = 4;
+  // clusters in the band are mostly debris, so only small ones get a short look
+  int max_leaving_size = 16;
+  int max_leaving_period = 16;
+  int max_generations = 4000;
+  int max_period = 64;
+  std::string census_path = "";
+};
+
+template <typename AUT>
+class Search {
+  const AUT &aut;
+  const Options &opts;
+public:
+  Census census;
+  size_t no_soups_done = 0;
+  double seconds = 0;
+
+  Search(const AUT &aut, const Options &opts):
+    aut(aut), opts(opts)
+  {}
+
+  // period and displacement of a pattern evolved on its own: xs (still life),
+  // xp (oscillator) or xq (spaceship), then population or period, then the canonical hash
+  using Memo = std::unordered_map<uint64_t, std::string>;
+
+  // the same few objects come up over and over, so each thread remembers the codes it has seen
+  static std::string classify(const AUT &aut, const Pattern &p, int max_period, Memo &known) {
+    const uint64_t key = p.hash() ^ (uint64_t(max_period) << 56);
+    const auto found = known.find(key);
+    if(found != known.end()) {
+      return found->second;
+    }
+    std::string code = classify_isolated(aut, p, max_period);
+    known.emplace(key, code);
+    return code;
+  }
+
+  static std::string classify_isolated(const AUT &aut, const Pattern &p, int max_period) {
+    Engine<AUT> iso(aut, std::max(p.w, p.h) + 2 * (max_period + 2));
+    const int oy = (iso.size - p.h) / 2, ox = (iso.size - p.w) / 2;
+    for(int y = 0; y < p.h; ++y) {
+      for(int x = 0; x < p.w; ++x) {
+        iso.set(oy + y, ox + x, p.cells[y * p.w + x]);
+      }
+    }
+    for(int t = 1; t <= max_period; ++t) {
+      iso.step();
+      if(iso.empty()) {
+        return "zz_vanishing";
+      }
+      int y0, x0;
+      const Pattern q = iso.crop(y0, x0);
+      if(q == p) {
+        // the same object in every phase gets the same code
+        uint64_t canonical = p.canonical_hash();
+        for(int i = 1; i < t; ++i) {
+          iso.step();
+          int py, px;
+          canonical = std::min(canonical, iso.crop(py, px).canonical_hash());
+        }
+        char code[64];
+        if(t == 1 && y0 == oy && x0 == ox) {
+          snprintf(code, sizeof(code), "xs%d_%016llx", p.population(), (unsigned long long)canonical);
+        } else if(y0 == oy && x0 == ox) {
+          snprintf(code, sizeof(code), "xp%d_%016llx", t, (unsigned long long)canonical);
+        } else {
+          snprintf(code, sizeof(code), "xq%d_%016llx", t, (unsigned long long)canonical);
+        }
+        return code;
+      }
+    }
+    return "zz_unclassified";
+  }
+
+  void census_soup(Engine<AUT> &engine, size_t index, Census &local, Memo &known, period::Detector &detector, std::vector<int> &stack) {
+    engine.clear();
+    const int offset = opts.margin;
+    for(int y = 0; y < opts.soup_size; ++y) {
+      for(int x = 0; x < opts.soup_size; ++x) {
+        // soups are keyed by their index, so any soup can be reproduced from (seed, index)
+        if(rng::get(opts.seed, uint32_t(index), y, x) & 1) {
+          engine.set(offset + y, offset + x, uint8_t(aut.no_states - 1));
+        }
+      }
+    }
+    const int size = engine.size, band = opts.band;
+    std::vector<std::pair<Pattern, std::array<int, 2>>> kept;
+    detector.reset(opts.max_period);
+    for(int gen = 1; gen <= opts.max_generations; ++gen) {
+      engine.step();
+      // spaceships reaching the band would crash into the border: classify them
+      // on their own and take them out. a spaceship crosses the band in no fewer
+      // than band generations, so looking every other generation is enough
+      const bool in_band = engine.y0 < band || engine.x0 < band || engine.y1 >= size - band || engine.x1 >= size - band;
+      if(in_band && gen % 2 == 0) {
+        kept.clear();
+        auto &&visit = [&](int y, int x) mutable -> void {
+          if(!engine.at(y, x)) {
+            return;
+          }
+          int py, px;
+          Pattern p = engine.extract_cluster(y, x, py, px, stack);
+          if(std::max(p.w, p.h) <= opts.max_leaving_size) {
+            const std::string code = classify(aut, p, opts.max_leaving_period, known);
+            // debris that dies out on its own is dropped without being counted
+            if(code == "zz_vanishing") {
+              return;
+            } else if(code.compare(0, 2, "xq") == 0) {
+              local.add(code);
+              return;
+            }
+          }
+          // debris still interacting with the soup stays where it is
+          kept.push_back({std::move(p), {py, px}});
+        };
+        for(int y = engine.y0; y <= engine.y1; ++y) {
+          if(y < band || y >= size - band) {
+            for(int x = engine.x0; x <= engine.x1; ++x) visit(y, x);
+          } else {
+            for(int x = engine.x0; x < band; ++x) visit(y, x);
+            for(int x = std::max(engine.x0, size - band); x <= engine.x1; ++x) visit(y, x);
+          }
+        }
+        for(const auto &[p, pos] : kept) {
+          engine.paste(p, pos[0], pos[1]);
+        }
+      }
+      if(detector.push(gen, engine.hash())) {
+        // the soup repeats: split what is left into objects
+        for(int y = engine.y0; y <= engine.y1; ++y) {
+          for(int x = engine.x0; x <= engine.x1; ++x) {
+            if(engine.at(y, x)) {
+              int py, px;
+              local.add(classify(aut, engine.extract_cluster(y, x, py, px, stack), opts.max_period, known));
+            }
+          }
+        }
+        return;
+      }
+    }
+    local.add("zz_unstable");
+  }
+
+  void run() {
+    const auto t0 = std::chrono::steady_clock::now();
+    std::atomic<size_t> done = 0;
+    auto last_report = t0;
+    #pragma omp parallel
+    {
+      Engine<AUT> engine(aut, opts.soup_size + 2 * opts.margin);
+      Census local;
+      period::Detector detector;
+      std::vector<int> stack;
+      Memo known;
+      // dynamic scheduling hands out small chunks as threads free up, since soups vary a lot in lifetime
+      #pragma omp for schedule(dynamic, 16)
+      for(size_t i = 0; i < opts.no_soups; ++i) {
+        census_soup(engine, i, local, known, detector, stack);
+        const size_t n = ++done;
+        if(sys::get_thread_num() == 0) {
+          const auto now = std::chrono::steady_clock::now();
+          if(now - last_report > std::chrono::seconds(2)) {
+            const double s = std::chrono::duration<double>(now - t0).count();
+            Logger::Info("soups %lu / %lu, %.0f soups/s\n", n, opts.no_soups, n / s);
+            last_report = now;
+          }
+        }
+      }
+      #pragma omp critical
+      census.merge(local);
+    }
+    no_soups_done = done;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  void report() const {
+    Logger::Info("%lu soups in %.2f s: %.0f soups/s on %d threads\n", no_soups_done, seconds, no_soups_done / seconds, sys::get_max_threads());
+    const auto entries = census.sorted();
+    for(size_t i = 0; i < entries.size() && i < 20; ++i) {
+      Logger::Info("  %-32s %lu\n", entries[i].first.c_str(), entries[i].second);
+    }
+    if(opts.census_path.empty()) {
+      return;
+    }
+    FILE *fp = fopen(opts.census_path.c_str(), "w");
+    if(fp == nullptr) {
+      Logger::Warning("unable to write census '%s'\n", opts.census_path.c_str());
+      return;
+    }
+    fprintf(fp, "# %s seed %u, %lu soups\n", aut.get_rule().str().c_str(), opts.seed, no_soups_done);
+    for(const auto &[code, n] : entries) {
+      fprintf(fp, "%s\t%lu\n", code.c_str(), n);
+    }
+    fclose(fp);
+  }
+};
+
+template <typename AUT>
+void run(const AUT &aut, const Options &opts) {
+  Logger::Info("soup search: %s, %lu soups of %dx%d, seed %u\n", aut.get_rule().str().c_str(), opts.no_soups, opts.soup_size, opts.soup_size, opts.seed);
+  Search<AUT> search(aut, opts);
+  search.run();
+  search.report();
+}
+
+} // namespace soup
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+
+namespace gl {
+
+// shader storage buffer for results written by compute shaders, or for state
+// they keep on the device
+struct StorageBuffer {
+  static void init(GLuint &ssbo, size_t size) {
+    glGenBuffers(1, &ssbo); GLERROR
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo); GLERROR
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_READ); GLERROR
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); GLERROR
+    zero(ssbo);
+  }
+
+  // filled from the host, for buffers the shaders then read and write in place
+  static void init(GLuint &ssbo, size_t size, const void *data) {
+    glGenBuffers(1, &ssbo); GLERROR
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo); GLERROR
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_COPY); GLERROR
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); GLERROR
+  }
+
+  static void bind_base(GLuint ssbo, GLuint binding) {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo); GLERROR
+  }
+
+  static void zero(GLuint ssbo) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo); GLERROR
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr); GLERROR
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); GLERROR
+  }
+
+  // blocks until the writes to this buffer have finished
+  template <typename T>
+  static void read(GLuint ssbo, T *data, size_t count) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo); GLERROR
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(T), data); GLERROR
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); GLERROR
+  }
+
+  static void clear(GLuint &ssbo) {
+    glDeleteBuffers(1, &ssbo); GLERROR
+    ssbo = 0;
+  }
+};
+
+} // namespace gl
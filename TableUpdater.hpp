@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <File.hpp>
+
+#include <ShaderProgram.hpp>
+#include <ShaderUniform.hpp>
+#include <Texture.hpp>
+#include <StorageBuffer.hpp>
+#include <Automaton.hpp>
+
+using namespace std::literals::string_literals;
+
+// rule tables on the gpu: the decision diagram of the table goes to an integer
+// texture once, and every cell walks it down from the root, see table.comp
+struct TableUpdater {
+  gl::Uniform<gl::UniformType::SAMPLER2D> uSrcTex, uDstTex, uTreeTex;
+  gl::Uniform<gl::UniformType::UINTEGER> uRoot, uAccessMode;
+  gl::Uniform<gl::UniformType::IVEC2> uSize;
+  gl::ShaderProgram<gl::ComputeShader> program;
+
+  using ShaderProgramCompute = decltype(program);
+
+  // must match table.comp
+  static constexpr int local_size = 8;
+  static constexpr int tree_width = 4096;
+  GLuint treetex = 0;
+  uint32_t root = 0;
+  glm::ivec2 size = glm::ivec2(0, 0);
+
+  explicit TableUpdater(const std::string &dir):
+    uSrcTex("srcTex"s), uDstTex("dstTex"s), uTreeTex("treeTex"s),
+    uRoot("root"s), uAccessMode("access_mode"s),
+    uSize("size"s),
+    program({std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("table.comp"s))})
+  {}
+
+  void init(int w, int h, const ruletable::Compiled &table) {
+    size = glm::ivec2(w, h);
+    root = table.root;
+    // rows of tree_width entries, the last one padded
+    const int rows = int((table.tree.size() + tree_width - 1) / tree_width);
+    std::vector<uint32_t> texels(size_t(rows) * tree_width, 0);
+    std::copy(table.tree.begin(), table.tree.end(), texels.begin());
+    gl::Texture<GL_TEXTURE_2D>::init(treetex);
+    gl::Texture<GL_TEXTURE_2D>::bind(treetex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4); GLERROR
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, tree_width, rows, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, texels.data()); GLERROR
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::param(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl::Texture<GL_TEXTURE_2D>::unbind();
+    // the neighbourhood is compiled in, so that the walk unrolls to its cells
+    program.set_defines("#define NEIGHBOURHOOD " + std::to_string(table.nb) + "\n"
+                        "#define NO_STATES " + std::to_string(table.no_states) + "\n");
+    ShaderProgramCompute::compile_program(program);
+    program.assign_uniforms(uSrcTex, uDstTex, uTreeTex, uRoot, uAccessMode, uSize);
+    Logger::Info("[table %s: %lu nodes, %lu KiB on the gpu]\n", table.name.c_str(), table.no_nodes, (texels.size() * sizeof(uint32_t)) >> 10);
+  }
+
+  void run(GLuint srctex, GLuint dsttex, GLuint hashbuf, int access_mode) {
+    ShaderProgramCompute::use(program);
+    uSrcTex.set_data(0);
+    uDstTex.set_data(1);
+    uTreeTex.set_data(2);
+    uRoot.set_data(root);
+    uAccessMode.set_data(access_mode);
+    uSize.set_data(size);
+    glBindImageTexture(0, srctex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8UI); GLERROR
+    glBindImageTexture(1, dsttex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI); GLERROR
+    glBindImageTexture(2, treetex, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI); GLERROR
+    gl::StorageBuffer::bind_base(hashbuf, 0);
+    ShaderProgramCompute::dispatch((size.x + local_size - 1) / local_size, (size.y + local_size - 1) / local_size, 1);
+    ShaderProgramCompute::barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    ShaderProgramCompute::unuse();
+  }
+
+  bool is_active() const {
+    return treetex != 0;
+  }
+
+  void clear() {
+    if(!is_active()) {
+      return;
+    }
+    gl::Texture<GL_TEXTURE_2D>::clear(treetex);
+    treetex = 0;
+    ShaderProgramCompute::clear(program);
+    ShaderProgramCompute::unassign_uniforms(uSrcTex, uDstTex, uTreeTex, uRoot, uAccessMode, uSize);
+  }
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace sys {
+
+inline int get_thread_num() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+inline int get_max_threads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+} // namespace sys
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <bit>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <RuleString.hpp>
+#include <Random.hpp>
+
+// three-dimensional outer-totalistic automata over the 26 neighbours of a cell.
+// two-state rules are stepped 64 cells at a time on words of one bit per cell,
+// by adding the bit planes of the counts with logic operations (see
+// Renderer<..., VOLUME, ...> and shaders/volume.comp, which does the same on
+// 32-bit words); more states take a byte per cell
+namespace volume {
+
+struct Totalistic {
+  using self_t = Totalistic;
+  static constexpr int outside_state = 0;
+  static constexpr int dim = 3;
+  static constexpr int update_mode = ::update_mode::ALL;
+
+  ca::VolumeSpec spec;
+  int no_states;
+  const int DEAD, LIVE;
+
+  explicit Totalistic(const ca::VolumeSpec &spec):
+    spec(spec), no_states(spec.no_states),
+    DEAD(0), LIVE(no_states - 1)
+  {}
+
+  ca::VolumeSpec get_volume() const {
+    return spec;
+  }
+
+  // a soup of half live cells
+  uint8_t init_state(int z, int y, int x) const {
+    return (rng::get(rng::get_seed(), uint32_t(z), y, x) & 1) ? LIVE : DEAD;
+  }
+
+  inline uint8_t transition(int state, int count) const {
+    if(state == DEAD) {
+      return ((spec.birth >> count) & 1) ? LIVE : DEAD;
+    } else if(state == LIVE) {
+      return ((spec.survival >> count) & 1) ? LIVE : LIVE - 1;
+    }
+    return state - 1;
+  }
+};
+
+// bit-sliced counting: a count over many cells is kept in planes, plane b holding
+// bit b of the count of every cell of the word
+
+inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t &sum, uint64_t &carry) {
+  const uint64_t t = a ^ b;
+  sum = t ^ c;
+  carry = (a & b) | (t & c);
+}
+
+// the live cells of 9 words of a column of the box, 0..9 in 4 planes
+inline void column_sum(const uint64_t a[9], uint64_t planes[4]) {
+  uint64_t s1, c1, s2, c2, s3, c3, t, u, v;
+  full_add(a[0], a[1], a[2], s1, c1);
+  full_add(a[3], a[4], a[5], s2, c2);
+  full_add(a[6], a[7], a[8], s3, c3);
+  // weight 1
+  full_add(s1, s2, s3, planes[0], t);
+  // weight 2, carrying into weight 4
+  full_add(c1, c2, c3, u, v);
+  planes[1] = t ^ u;
+  const uint64_t k = t & u;
+  planes[2] = v ^ k;
+  planes[3] = v & k;
+}
+
+// the sums of the columns left, at and right of every cell, 0..27 in 5 planes:
+// cur holds the column sums of the word, prev and next those of the words either
+// side, whose edge bits shift in
+inline void box_sum(const uint64_t prev[4], const uint64_t cur[4], const uint64_t next[4], uint64_t sums[5]) {
+  uint64_t s[4], k[4];
+  for(int b = 0; b < 4; ++b) {
+    const uint64_t left = (cur[b] << 1) | (prev[b] >> 63), right = (cur[b] >> 1) | (next[b] << 63);
+    full_add(left, cur[b], right, s[b], k[b]);
+  }
+  // s + 2 k
+  uint64_t c;
+  sums[0] = s[0];
+  sums[1] = s[1] ^ k[0], c = s[1] & k[0];
+  full_add(s[2], k[1], c, sums[2], c);
+  full_add(s[3], k[2], c, sums[3], c);
+  sums[4] = k[3] ^ c;
+}
+
+// the cells whose sum equals count
+inline uint64_t equals(const uint64_t sums[5], int count) {
+  uint64_t eq = ~uint64_t(0);
+  for(int b = 0; b < 5; ++b) {
+    eq &= ((count >> b) & 1) ? sums[b] : ~sums[b];
+  }
+  return eq;
+}
+
+// the named rules, for the menu and --rule.
+// https://softologyblog.wordpress.com/2019/12/28/3d-cellular-automata-3/
+struct RuleEntry {
+  const char *name;
+  const char *rulestring;
+
+  ca::VolumeSpec rule() const {
+    return ca::parse_registry_rule(name, rulestring, ca::parse_volume_rulestring);
+  }
+};
+
+const std::vector<RuleEntry> registry = {
+  { "445"        , "4/4/5/M"               },
+  { "4555"       , "4-5/5/2/M"             },
+  { "5766"       , "5-7/6/2/M"             },
+  { "Clouds"     , "13-26/13-14,17-19/2/M" },
+  { "Amoeba 3D"  , "9-26/5-7,12-13,15/5/M" },
+  { "Pyroclastic", "4-7/6-8/10/M"          },
+  { "Builder"    , "2,6,9/4,6,8-9/10/M"    },
+};
+
+inline int find_rule(const std::string &name) {
+  auto &&simplify = [](const std::string &s) -> std::string {
+    std::string t;
+    for(char c : s) {
+      if(isalnum((unsigned char)c))t += char(tolower((unsigned char)c));
+    }
+    return t;
+  };
+  const std::string key = simplify(name);
+  for(size_t i = 0; i < registry.size(); ++i) {
+    if(simplify(registry[i].name) == key) {
+      return int(i);
+    }
+  }
+  return -1;
+}
+
+// a registry name, S/B/C/M notation or four digits of bays' notation
+inline bool is_volume(const std::string &name_or_rulestring) {
+  if(find_rule(name_or_rulestring) != -1) {
+    return true;
+  }
+  std::string s;
+  for(char c : name_or_rulestring) {
+    if(!isspace((unsigned char)c))s += char(toupper((unsigned char)c));
+  }
+  if(s.length() == 4 && s.find_first_not_of("0123456789") == std::string::npos) {
+    return true;
+  }
+  return s.length() >= 2 && s[s.length() - 2] == '/' && (s.back() == 'M' || s.back() == 'N');
+}
+
+inline bool resolve_rule(const std::string &name_or_rulestring, ca::VolumeSpec &rule, std::string &error) {
+  const int index = find_rule(name_or_rulestring);
+  if(index != -1) {
+    rule = registry[index].rule();
+    return true;
+  }
+  return ca::parse_volume_rulestring(name_or_rulestring, rule, error);
+}
+
+} // namespace volume
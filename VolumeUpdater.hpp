@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <algorithm>
+
+#include <incgraphics.h>
+
+#include <Logger.hpp>
+#include <Debug.hpp>
+#include <File.hpp>
+
+#include <ShaderProgram.hpp>
+#include <ShaderUniform.hpp>
+#include <StorageBuffer.hpp>
+#include <RuleString.hpp>
+
+using namespace std::literals::string_literals;
+
+// two-state volumes on the gpu: the bits of the cells stay in a pair of storage
+// buffers, a pass steps a word per invocation over a 3d dispatch, and another
+// draws a slice or the projection into the display texture, see volume.comp
+struct VolumeUpdater {
+  gl::Uniform<gl::UniformType::SAMPLER2D> uViewTex;
+  gl::Uniform<gl::UniformType::UINTEGER> uPass, uBirth, uSurvival, uAccessMode, uView;
+  gl::Uniform<gl::UniformType::INTEGER> uSlice;
+  gl::Uniform<gl::UniformType::IVEC3> uSize;
+  gl::ShaderProgram<gl::ComputeShader> program;
+
+  using ShaderProgramCompute = decltype(program);
+
+  // must match the layout of volume.comp
+  static constexpr int local_x = 8, local_y = 4, local_z = 2;
+  static constexpr int word_bits = 32;
+  GLuint words[2] = {0, 0};
+  GLuint statsbuf = 0;
+  int current = 0;
+  glm::ivec3 size = glm::ivec3(0, 0, 0);
+
+  // as read back by read_stats
+  struct Stats {
+    uint32_t hash_lo, hash_hi, population;
+  };
+
+  explicit VolumeUpdater(const std::string &dir):
+    uViewTex("viewTex"s),
+    uPass("pass"s), uBirth("birth"s), uSurvival("survival"s), uAccessMode("access_mode"s), uView("view"s),
+    uSlice("slice"s), uSize("size"s),
+    program({std::string(sys::Path(dir) / sys::Path("shaders"s) / sys::Path("volume.comp"s))})
+  {}
+
+  // cells: w / 32 words per row, in the layout of the packed host storage
+  void init(glm::ivec3 size_, const void *cells) {
+    size = size_;
+    const size_t bytes = size_t(size.x / word_bits) * size.y * size.z * sizeof(uint32_t);
+    gl::StorageBuffer::init(words[0], bytes, cells);
+    gl::StorageBuffer::init(words[1], bytes, nullptr);
+    gl::StorageBuffer::init(statsbuf, sizeof(Stats));
+    current = 0;
+    ShaderProgramCompute::compile_program(program);
+    program.assign_uniforms(uViewTex, uPass, uBirth, uSurvival, uAccessMode, uView, uSlice, uSize);
+    Logger::Info("[volume on the gpu: %lu MiB]\n", (2 * bytes) >> 20);
+  }
+
+  void bind() {
+    ShaderProgramCompute::use(program);
+    gl::StorageBuffer::bind_base(words[current], 0);
+    gl::StorageBuffer::bind_base(words[1 - current], 1);
+    gl::StorageBuffer::bind_base(statsbuf, 2);
+    uSize.set_data(size);
+  }
+
+  void run(const ca::VolumeSpec &spec, int access_mode) {
+    gl::StorageBuffer::zero(statsbuf);
+    bind();
+    uPass.set_data(0);
+    uBirth.set_data(spec.birth);
+    uSurvival.set_data(spec.survival << 1);
+    uAccessMode.set_data(access_mode);
+    const int nw = size.x / word_bits;
+    ShaderProgramCompute::dispatch((nw + local_x - 1) / local_x, (size.y + local_y - 1) / local_y, (size.z + local_z - 1) / local_z);
+    ShaderProgramCompute::barrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    ShaderProgramCompute::unuse();
+    current = 1 - current;
+  }
+
+  // blocks until the last run has finished
+  Stats read_stats() {
+    Stats stats;
+    gl::StorageBuffer::read(statsbuf, &stats, 1);
+    return stats;
+  }
+
+  void draw(GLuint viewtex, int view, int slice) {
+    bind();
+    uViewTex.set_data(0);
+    uPass.set_data(1);
+    uView.set_data(view);
+    uSlice.set_data(slice);
+    glBindImageTexture(0, viewtex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI); GLERROR
+    const int nw = size.x / word_bits;
+    ShaderProgramCompute::dispatch((nw + local_x - 1) / local_x, (size.y + local_y - 1) / local_y, 1);
+    ShaderProgramCompute::barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    ShaderProgramCompute::unuse();
+  }
+
+  bool is_active() const {
+    return statsbuf != 0;
+  }
+
+  void clear() {
+    if(!is_active()) {
+      return;
+    }
+    gl::StorageBuffer::clear(words[0]);
+    gl::StorageBuffer::clear(words[1]);
+    gl::StorageBuffer::clear(statsbuf);
+    ShaderProgramCompute::clear(program);
+    ShaderProgramCompute::unassign_uniforms(uViewTex, uPass, uBirth, uSurvival, uAccessMode, uView, uSlice, uSize);
+  }
+};
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <vector>
 
 #include <incgraphics.h>
 
 #include <Logger.hpp>
 #include <Debug.hpp>
+#include <Profiler.hpp>
 
 
 GLFWwindow *g_window = nullptr;
@@ -37,9 +39,11 @@ protected:
     return (g_window != NULL);
   }
 
-  void init_glfw() {
+  void init_glfw(bool visible) {
     int rc = glfwInit();
     ASSERT(rc == 1);
+    // headless runs still need a context for the renderers
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
     vidmode = glfwGetVideoMode(glfwGetPrimaryMonitor());
     ASSERT(vidmode != nullptr);
@@ -91,16 +95,22 @@ public:
   inline size_t width() const { return width_; }
   inline size_t height() const { return height_; }
   bool esc_triggered = false;
+  // presses and repeats of other keys, for the running app to drain
+  std::vector<int> keys;
   void keyboard_event(int key, int scancode, int action, int mods) {
     if(action == GLFW_PRESS) {
       if(key == GLFW_KEY_ESCAPE && !esc_triggered) {
         Logger::Info("registered escape press\n");
         esc_triggered = true;
+        return;
       }
     }
+    if(action == GLFW_PRESS || action == GLFW_REPEAT) {
+      keys.push_back(key);
+    }
   }
-  void init() {
-    init_glfw();
+  void init(bool visible=true) {
+    init_glfw(visible);
     init_controls();
     /* glDebugMessageCallbackARB(&debug_callback, nullptr); GLERROR */
   }
@@ -112,12 +122,15 @@ public:
   template <typename SF, typename DF, typename CF>
   bool run(SF &&setupfunc, DF &&dispfunc, CF &&cleanupfunc) {
     setupfunc(*this);
+    keys.clear();
     glfwSwapInterval(1); GLERROR
     bool shouldClose = false;
     while(!glfwWindowShouldClose(window) && !shouldClose && !esc_triggered) {
+      prof::ScopedTimer frame_timer(prof::FRAME);
       g_current_window = this;
       shouldClose = !dispfunc(*this);
       glfwPollEvents(); GLERROR
+      prof::ScopedTimer swap_timer(prof::SWAP);
       glfwSwapBuffers(window); GLERROR
     }
     bool ret = !esc_triggered;
@@ -125,6 +138,15 @@ public:
     cleanupfunc(*this);
     return ret;
   }
+  // no presentation and no vsync: step until it returns false
+  template <typename SF, typename DF, typename CF>
+  void run_headless(SF &&setupfunc, DF &&stepfunc, CF &&cleanupfunc) {
+    setupfunc(*this);
+    g_current_window = this;
+    while(stepfunc(*this))
+      ;
+    cleanupfunc(*this);
+  }
   void quit() {
     g_current_window = nullptr;
     glfwDestroyWindow(window); GLERROR
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+#include <glm/glm.hpp>
+
+#include <Logger.hpp>
+#include <File.hpp>
+#include <Query.hpp>
+
+// work group layout of the grid compute shaders:
+// LOCAL_SIZE x LOCAL_SIZE invocations per group, each updating a block of cells
+struct WorkGroupConfig {
+  int local_size = 8;
+  glm::ivec2 cells_per_invocation = glm::ivec2(1, 1);
+
+  std::string defines() const {
+    return "#define LOCAL_SIZE " + std::to_string(local_size) + "\n";
+  }
+};
+
+// picks the fastest configuration by timing real dispatches with GL timer queries.
+// results are cached per driver and grid size; delete the cache file to re-tune
+struct WorkGroupTuner {
+  static constexpr int no_warmup = 2;
+  static constexpr int no_timed = 8;
+
+  static std::string cache_path() {
+    return std::string(sys::Path(sys::get_cache_directory()) / sys::Path(std::string("workgroups.cache")));
+  }
+
+  static std::string make_key(const std::string &gl_identity, int w, int h) {
+    return gl_identity + " | " + std::to_string(w) + "x" + std::to_string(h);
+  }
+
+  static bool load(const std::string &key, WorkGroupConfig &config) {
+    std::ifstream in(cache_path());
+    std::string line;
+    while(std::getline(in, line)) {
+      const size_t tab = line.rfind('\t');
+      if(tab == std::string::npos || line.substr(0, tab) != key) {
+        continue;
+      }
+      std::istringstream fields(line.substr(tab + 1));
+      WorkGroupConfig c;
+      if(fields >> c.local_size >> c.cells_per_invocation.x >> c.cells_per_invocation.y) {
+        config = c;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void store(const std::string &key, const WorkGroupConfig &config) {
+    FILE *fp = fopen(cache_path().c_str(), "a");
+    if(fp == nullptr) {
+      Logger::Warning("unable to write '%s'\n", cache_path().c_str());
+      return;
+    }
+    fprintf(fp, "%s\t%d %d %d\n", key.c_str(), config.local_size, config.cells_per_invocation.x, config.cells_per_invocation.y);
+    fclose(fp);
+  }
+
+  static std::vector<WorkGroupConfig> candidates(glm::ivec2 size, int max_wg_invocations, glm::ivec2 max_wg_count) {
+    std::vector<WorkGroupConfig> configs;
+    for(int local_size : {4, 8, 16, 32}) {
+      if(local_size * local_size > max_wg_invocations) {
+        continue;
+      }
+      for(int cells : {1, 2, 4}) {
+        WorkGroupConfig c;
+        c.local_size = local_size;
+        c.cells_per_invocation = glm::ivec2(cells, cells);
+        const glm::ivec2 per_group = c.cells_per_invocation * local_size;
+        const glm::ivec2 wg_size = (size + per_group - 1) / per_group;
+        if(wg_size.x > max_wg_count.x || wg_size.y > max_wg_count.y) {
+          continue;
+        }
+        configs.push_back(c);
+      }
+    }
+    return configs;
+  }
+
+  // prepare(config) compiles and binds, dispatch() runs one step, release() frees the program
+  template <typename PF, typename DF, typename RF>
+  static WorkGroupConfig tune(const std::vector<WorkGroupConfig> &configs, PF &&prepare, DF &&dispatch, RF &&release) {
+    ASSERT(!configs.empty());
+    GLuint query = 0;
+    gl::TimerQuery::init(query);
+    WorkGroupConfig best = configs.front();
+    double best_ms = -1.;
+    for(const WorkGroupConfig &c : configs) {
+      prepare(c);
+      for(int i = 0; i < no_warmup; ++i) {
+        dispatch();
+      }
+      gl::TimerQuery::begin(query);
+      for(int i = 0; i < no_timed; ++i) {
+        dispatch();
+      }
+      gl::TimerQuery::end();
+      const double ms = gl::TimerQuery::get_result(query) * 1e-6 / no_timed;
+      release();
+      Logger::Info("[wg tune] local %2d cells %dx%d: %.4f ms\n", c.local_size, c.cells_per_invocation.x, c.cells_per_invocation.y, ms);
+      if(best_ms < 0 || ms < best_ms) {
+        best = c, best_ms = ms;
+      }
+    }
+    gl::TimerQuery::clear(query);
+    Logger::Info("[wg tune] picked local %d cells %dx%d (%.4f ms)\n", best.local_size, best.cells_per_invocation.x, best.cells_per_invocation.y, best_ms);
+    return best;
+  }
+};
@@ -1,7 +1,9 @@
 #include <cstdint>
 #include <cctype>
+#include <algorithm>
 
 #include <string>
+#include <fstream>
 
 #include <Logger.hpp>
 #include <Debug.hpp>
@@ -10,31 +12,312 @@
 #include <Window.hpp>
 #include <InterfaceApp.hpp>
 #include <AutomatonApp.hpp>
+#include <SoupSearch.hpp>
+#include <Numa.hpp>
+#include <Distributed.hpp>
 
 using namespace std::literals::string_literals;
 
 
+void parse_args(int argc, char *argv[], AutOptions &opts) {
+  for(int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = (i + 1 < argc);
+    if(arg == "--headless") {
+      opts.headless = true;
+    } else if(arg == "--generations" && has_value) {
+      opts.generations = std::stoul(argv[++i]);
+    } else if(arg == "--export" && has_value) {
+      opts.export_path = argv[++i];
+    } else if(arg == "--export-every" && has_value) {
+      opts.export_every = std::stoi(argv[++i]);
+    } else if(arg == "--export-queue" && has_value) {
+      opts.export_queue = std::stoi(argv[++i]);
+    } else if(arg == "--temporal-block" && has_value) {
+      opts.temporal_block = std::max(1, std::stoi(argv[++i]));
+    } else if(arg == "--history" && has_value) {
+      opts.history_mb = std::stoul(argv[++i]);
+    } else if(arg == "--sparse") {
+      opts.sparse = true;
+    } else if(arg == "--stats") {
+      opts.show_stats = true;
+    } else if(arg == "--trace" && has_value) {
+      opts.trace_path = argv[++i];
+    } else if(arg == "--seed" && has_value) {
+      opts.has_seed = true;
+      opts.seed = std::stoul(argv[++i]);
+    } else if(arg == "--max-period" && has_value) {
+      opts.max_period = std::stoi(argv[++i]);
+    } else if(arg == "--stop-periodic") {
+      opts.stop_periodic = true;
+    } else if(arg == "--population" && has_value) {
+      opts.population_path = argv[++i];
+    } else if(arg == "--rule" && has_value) {
+      opts.rules.push_back(argv[++i]);
+    } else if(arg == "--rules" && has_value) {
+      // one rule per line, '#' starts a comment
+      std::ifstream file(argv[++i]);
+      if(!file) {
+        Logger::Warning("unable to open rules file '%s'\n", argv[i]);
+      }
+      std::string line;
+      while(std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        if(line.find_first_not_of(" \t\r") != std::string::npos) {
+          opts.rules.push_back(line);
+        }
+      }
+    } else if(arg == "--soups" && has_value) {
+      opts.no_soups = std::stoul(argv[++i]);
+    } else if(arg == "--census" && has_value) {
+      opts.census_path = argv[++i];
+    } else if(arg == "--ranks" && has_value) {
+      opts.no_ranks = std::stoi(argv[++i]);
+    } else if(arg == "--rank" && has_value) {
+      opts.rank = std::stoi(argv[++i]);
+    } else if(arg == "--transport" && has_value) {
+      opts.transport = argv[++i];
+    } else if(arg == "--board" && has_value) {
+      const std::string size = argv[++i];
+      opts.board_w = std::stoi(size);
+      opts.board_h = std::stoi(size.substr(size.find('x') + 1));
+    } else if(arg == "--volume" && has_value) {
+      // N for a cube, or WxHxD
+      const std::string size = argv[++i];
+      const size_t x1 = size.find('x'), x2 = (x1 == std::string::npos) ? x1 : size.find('x', x1 + 1);
+      opts.volume_w = opts.volume_h = opts.volume_d = std::stoi(size);
+      if(x2 != std::string::npos) {
+        opts.volume_h = std::stoi(size.substr(x1 + 1));
+        opts.volume_d = std::stoi(size.substr(x2 + 1));
+      }
+    } else if(arg == "--list-rules") {
+      for(const cellular::RuleEntry &entry : cellular::registry) {
+        if(entry.kind == cellular::rule_kind::GENERATIONS || entry.kind == cellular::rule_kind::LARGERTHANLIFE) {
+          printf("%-16s %s\n", entry.name, entry.rulestring);
+        }
+      }
+      for(const char *name : continuous::rule_names) {
+        printf("%-16s continuous\n", name);
+      }
+      for(const volume::RuleEntry &entry : volume::registry) {
+        printf("%-16s %s\n", entry.name, entry.rulestring);
+      }
+      for(const ruletable::RuleEntry &entry : ruletable::registry) {
+        printf("%-16s table\n", entry.name);
+      }
+      for(const margolus::RuleEntry &entry : margolus::registry) {
+        printf("%-16s %s\n", entry.name, (entry.rulestring != nullptr) ? entry.rulestring : "generated");
+      }
+      exit(EXIT_SUCCESS);
+    } else {
+      Logger::Warning("unknown argument '%s'\n", arg.c_str());
+    }
+  }
+}
+
+void run_rule(AutomatonApp &app, const ca::RuleSpec &rule, const AutOptions &opts) {
+  cellular::visit_rule(rule, [&](auto &&aut) mutable -> void {
+    app.run(std::move(aut), opts);
+  });
+}
+
+void run_cellular(AutomatonApp &app, const cellular::RuleEntry &entry, const AutOptions &opts) {
+  switch(entry.kind) {
+    case cellular::rule_kind::GENERATIONS: run_rule(app, entry.rule(), opts); break;
+    case cellular::rule_kind::LANGTONSANT: app.run(cellular::LangtonsAnt(), opts); break;
+    case cellular::rule_kind::WIREWORLD:   app.run(cellular::Wireworld(),   opts); break;
+    case cellular::rule_kind::LARGERTHANLIFE: app.run(cellular::LargerThanLife(entry.ltl()), opts); break;
+  }
+}
+
+// a larger than life name or rulestring; false if it does not resolve
+bool run_ltl(AutomatonApp &app, const std::string &name, const AutOptions &opts) {
+  ca::LtlSpec rule;
+  std::string error;
+  if(!cellular::resolve_ltl(name, rule, error)) {
+    Logger::Warning("rule '%s': %s\n", name.c_str(), error.c_str());
+    return false;
+  }
+  Logger::Info("rule '%s': %s\n", name.c_str(), rule.str().c_str());
+  app.run(cellular::LargerThanLife(rule), opts);
+  return true;
+}
+
+void run_continuous(AutomatonApp &app, int kind, const AutOptions &opts) {
+  continuous::visit_rule(kind, [&](auto &&aut) mutable -> void {
+    app.run(std::move(aut), opts);
+  });
+}
+
+// a three-dimensional name or rulestring; false if it does not resolve
+bool run_volume(AutomatonApp &app, const std::string &name, const AutOptions &opts) {
+  ca::VolumeSpec rule;
+  std::string error;
+  if(!volume::resolve_rule(name, rule, error)) {
+    Logger::Warning("rule '%s': %s\n", name.c_str(), error.c_str());
+    return false;
+  }
+  Logger::Info("rule '%s': %s\n", name.c_str(), rule.str().c_str());
+  app.run(volume::Totalistic(rule), opts);
+  return true;
+}
+
+// a rule table by name or the path of its file; false if it does not compile
+bool run_table(AutomatonApp &app, const std::string &name, const AutOptions &opts) {
+  ruletable::Compiled table;
+  std::string error;
+  if(!ruletable::resolve_rule(name, table, error)) {
+    Logger::Warning("rule '%s': %s\n", name.c_str(), error.c_str());
+    return false;
+  }
+  Logger::Info("rule '%s': %s table of %d states, %lu nodes%s\n", name.c_str(), ruletable::neighbourhood_names[table.nb],
+               table.no_states, table.no_nodes, table.lut.empty() ? "" : ", flattened");
+  app.run(ruletable::Rule(table), opts);
+  return true;
+}
+
+// a margolus name or rulestring; false if it does not resolve
+bool run_block(AutomatonApp &app, const std::string &name, const AutOptions &opts) {
+  ca::BlockSpec rule;
+  std::string error;
+  if(!margolus::resolve_rule(name, rule, error)) {
+    Logger::Warning("rule '%s': %s\n", name.c_str(), error.c_str());
+    return false;
+  }
+  Logger::Info("rule '%s': %s\n", name.c_str(), rule.str().c_str());
+  app.run(margolus::Rule(rule), opts);
+  return true;
+}
+
+// runs every rule given on the command line, e.g. for a headless sweep
+void run_rules(Window &w, const std::string &dir, const AutOptions &opts) {
+  for(const std::string &name : opts.rules) {
+    if(continuous::find_rule(name) >= 0) {
+      AutomatonApp app(w, dir);
+      run_continuous(app, continuous::find_rule(name), opts);
+      continue;
+    } else if(volume::is_volume(name)) {
+      AutomatonApp app(w, dir);
+      run_volume(app, name, opts);
+      continue;
+    } else if(margolus::is_block_rule(name)) {
+      AutomatonApp app(w, dir);
+      run_block(app, name, opts);
+      continue;
+    } else if(ruletable::is_table(name)) {
+      AutomatonApp app(w, dir);
+      run_table(app, name, opts);
+      continue;
+    } else if(cellular::is_ltl(name)) {
+      AutomatonApp app(w, dir);
+      run_ltl(app, name, opts);
+      continue;
+    }
+    ca::RuleSpec rule;
+    std::string error;
+    if(!cellular::resolve_rule(name, rule, error)) {
+      Logger::Warning("skipping rule '%s': %s\n", name.c_str(), error.c_str());
+      continue;
+    }
+    Logger::Info("rule '%s': %s\n", name.c_str(), rule.str().c_str());
+    AutomatonApp app(w, dir);
+    run_rule(app, rule, opts);
+  }
+}
+
+// soup search on the first rule given, or life; runs on the cpu without a window
+void run_soups(const AutOptions &opts) {
+  const std::string name = opts.rules.empty() ? "B3/S23" : opts.rules.front();
+  ca::RuleSpec rule;
+  std::string error;
+  if(!cellular::resolve_rule(name, rule, error)) {
+    Logger::Warning("rule '%s': %s\n", name.c_str(), error.c_str());
+    return;
+  }
+  soup::Options sopts;
+  sopts.no_soups = opts.no_soups;
+  sopts.seed = rng::get_seed();
+  sopts.census_path = opts.census_path;
+  cellular::visit_rule(rule, [&](auto &&aut) mutable -> void {
+    soup::run(aut, sopts);
+  });
+}
+
+// board split into strips over several processes, without a window
+void run_distributed(int argc, char *argv[], const AutOptions &opts) {
+  const std::string name = opts.rules.empty() ? "B3/S23" : opts.rules.front();
+  ca::RuleSpec rule;
+  std::string error;
+  if(!cellular::resolve_rule(name, rule, error)) {
+    Logger::Warning("rule '%s': %s\n", name.c_str(), error.c_str());
+    return;
+  }
+  dist::Options dopts;
+  dopts.no_ranks = opts.no_ranks;
+  dopts.rank = opts.rank;
+  dopts.transport = opts.transport;
+  dopts.w = opts.board_w, dopts.h = opts.board_h;
+  dopts.generations = opts.generations;
+  dopts.max_period = opts.stop_periodic ? opts.max_period : 0;
+  dopts.args.assign(argv, argv + argc);
+  cellular::visit_rule(rule, [&](auto &&aut) mutable -> void {
+    dist::run(aut, dopts);
+  });
+}
+
+// ranks started by another process log to their own file
+std::string get_log_path(int argc, char *argv[]) {
+  for(int i = 1; i + 1 < argc; ++i) {
+    if(argv[i] == "--rank"s && argv[i + 1] != "0"s) {
+      return "app.rank"s + argv[i + 1] + ".log"s;
+    }
+  }
+  return "app.log";
+}
+
 int main(int argc, char *argv[]) {
-  srand(time(NULL));
-  Logger::Setup("app.log");
+  Logger::Setup(get_log_path(argc, argv).c_str());
   /* Logger::MirrorLog(stderr); */
 
+  AutOptions cli_opts;
+  parse_args(argc, argv, cli_opts);
+  rng::set_seed(cli_opts.has_seed ? cli_opts.seed : rng::hash(uint32_t(time(NULL))));
+  Logger::Info("seed %u\n", rng::get_seed());
+  if(cli_opts.no_ranks > 0) {
+    // several ranks may share a machine, so threads are left to OMP_PROC_BIND
+    run_distributed(argc, argv, cli_opts);
+    Logger::Close();
+    return EXIT_SUCCESS;
+  }
+  sys::pin_threads();
+  if(cli_opts.no_soups > 0) {
+    run_soups(cli_opts);
+    Logger::Close();
+    return EXIT_SUCCESS;
+  }
+
   Window w;
-  w.init();
+  w.init(!cli_opts.headless);
 
   const std::string cwd = sys::get_cwd();
   Logger::Info("cwd: '%s'\n", cwd.c_str());
   const std::string dir = sys::get_executable_directory(argc, argv);
   Logger::Info("dir '%s'\n", dir.c_str());
 
-  bool shouldQuit = false;
+  bool shouldQuit = !cli_opts.rules.empty();
+  if(shouldQuit) {
+    run_rules(w, dir, cli_opts);
+  }
   while(!shouldQuit) {
     InterfaceApp iface(w, dir);
-    iface.run();
-    AutOptions opts = (AutOptions){
-      .factor=iface.factor,
-      .force_cpu=bool(iface.force_cpu),
-    };
+    if(!cli_opts.headless) {
+      iface.run();
+    }
+    AutOptions opts = cli_opts;
+    opts.factor = iface.factor;
+    opts.force_cpu = bool(iface.force_cpu);
+    opts.sparse = cli_opts.sparse || bool(iface.sparse);
+    opts.show_stats = cli_opts.show_stats || bool(iface.show_stats);
     shouldQuit = iface.shouldQuit;
     if(shouldQuit) {
       break;
@@ -53,86 +336,21 @@ int main(int argc, char *argv[]) {
       }
       break;
       case InterfaceApp::AutomataType::CELLULAR:
-      switch(iface.autOption) {
-        // 2 states
-        case InterfaceApp::Cellular::REPLICATOR:      app.run(cellular::Replicator()     ,opts);break;
-        case InterfaceApp::Cellular::FREDKIN:         app.run(cellular::Fredkin()        ,opts);break;
-        case InterfaceApp::Cellular::SEEDS:           app.run(cellular::Seeds()          ,opts);break;
-        case InterfaceApp::Cellular::LIVEORDIE:       app.run(cellular::LiveOrDie()      ,opts);break;
-        case InterfaceApp::Cellular::FLOCK:           app.run(cellular::Flock()          ,opts);break;
-        case InterfaceApp::Cellular::MAZECTRIC:       app.run(cellular::Mazectric()      ,opts);break;
-        case InterfaceApp::Cellular::MAZE:            app.run(cellular::Maze()           ,opts);break;
-        case InterfaceApp::Cellular::MAZECTRICMICE:   app.run(cellular::MazectricMice()  ,opts);break;
-        case InterfaceApp::Cellular::MAZEMICE:        app.run(cellular::MazeMice()       ,opts);break;
-        case InterfaceApp::Cellular::GAMEOFLIFE:      app.run(cellular::GameOfLife()     ,opts);break;
-        case InterfaceApp::Cellular::EIGHTLIFE:       app.run(cellular::EightLife()      ,opts);break;
-        case InterfaceApp::Cellular::LONGLIFE:        app.run(cellular::LongLife()       ,opts);break;
-        case InterfaceApp::Cellular::TXT:             app.run(cellular::TxT()            ,opts);break;
-        case InterfaceApp::Cellular::HIGHLIFE:        app.run(cellular::HighLife()       ,opts);break;
-        case InterfaceApp::Cellular::MOVE:            app.run(cellular::Move()           ,opts);break;
-        case InterfaceApp::Cellular::STAINS:          app.run(cellular::Stains()         ,opts);break;
-        case InterfaceApp::Cellular::DAYANDNIGHT:     app.run(cellular::DayAndNight()    ,opts);break;
-        case InterfaceApp::Cellular::ANNEAL:          app.run(cellular::Anneal()         ,opts);break;
-        case InterfaceApp::Cellular::DRYLIFE:         app.run(cellular::DryLife()        ,opts);break;
-        case InterfaceApp::Cellular::PEDESTRLIFE:     app.run(cellular::PedestrLife()    ,opts);break;
-        case InterfaceApp::Cellular::AMOEBA:          app.run(cellular::Amoeba()         ,opts);break;
-        case InterfaceApp::Cellular::DIAMOEBA:        app.run(cellular::Diamoeba()       ,opts);break;
-        case InterfaceApp::Cellular::LANGTONSANT:     app.run(cellular::LangtonsAnt()    ,opts);break;
-        // 3 states
-        case InterfaceApp::Cellular::BRIANSBRAIN:     app.run(cellular::BriansBrain()    ,opts);break;
-        case InterfaceApp::Cellular::BRAIN6:          app.run(cellular::Brain6()         ,opts);break;
-        case InterfaceApp::Cellular::FROGS:           app.run(cellular::Frogs()          ,opts);break;
-        case InterfaceApp::Cellular::LINES:           app.run(cellular::Lines()          ,opts);break;
-        // 4 states
-        case InterfaceApp::Cellular::CATERPILLARS:    app.run(cellular::Caterpillars()   ,opts);break;
-        case InterfaceApp::Cellular::ORTHOGO:         app.run(cellular::OrthoGo()        ,opts);break;
-        case InterfaceApp::Cellular::SEDIMENTAL:      app.run(cellular::SediMental()     ,opts);break;
-        case InterfaceApp::Cellular::STARWARS:        app.run(cellular::StarWars()       ,opts);break;
-        case InterfaceApp::Cellular::WIREWORLD:       app.run(cellular::Wireworld()      ,opts);break;
-        // 5 states
-        case InterfaceApp::Cellular::BANNERS:         app.run(cellular::Banners()        ,opts);break;
-        case InterfaceApp::Cellular::GLISSERGY:       app.run(cellular::Glissergy()      ,opts);break;
-        case InterfaceApp::Cellular::SPIRALS:         app.run(cellular::Spirals()        ,opts);break;
-        case InterfaceApp::Cellular::TRANSERS:        app.run(cellular::Transers()       ,opts);break;
-        case InterfaceApp::Cellular::WANDERERS:       app.run(cellular::Wanderers()      ,opts);break;
-        // 6 states
-        case InterfaceApp::Cellular::CHENILLE:        app.run(cellular::Chenille()       ,opts);break;
-        case InterfaceApp::Cellular::FROZENSPIRALS:   app.run(cellular::FrozenSpirals()  ,opts);break;
-        case InterfaceApp::Cellular::LIVINGONTHEEDGE: app.run(cellular::LivingOnTheEdge(),opts);break;
-        case InterfaceApp::Cellular::PRAIRIEONFIRE:   app.run(cellular::PrairieOnFire()  ,opts);break;
-        case InterfaceApp::Cellular::RAKE:            app.run(cellular::Rake()           ,opts);break;
-        case InterfaceApp::Cellular::SNAKE:           app.run(cellular::Snake()          ,opts);break;
-        case InterfaceApp::Cellular::SOFTFREEZE:      app.run(cellular::SoftFreeze()     ,opts);break;
-        case InterfaceApp::Cellular::STICKS:          app.run(cellular::Sticks()         ,opts);break;
-        case InterfaceApp::Cellular::WORMS:           app.run(cellular::Worms()          ,opts);break;
-        // 7 states
-        case InterfaceApp::Cellular::GLISSERATI:      app.run(cellular::Glisserati()     ,opts);break;
-        // 8 states
-        case InterfaceApp::Cellular::BELZHAB:         app.run(cellular::BelZhab()        ,opts);break;
-        case InterfaceApp::Cellular::CIRCUITGENESIS:  app.run(cellular::CircuitGenesis() ,opts);break;
-        case InterfaceApp::Cellular::COOTIES:         app.run(cellular::Cooties()        ,opts);break;
-        case InterfaceApp::Cellular::FLAMINGSTARBOWS: app.run(cellular::FlamingStarbows(),opts);break;
-        case InterfaceApp::Cellular::LAVA:            app.run(cellular::Lava()           ,opts);break;
-        case InterfaceApp::Cellular::METEORGUNS:      app.run(cellular::MeteorGuns()     ,opts);break;
-        case InterfaceApp::Cellular::SWIRL:           app.run(cellular::Swirl()          ,opts);break;
-        // 9 states
-        case InterfaceApp::Cellular::BURST:           app.run(cellular::Burst()          ,opts);break;
-        case InterfaceApp::Cellular::BURST2:          app.run(cellular::Burst2()         ,opts);break;
-        // 16 states
-        case InterfaceApp::Cellular::XTASY:           app.run(cellular::Xtasy()          ,opts);break;
-        // 18 states
-        case InterfaceApp::Cellular::EBBANDFLOW:      app.run(cellular::EbbAndFlow()     ,opts);break;
-        case InterfaceApp::Cellular::EBBANDFLOW2:     app.run(cellular::EbbAndFlow2()    ,opts);break;
-        // 21 states
-        case InterfaceApp::Cellular::FIREWORKS:       app.run(cellular::Fireworks()      ,opts);break;
-        // 24 states
-        case InterfaceApp::Cellular::BLOOMERANG:      app.run(cellular::Bloomerang()     ,opts);break;
-        // 25 states
-        case InterfaceApp::Cellular::FADERS:          app.run(cellular::Faders()         ,opts);break;
-        case InterfaceApp::Cellular::NOVA:            app.run(cellular::Nova()           ,opts);break;
-        case InterfaceApp::Cellular::BOMBERS:         app.run(cellular::Bombers()        ,opts);break;
-        // 48 states
-        case InterfaceApp::Cellular::THRILLGRILL:     app.run(cellular::Faders()         ,opts);break;
+      if(cellular::is_ltl(iface.ruleBuffer) && run_ltl(app, iface.ruleBuffer, opts)) {
+        break;
+      } else if(ruletable::is_table(iface.ruleBuffer) && run_table(app, iface.ruleBuffer, opts)) {
+        break;
+      } else if(iface.ruleBuffer[0] != '\0') {
+        ca::RuleSpec rule;
+        std::string error;
+        if(cellular::resolve_rule(iface.ruleBuffer, rule, error)) {
+          run_rule(app, rule, opts);
+          break;
+        }
+        Logger::Warning("rule '%s': %s\n", iface.ruleBuffer, error.c_str());
+      }
+      if(iface.autOption >= 0 && iface.autOption < int(cellular::registry.size())) {
+        run_cellular(app, cellular::registry[iface.autOption], opts);
       }
       break;
       case InterfaceApp::AutomataType::PROBABILISTIC:
@@ -140,6 +358,19 @@ int main(int argc, char *argv[]) {
         case InterfaceApp::Probabilistic::ISING: app.run(probabilistic::Ising(iface.isingBeta), opts);break;
       }
       break;
+      case InterfaceApp::AutomataType::CONTINUOUS:
+      run_continuous(app, iface.autOption, opts);
+      break;
+      case InterfaceApp::AutomataType::VOLUME:
+      if(iface.autOption >= 0 && iface.autOption < int(volume::registry.size())) {
+        run_volume(app, volume::registry[iface.autOption].name, opts);
+      }
+      break;
+      case InterfaceApp::AutomataType::BLOCK:
+      if(iface.autOption >= 0 && iface.autOption < int(margolus::registry.size())) {
+        run_block(app, margolus::registry[iface.autOption].name, opts);
+      }
+      break;
     }
     shouldQuit = true;
   }
@@ -0,0 +1,15 @@
+#version 330 core
+
+// states in [0, 1]; linear filtering and mipmaps blend neighbouring cells
+uniform sampler2D grid;
+uniform uint no_states;
+
+in vec2 pos;
+
+out vec4 frag_color;
+
+void main(void) {
+  // the levels that frames and the period detector see
+  float val = round(clamp(texture(grid, pos).r, 0.0, 1.0) * float(no_states - 1u)) / float(no_states - 1u);
+  frag_color = vec4(val, val, val, 1.0);
+}